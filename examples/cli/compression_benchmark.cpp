@@ -0,0 +1,223 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "flight_forge_connector/compression.h"
+#include "flight_forge_connector/flight_forge_connector.h"
+#include "flight_forge_connector/game_mode_controller.h"
+
+using ueds_connector::CompressionOptions;
+
+// the game mode port of the simulator, asked for the API version of the server
+constexpr int DEFAULT_GAME_MODE_PORT = 8000;
+
+// RGB frame sizes from a thumbnail up to 1080p
+const std::vector<std::pair<int, int>> FRAME_SIZES = {{160, 120}, {320, 240}, {640, 480}, {1280, 720}, {1920, 1080}};
+
+/* FillCameraFrame() //{ */
+
+// smooth shading with sensor noise in the low bits, compresses about as well as a rendered scene
+void FillCameraFrame(std::vector<std::byte>& frame, int width, int height, std::minstd_rand& random) {
+  frame.resize(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      for (int channel = 0; channel < 3; channel++) {
+        const auto shade = (x * (channel + 1) / 7 + y / 3 + (x / 97 + y / 61) * 40) & 0xff;
+        const auto noise = (random() & 0x3) * ((x / 128 + y / 128) % 2);
+
+        frame[(static_cast<size_t>(y) * width + x) * 3 + channel] = static_cast<std::byte>((shade + noise) & 0xff);
+      }
+    }
+  }
+}
+
+//}
+
+/* MeasureCodec() //{ */
+
+// MB/s of the original data through the compression and the decompression, and the compressed size as a fraction of the original
+void MeasureCodec(const std::vector<std::byte>& frame, int acceleration, double& compress_mbps, double& decompress_mbps, double& ratio) {
+
+  std::vector<std::byte> compressed(ueds_connector::Lz4CompressBound(frame.size()));
+  std::vector<std::byte> decompressed(frame.size());
+
+  const auto   repetitions = std::max<size_t>(3, (64u << 20) / frame.size());
+  size_t       size        = 0;
+  const double megabytes   = static_cast<double>(frame.size() * repetitions) / (1 << 20);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repetitions; i++) {
+    size = ueds_connector::Lz4Compress(frame, compressed, acceleration);
+  }
+  compress_mbps = megabytes / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool valid = true;
+  start      = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repetitions; i++) {
+    valid = ueds_connector::Lz4Decompress(std::span<const std::byte>(compressed).first(size), decompressed) && valid;
+  }
+  decompress_mbps = megabytes / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ratio = static_cast<double>(size) / frame.size();
+
+  if (!valid || decompressed != frame) {
+    std::cerr << "Decompressed frame does not match the original" << std::endl;
+  }
+}
+
+//}
+
+/* CheckExactBuffers() //{ */
+
+// compresses blocks of long literal runs and long matches into heap buffers of every size up to the bound, each one allocated to the exact
+// size so that a write past it shows up under the address sanitizer, returns false if a block does not fit the bound or does not round-trip
+bool CheckExactBuffers(std::minstd_rand& random) {
+
+  std::vector<std::byte> block;
+
+  for (const size_t literals : {0, 14, 15, 16, 269, 270, 271, 600}) {
+    for (const size_t match : {0, 18, 19, 20, 273, 274, 275, 600}) {
+
+      // random literals, then a run of zeros matching itself, then random literals again
+      block.clear();
+      for (size_t i = 0; i < literals; i++) {
+        block.push_back(static_cast<std::byte>(random()));
+      }
+      block.insert(block.end(), match, std::byte{0});
+      for (size_t i = 0; i < 20; i++) {
+        block.push_back(static_cast<std::byte>(random()));
+      }
+
+      const auto bound = ueds_connector::Lz4CompressBound(block.size());
+
+      for (size_t capacity = 0; capacity <= bound; capacity++) {
+
+        auto       compressed = std::make_unique<std::byte[]>(capacity);
+        const auto size       = ueds_connector::Lz4Compress(block, std::span<std::byte>(compressed.get(), capacity));
+
+        if (size == 0) {
+          if (capacity == bound) {
+            std::cerr << "Block of " << block.size() << " bytes does not fit its bound of " << bound << " bytes" << std::endl;
+            return false;
+          }
+          continue;
+        }
+
+        std::vector<std::byte> decompressed(block.size());
+
+        if (size > capacity || !ueds_connector::Lz4Decompress(std::span<const std::byte>(compressed.get(), size), decompressed) ||
+            decompressed != block) {
+          std::cerr << "Block of " << block.size() << " bytes compressed into " << capacity << " bytes does not round-trip" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+//}
+
+/* MeasureCamera() //{ */
+
+// MB/s of the camera images received from the drone server, with the given compression of the connection
+double MeasureCamera(const std::string& address, int port, const std::pair<int, int>& api_version, const CompressionOptions& options, int frames) {
+
+  ueds_connector::UedsConnector drone(address, port);
+
+  if (!drone.ConnectSimple() || !drone.NegotiateFrameMode(api_version, ueds_connector::FrameMode::LENGTH_PREFIXED) ||
+      !drone.NegotiateCompression(api_version, options)) {
+    std::cerr << "Cannot connect to " << address << ":" << port << " with the requested compression" << std::endl;
+    return 0.0;
+  }
+
+  std::vector<unsigned char> image;
+  double                     stamp = 0.0;
+  size_t                     bytes = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; i++) {
+    if (!drone.GetRgbCameraData(image, stamp)) {
+      std::cerr << "Fail: get camera data" << std::endl;
+      return 0.0;
+    }
+    bytes += image.size();
+  }
+
+  return static_cast<double>(bytes) / (1 << 20) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//}
+
+int main(int argc, char* argv[]) {
+
+  if (argc > 1 && (std::string(argv[1]) == "--help" || argc > 5)) {
+    std::cout << "Usage: compression_benchmark [PORT [ADDRESS [FRAMES [GAME_MODE_PORT]]]]" << std::endl;
+    std::cout << "  measures the codec on synthetic RGB frames, with PORT also the camera images of the drone server there, the API version of"
+              << " the server is asked from GAME_MODE_PORT (default " << DEFAULT_GAME_MODE_PORT << ")" << std::endl;
+    return 0;
+  }
+
+  std::minstd_rand       random(42);
+  std::vector<std::byte> frame;
+
+  if (!CheckExactBuffers(random)) {
+    return 1;
+  }
+
+  std::printf("%-10s %12s %6s %14s %16s\n", "frame", "bytes", "accel", "compress MB/s", "decompress MB/s");
+
+  for (const auto& [width, height] : FRAME_SIZES) {
+    FillCameraFrame(frame, width, height, random);
+
+    for (const auto acceleration : {1, 4}) {
+      double compress_mbps = 0, decompress_mbps = 0, ratio = 0;
+      MeasureCodec(frame, acceleration, compress_mbps, decompress_mbps, ratio);
+
+      const auto name = std::to_string(width) + "x" + std::to_string(height);
+      std::printf("%-10s %12zu %6d %14.0f %16.0f   ratio %.3f\n", name.c_str(), frame.size(), acceleration, compress_mbps, decompress_mbps, ratio);
+    }
+  }
+
+  if (argc < 2) {
+    return 0;
+  }
+
+  const int         port    = std::stoi(argv[1]);
+  const std::string address = argc > 2 ? argv[2] : LOCALHOST;
+  const int         frames  = argc > 3 ? std::stoi(argv[3]) : 200;
+
+  const int         game_mode_port = argc > 4 ? std::stoi(argv[4]) : DEFAULT_GAME_MODE_PORT;
+
+  ueds_connector::GameModeController game_mode(address, static_cast<uint16_t>(game_mode_port));
+
+  if (!game_mode.ConnectSimple()) {
+    std::cerr << "Cannot connect to the game mode on " << address << ":" << game_mode_port << std::endl;
+    return 1;
+  }
+
+  const auto [version_success, api_version] = game_mode.GetApiVersion();
+
+  if (!version_success) {
+    std::cerr << "The game mode does not answer" << std::endl;
+    return 1;
+  }
+
+  CompressionOptions compressed;
+  compressed.enabled = true;
+
+  const auto raw_mbps        = MeasureCamera(address, port, api_version, CompressionOptions{}, frames);
+  const auto compressed_mbps = MeasureCamera(address, port, api_version, compressed, frames);
+
+  std::printf("camera images from %s:%d: %.0f MB/s raw, %.0f MB/s compressed\n", address.c_str(), port, raw_mbps, compressed_mbps);
+
+  return 0;
+}
@@ -83,9 +83,10 @@ int main() {
   auto [res, version] = gameModeController->GetApiVersion();
   auto [api_version_major, api_version_minor] = version;
 
-  if (!res || api_version_major != API_VERSION_MAJOR || api_version_minor != API_VERSION_MINOR) {
+  // the newer servers stay compatible, the features they add are checked separately
+  if (!res || api_version_major != API_VERSION_MAJOR || api_version_minor < API_VERSION_MINOR) {
 
-    std::cout << "[FlighForge]: the API versions don't match! (CONNECTOR side 'v" << API_VERSION_MAJOR << "." << API_VERSION_MINOR << "' != UNREAL side 'v" << api_version_major << "." << api_version_minor << "')" << std::endl;
+    std::cout << "[FlighForge]: the API versions don't match! (CONNECTOR side 'v" << API_VERSION_MAJOR << "." << API_VERSION_MINOR << "' > UNREAL side 'v" << api_version_major << "." << api_version_minor << "')" << std::endl;
     std::cout << "[FlighForge]:" << std::endl;
     std::cout << "[FlighForge]: Solution:"<< std::endl;
     std::cout << "[FlighForge]:           1. make sure the mrs_flight_forge_connector package is up to date"<< std::endl;
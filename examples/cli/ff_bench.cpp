@@ -0,0 +1,760 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flight_forge_connector/coroutine_drone.h"
+#include "flight_forge_connector/event_loop.h"
+#include "flight_forge_connector/flight_forge_connector.h"
+#include "flight_forge_connector/game_mode_controller.h"
+
+using ueds_connector::CoroutineDrone;
+using ueds_connector::EventLoop;
+using ueds_connector::FrameMode;
+using ueds_connector::GameModeController;
+using ueds_connector::LidarCloud;
+using ueds_connector::Task;
+using ueds_connector::UedsConnector;
+
+using Clock = std::chrono::steady_clock;
+
+// the game mode port of the simulator
+constexpr int DEFAULT_GAME_MODE_PORT = 8000;
+
+// requests of a thread before the measurement, they fill the buffers and the caches of both sides
+constexpr int WARMUP_REQUESTS = 5;
+
+const std::vector<std::string> MESSAGES = {"location",        "rangefinder", "rgb",       "rgb_seg",         "stereo", "lidar",
+                                           "lidar_seg",       "lidar_int",   "lidar_distances", "lidar_quantized"};
+
+struct BenchOptions
+{
+  std::string              address        = LOCALHOST;
+  int                      game_mode_port = DEFAULT_GAME_MODE_PORT;
+  std::vector<std::string> messages       = {"location", "rgb", "lidar"};
+  std::vector<std::string> resolutions    = {"640x480"};
+  std::vector<std::string> beams          = {"3600x1"};
+  std::vector<int>         drones         = {1};
+  std::vector<int>         threads        = {1};
+  double                   duration       = 2.0;
+  FrameMode                frame_mode     = FrameMode::LENGTH_PREFIXED;
+  std::string              format         = "csv";
+  std::string              output;
+};
+
+// one point of the sweep, the size is the camera resolution or the lidar beam grid (columns x rows) of the message
+struct BenchCase
+{
+  std::string message;
+  int         size_x  = 0;
+  int         size_y  = 0;
+  int         drones  = 1;
+  int         threads = 1;
+};
+
+// measurements of one client thread
+struct ThreadResult
+{
+  std::vector<double> latencies;
+  size_t              failures = 0;
+  size_t              bytes    = 0;
+  bool                ready    = true;
+};
+
+struct BenchResult
+{
+  BenchCase case_;
+  size_t    requests = 0;
+  size_t    failures = 0;
+  double    seconds  = 0.0;
+  // sensor data delivered to the caller, the image bytes or the arrays of the lidar cloud
+  size_t bytes = 0;
+  // microseconds
+  double p50  = 0.0;
+  double p99  = 0.0;
+  double p999 = 0.0;
+};
+
+/* SplitList() //{ */
+
+std::vector<std::string> SplitList(const std::string& list) {
+
+  std::vector<std::string> items;
+  std::stringstream        stream(list);
+  std::string              item;
+
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+
+  return items;
+}
+
+//}
+
+/* ParseSize() //{ */
+
+// "640x480" of the resolutions, "1024x64" of the beam grids
+bool ParseSize(const std::string& size, int& x, int& y) {
+
+  const auto delimiter = size.find('x');
+  if (delimiter == std::string::npos) {
+    return false;
+  }
+
+  x = std::stoi(size.substr(0, delimiter));
+  y = std::stoi(size.substr(delimiter + 1));
+  return x > 0 && y > 0;
+}
+
+//}
+
+/* IsCamera() //{ */
+
+bool IsCamera(const std::string& message) {
+  return message == "rgb" || message == "rgb_seg" || message == "stereo";
+}
+
+//}
+
+/* IsLidar() //{ */
+
+bool IsLidar(const std::string& message) {
+  return message.rfind("lidar", 0) == 0;
+}
+
+//}
+
+/* ConfigureDrone() //{ */
+
+// sets the resolution or the beam grid of the case, the other sensors keep their configs
+bool ConfigureDrone(UedsConnector& drone, const BenchCase& bench_case) {
+
+  if (IsCamera(bench_case.message)) {
+    auto [rgb_success, rgb_config]       = drone.GetRgbCameraConfig();
+    auto [stereo_success, stereo_config] = drone.GetStereoCameraConfig();
+
+    if (!rgb_success || !stereo_success) {
+      return false;
+    }
+
+    rgb_config.width_     = bench_case.size_x;
+    rgb_config.height_    = bench_case.size_y;
+    stereo_config.width_  = bench_case.size_x;
+    stereo_config.height_ = bench_case.size_y;
+
+    return drone.SetRgbCameraConfig(rgb_config) && drone.SetStereoCameraConfig(stereo_config);
+  }
+
+  if (IsLidar(bench_case.message)) {
+    auto [success, config] = drone.GetLidarConfig();
+
+    if (!success) {
+      return false;
+    }
+
+    config.Enable       = true;
+    config.BeamHorRays  = bench_case.size_x;
+    config.BeamVertRays = bench_case.size_y;
+
+    return drone.SetLidarConfig(config);
+  }
+
+  return true;
+}
+
+//}
+
+/* RequestOnce() //{ */
+
+// one request of the message, adds the size of the received sensor data to bytes
+bool RequestOnce(UedsConnector& drone, const std::string& message, std::vector<unsigned char>& image, std::vector<unsigned char>& image_right,
+                 LidarCloud& cloud, size_t& bytes) {
+
+  double stamp = 0.0;
+  bool   success;
+
+  if (message == "location") {
+    success = drone.GetLocation().first;
+    bytes += success ? 3 * sizeof(double) : 0;
+    return success;
+  }
+
+  if (message == "rangefinder") {
+    success = std::get<0>(drone.GetRangefinderData());
+    bytes += success ? sizeof(double) : 0;
+    return success;
+  }
+
+  if (message == "rgb" || message == "rgb_seg") {
+    success = message == "rgb" ? drone.GetRgbCameraData(image, stamp) : drone.GetRgbSegmented(image, stamp);
+    bytes += success ? image.size() : 0;
+    return success;
+  }
+
+  if (message == "stereo") {
+    success = drone.GetStereoCameraData(image, image_right, stamp);
+    bytes += success ? image.size() + image_right.size() : 0;
+    return success;
+  }
+
+  // the distance-only and quantized scans are switched on per connection, they are requested as the labeled ones
+  success = message == "lidar"       ? drone.GetLidarData(cloud)
+            : message == "lidar_int" ? drone.GetLidarIntData(cloud)
+                                     : drone.GetLidarSegData(cloud);
+
+  const auto extra = message == "lidar" ? 0 : sizeof(int);
+  bytes += success ? cloud.size() * (4 * sizeof(double) + extra) : 0;
+  return success;
+}
+
+//}
+
+/* RequestOnceAsync() //{ */
+
+// RequestOnce() of a drone served by an event loop
+Task<bool> RequestOnceAsync(CoroutineDrone& drone, const std::string& message, std::vector<unsigned char>& image,
+                            std::vector<unsigned char>& image_right, LidarCloud& cloud, size_t& bytes) {
+
+  if (message == "location") {
+    const auto location = co_await drone.GetLocationAsync();
+    bytes += location ? 3 * sizeof(double) : 0;
+    co_return static_cast<bool>(location);
+  }
+
+  if (message == "rangefinder") {
+    const auto range = co_await drone.GetRangefinderDataAsync();
+    bytes += range ? sizeof(double) : 0;
+    co_return static_cast<bool>(range);
+  }
+
+  if (message == "rgb" || message == "rgb_seg") {
+    const auto stamp = message == "rgb" ? co_await drone.GetRgbCameraDataAsync(image) : co_await drone.GetRgbSegmentedAsync(image);
+    bytes += stamp ? image.size() : 0;
+    co_return static_cast<bool>(stamp);
+  }
+
+  if (message == "stereo") {
+    const auto stamp = co_await drone.GetStereoCameraDataAsync(image, image_right);
+    bytes += stamp ? image.size() + image_right.size() : 0;
+    co_return static_cast<bool>(stamp);
+  }
+
+  ueds_connector::AwaitResult<void> scan;
+
+  if (message == "lidar") {
+    scan = co_await drone.GetLidarDataAsync(cloud);
+  } else if (message == "lidar_int") {
+    scan = co_await drone.GetLidarIntDataAsync(cloud);
+  } else {
+    scan = co_await drone.GetLidarSegDataAsync(cloud);
+  }
+
+  const auto extra = message == "lidar" ? 0 : sizeof(int);
+  bytes += scan ? cloud.size() * (4 * sizeof(double) + extra) : 0;
+  co_return static_cast<bool>(scan);
+}
+
+//}
+
+/* RequestLoop() //{ */
+
+// the requests of one drone served by an event loop, the warmup ones for running nullptr, otherwise measured until running turns false
+Task<void> RequestLoop(CoroutineDrone& drone, const std::string& message, const std::atomic<bool>* running, ThreadResult& result) {
+
+  std::vector<unsigned char> image;
+  std::vector<unsigned char> image_right;
+  LidarCloud                 cloud;
+
+  if (running == nullptr) {
+    size_t warmup_bytes = 0;
+
+    for (int i = 0; i < WARMUP_REQUESTS; i++) {
+      result.ready = co_await RequestOnceAsync(drone, message, image, image_right, cloud, warmup_bytes) && result.ready;
+    }
+
+    co_return;
+  }
+
+  while (*running) {
+    const auto start   = Clock::now();
+    const auto success = co_await RequestOnceAsync(drone, message, image, image_right, cloud, result.bytes);
+
+    if (success) {
+      result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    } else {
+      result.failures++;
+    }
+  }
+}
+
+//}
+
+/* Percentile() //{ */
+
+// nearest rank of the sorted latencies
+double Percentile(const std::vector<double>& sorted, double fraction) {
+
+  if (sorted.empty()) {
+    return 0.0;
+  }
+
+  const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+//}
+
+/* MeasureThreads() //{ */
+
+// runs body(thread, start_line, running) on the threads, the measurement starts once all of them arrive at the start line after their warmup
+double MeasureThreads(size_t count, double duration, const std::function<void(size_t, std::latch&, const std::atomic<bool>&)>& body) {
+
+  std::latch               start_line(static_cast<std::ptrdiff_t>(count) + 1);
+  std::atomic<bool>        running = true;
+  std::vector<std::thread> threads;
+
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([&body, &start_line, &running, i] { body(i, start_line, running); });
+  }
+
+  start_line.arrive_and_wait();
+
+  const auto start = Clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  running = false;
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//}
+
+/* ConfigureDrones() //{ */
+
+bool ConfigureDrones(const BenchOptions& options, const std::vector<int>& ports, const BenchCase& bench_case) {
+
+  for (const auto port : ports) {
+
+    UedsConnector drone(options.address, static_cast<uint16_t>(port));
+
+    if (!drone.ConnectSimple() || !ConfigureDrone(drone, bench_case)) {
+      std::cerr << "Cannot configure the drone on port " << port << " for " << bench_case.message << " of " << bench_case.size_x << "x"
+                << bench_case.size_y << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//}
+
+/* RunBlocking() //{ */
+
+// the threads are spread over the drones, each one with its own blocking connection
+bool RunBlocking(const BenchOptions& options, const std::pair<int, int>& api_version, const std::vector<int>& ports, const BenchCase& bench_case,
+                 std::vector<ThreadResult>& results, double& seconds) {
+
+  std::vector<std::unique_ptr<UedsConnector>> drones(static_cast<size_t>(bench_case.threads));
+
+  for (size_t i = 0; i < drones.size(); i++) {
+
+    auto& drone = drones[i];
+    drone       = std::make_unique<UedsConnector>(options.address, static_cast<uint16_t>(ports[i % ports.size()]));
+
+    if (!drone->ConnectSimple() || !drone->NegotiateFrameMode(api_version, options.frame_mode)) {
+      std::cerr << "Cannot connect to the drone on port " << ports[i % ports.size()] << std::endl;
+      return false;
+    }
+
+    if (bench_case.message == "lidar_distances" && !drone->EnableLidarDistanceOnly(api_version)) {
+      std::cerr << "The server does not send the distance-only lidar scans" << std::endl;
+      return false;
+    }
+
+    if (bench_case.message == "lidar_quantized" && !drone->EnableLidarQuantization(api_version)) {
+      std::cerr << "The server does not send the quantized lidar scans" << std::endl;
+      return false;
+    }
+  }
+
+  results.assign(drones.size(), ThreadResult{});
+
+  seconds = MeasureThreads(drones.size(), options.duration, [&](size_t thread, std::latch& start_line, const std::atomic<bool>& running) {
+    auto&                      drone  = *drones[thread];
+    auto&                      result = results[thread];
+    std::vector<unsigned char> image;
+    std::vector<unsigned char> image_right;
+    LidarCloud                 cloud;
+    size_t                     warmup_bytes = 0;
+
+    for (int i = 0; i < WARMUP_REQUESTS; i++) {
+      result.ready = RequestOnce(drone, bench_case.message, image, image_right, cloud, warmup_bytes) && result.ready;
+    }
+
+    start_line.arrive_and_wait();
+
+    while (running) {
+      const auto start   = Clock::now();
+      const auto success = RequestOnce(drone, bench_case.message, image, image_right, cloud, result.bytes);
+
+      if (success) {
+        result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+      } else {
+        result.failures++;
+      }
+    }
+  });
+
+  return true;
+}
+
+//}
+
+/* RunEventLoops() //{ */
+
+// fewer threads than drones, every thread serves its drones by an event loop with one request of each drone in flight
+bool RunEventLoops(const BenchOptions& options, const std::vector<int>& ports, const BenchCase& bench_case, std::vector<ThreadResult>& results,
+                   double& seconds) {
+
+  std::vector<std::unique_ptr<EventLoop>>                   loops;
+  std::vector<std::vector<std::unique_ptr<CoroutineDrone>>> drones(static_cast<size_t>(bench_case.threads));
+
+  for (int i = 0; i < bench_case.threads; i++) {
+    loops.push_back(std::make_unique<EventLoop>());
+  }
+
+  for (size_t i = 0; i < ports.size(); i++) {
+
+    const auto thread = i % loops.size();
+    auto       drone  = std::make_unique<CoroutineDrone>(*loops[thread], options.address, static_cast<uint16_t>(ports[i]));
+
+    if (!drone->Connect(options.frame_mode)) {
+      std::cerr << "Cannot connect to the drone on port " << ports[i] << std::endl;
+      return false;
+    }
+
+    drones[thread].push_back(std::move(drone));
+  }
+
+  results.assign(loops.size(), ThreadResult{});
+
+  seconds = MeasureThreads(loops.size(), options.duration, [&](size_t thread, std::latch& start_line, const std::atomic<bool>& running) {
+    auto& loop   = *loops[thread];
+    auto& result = results[thread];
+
+    for (auto& drone : drones[thread]) {
+      loop.Spawn(RequestLoop(*drone, bench_case.message, nullptr, result));
+    }
+    loop.Run();
+
+    start_line.arrive_and_wait();
+
+    for (auto& drone : drones[thread]) {
+      loop.Spawn(RequestLoop(*drone, bench_case.message, &running, result));
+    }
+    loop.Run();
+  });
+
+  return true;
+}
+
+//}
+
+/* RunCase() //{ */
+
+bool RunCase(const BenchOptions& options, const std::pair<int, int>& api_version, const std::vector<int>& ports, const BenchCase& bench_case,
+             BenchResult& result) {
+
+  if (!ConfigureDrones(options, ports, bench_case)) {
+    return false;
+  }
+
+  std::vector<ThreadResult> threads;
+
+  if (bench_case.threads < bench_case.drones) {
+    if (!RunEventLoops(options, ports, bench_case, threads, result.seconds)) {
+      return false;
+    }
+  } else if (!RunBlocking(options, api_version, ports, bench_case, threads, result.seconds)) {
+    return false;
+  }
+
+  result.case_ = bench_case;
+
+  std::vector<double> latencies;
+
+  for (auto& thread : threads) {
+    if (!thread.ready) {
+      std::cerr << "The warmup requests of " << bench_case.message << " failed" << std::endl;
+    }
+    latencies.insert(latencies.end(), thread.latencies.begin(), thread.latencies.end());
+    result.failures += thread.failures;
+    result.bytes += thread.bytes;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  result.requests = latencies.size();
+  result.p50      = Percentile(latencies, 0.5);
+  result.p99      = Percentile(latencies, 0.99);
+  result.p999     = Percentile(latencies, 0.999);
+
+  return true;
+}
+
+//}
+
+/* WriteResults() //{ */
+
+void WriteResults(std::ostream& out, const std::string& format, const std::vector<BenchResult>& results) {
+
+  if (format == "json") {
+    out << "[" << std::endl;
+  } else {
+    out << "message,size_x,size_y,drones,threads,requests,failures,seconds,requests_per_s,bytes_per_s,p50_us,p99_us,p999_us" << std::endl;
+  }
+
+  for (size_t i = 0; i < results.size(); i++) {
+
+    const auto& result     = results[i];
+    const auto& bench_case = result.case_;
+    const auto  throughput = static_cast<double>(result.requests) / result.seconds;
+    const auto  bandwidth  = static_cast<double>(result.bytes) / result.seconds;
+
+    char line[512];
+
+    if (format == "json") {
+      std::snprintf(line, sizeof(line),
+                    "  {\"message\": \"%s\", \"size_x\": %d, \"size_y\": %d, \"drones\": %d, \"threads\": %d, \"requests\": %zu, \"failures\": %zu, "
+                    "\"seconds\": %.3f, \"requests_per_s\": %.1f, \"bytes_per_s\": %.0f, \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f}%s",
+                    bench_case.message.c_str(), bench_case.size_x, bench_case.size_y, bench_case.drones, bench_case.threads, result.requests,
+                    result.failures, result.seconds, throughput, bandwidth, result.p50, result.p99, result.p999, i + 1 < results.size() ? "," : "");
+    } else {
+      std::snprintf(line, sizeof(line), "%s,%d,%d,%d,%d,%zu,%zu,%.3f,%.1f,%.0f,%.1f,%.1f,%.1f", bench_case.message.c_str(), bench_case.size_x,
+                    bench_case.size_y, bench_case.drones, bench_case.threads, result.requests, result.failures, result.seconds, throughput, bandwidth,
+                    result.p50, result.p99, result.p999);
+    }
+
+    out << line << std::endl;
+  }
+
+  if (format == "json") {
+    out << "]" << std::endl;
+  }
+}
+
+//}
+
+/* PrintUsage() //{ */
+
+void PrintUsage() {
+  std::cout << "Usage: ff_bench [--address ADDRESS] [--game-mode-port PORT] [--messages LIST] [--resolutions LIST] [--beams LIST] [--drones LIST]"
+            << " [--threads LIST] [--duration SECONDS] [--frame-mode sentinel|length|sequenced] [--format csv|json] [--output FILE]" << std::endl;
+  std::cout << "  sweeps every combination of the comma separated lists against the simulator or flight_forge_mock_server" << std::endl;
+  std::cout << "  messages: ";
+  for (const auto& message : MESSAGES) {
+    std::cout << message << " ";
+  }
+  std::cout << std::endl;
+  std::cout << "  resolutions (WIDTHxHEIGHT) apply to the camera messages, beams (HORIZONTALxVERTICAL rays) to the lidar ones" << std::endl;
+  std::cout << "  the drones missing in the simulator are spawned and removed at the end, the threads are spread over the drones, with fewer"
+            << " threads than drones every thread serves its drones by an event loop (length or sequenced framing, no lidar_distances and"
+            << " lidar_quantized)" << std::endl;
+}
+
+//}
+
+/* ParseIntList() //{ */
+
+std::vector<int> ParseIntList(const std::string& list) {
+
+  std::vector<int> values;
+
+  for (const auto& item : SplitList(list)) {
+    values.push_back(std::stoi(item));
+  }
+
+  return values;
+}
+
+//}
+
+int main(int argc, char* argv[]) {
+
+  BenchOptions options;
+
+  for (int i = 1; i < argc; i++) {
+
+    const std::string argument = argv[i];
+
+    if (argument == "--help" || i + 1 >= argc) {
+      PrintUsage();
+      return argument == "--help" ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+
+    if (argument == "--address") {
+      options.address = value;
+    } else if (argument == "--game-mode-port") {
+      options.game_mode_port = std::stoi(value);
+    } else if (argument == "--messages") {
+      options.messages = SplitList(value);
+    } else if (argument == "--resolutions") {
+      options.resolutions = SplitList(value);
+    } else if (argument == "--beams") {
+      options.beams = SplitList(value);
+    } else if (argument == "--drones") {
+      options.drones = ParseIntList(value);
+    } else if (argument == "--threads") {
+      options.threads = ParseIntList(value);
+    } else if (argument == "--duration") {
+      options.duration = std::stod(value);
+    } else if (argument == "--frame-mode" && (value == "sentinel" || value == "length" || value == "sequenced")) {
+      options.frame_mode = value == "sentinel" ? FrameMode::SENTINEL : value == "length" ? FrameMode::LENGTH_PREFIXED : FrameMode::SEQUENCED;
+    } else if (argument == "--format" && (value == "csv" || value == "json")) {
+      options.format = value;
+    } else if (argument == "--output") {
+      options.output = value;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  for (const auto& message : options.messages) {
+    if (std::find(MESSAGES.begin(), MESSAGES.end(), message) == MESSAGES.end()) {
+      std::cerr << "Unknown message " << message << std::endl;
+      return 1;
+    }
+  }
+
+  // the sweep, the sizes only multiply the messages they apply to
+  std::vector<BenchCase> cases;
+
+  for (const auto drones : options.drones) {
+    for (const auto threads : options.threads) {
+
+      if (drones < 1 || threads < 1) {
+        std::cerr << "Skipping " << drones << " drones with " << threads << " threads" << std::endl;
+        continue;
+      }
+
+      for (const auto& message : options.messages) {
+
+        // the event loop serves the framed connections only and switches no lidar variants on
+        if (threads < drones && (options.frame_mode == FrameMode::SENTINEL || message == "lidar_distances" || message == "lidar_quantized")) {
+          std::cerr << "Skipping " << message << " of " << drones << " drones with " << threads << " threads, not served by the event loop"
+                    << std::endl;
+          continue;
+        }
+
+        const auto& sizes = IsCamera(message) ? options.resolutions : IsLidar(message) ? options.beams : std::vector<std::string>{"0x0"};
+
+        for (const auto& size : sizes) {
+          BenchCase bench_case{message, 0, 0, drones, threads};
+
+          if (size != "0x0" && !ParseSize(size, bench_case.size_x, bench_case.size_y)) {
+            std::cerr << "Invalid size " << size << std::endl;
+            return 1;
+          }
+
+          cases.push_back(bench_case);
+        }
+      }
+    }
+  }
+
+  if (cases.empty()) {
+    std::cerr << "Nothing to measure" << std::endl;
+    return 1;
+  }
+
+  GameModeController game_mode(options.address, static_cast<uint16_t>(options.game_mode_port));
+
+  if (!game_mode.ConnectSimple()) {
+    std::cerr << "Cannot connect to the game mode on " << options.address << ":" << options.game_mode_port << std::endl;
+    return 1;
+  }
+
+  const auto [version_success, api_version] = game_mode.GetApiVersion();
+  auto [drones_success, ports]              = game_mode.GetDrones();
+
+  if (!version_success || !drones_success) {
+    std::cerr << "The game mode does not answer" << std::endl;
+    return 1;
+  }
+
+  std::cerr << "API version " << api_version.first << "." << api_version.second << ", " << ports.size() << " drones" << std::endl;
+
+  // spawned for the largest drone count, removed at the end
+  const auto       needed = static_cast<size_t>(*std::max_element(options.drones.begin(), options.drones.end()));
+  std::vector<int> spawned;
+
+  while (ports.size() < needed) {
+    const auto [success, port] = game_mode.SpawnDrone();
+
+    if (!success) {
+      std::cerr << "Cannot spawn a drone" << std::endl;
+      break;
+    }
+
+    ports.push_back(port);
+    spawned.push_back(port);
+  }
+
+  std::vector<BenchResult> results;
+
+  for (const auto& bench_case : cases) {
+
+    if (static_cast<size_t>(bench_case.drones) > ports.size()) {
+      continue;
+    }
+
+    const std::vector<int> case_ports(ports.begin(), ports.begin() + bench_case.drones);
+
+    BenchResult result;
+    if (!RunCase(options, api_version, case_ports, bench_case, result)) {
+      continue;
+    }
+
+    std::cerr << bench_case.message << " " << bench_case.size_x << "x" << bench_case.size_y << ", " << bench_case.drones << " drones, "
+              << bench_case.threads << " threads: " << static_cast<double>(result.requests) / result.seconds << " requests/s, p99 " << result.p99
+              << " us" << std::endl;
+
+    results.push_back(result);
+  }
+
+  for (const auto port : spawned) {
+    game_mode.RemoveDrone(port);
+  }
+
+  if (options.output.empty()) {
+    WriteResults(std::cout, options.format, results);
+  } else {
+    std::ofstream file(options.output);
+    WriteResults(file, options.format, results);
+  }
+
+  return results.size() == cases.size() ? 0 : 1;
+}
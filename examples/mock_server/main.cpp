@@ -0,0 +1,147 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "mock_server.h"
+
+#include <flight_forge_connector/socket_client.h>
+
+// the game mode port of the simulator
+constexpr int DEFAULT_GAME_MODE_PORT = 8000;
+
+ueds_connector::MockServer* mockServer = nullptr;
+
+void interruptHandler(int) {
+  if (mockServer != nullptr) {
+    mockServer->RequestStop();
+  }
+}
+
+void printUsage() {
+  std::cout << "Usage: flight_forge_mock_server [--address ADDRESS] [--port PORT] [--game-mode-port PORT] [--width WIDTH] [--height HEIGHT]"
+            << " [--lidar-horizontal-rays RAYS] [--lidar-vertical-rays RAYS] [--stream-frequency HZ] [--fps FPS] [--response-delay MS]"
+            << " [--camera-delay MS] [--lidar-delay MS] [--delay-jitter MS] [--replay CAPTURE] [--replay-port PORT] [--replay-timing 0|1]"
+            << std::endl;
+  std::cout << "  ADDRESS is " << LOCALHOST << " (default) or " << UNIX_SOCKET_SCHEME << "/path/to/socket, " << UNIX_SOCKET_PORT_PLACEHOLDER
+            << " in the path is replaced by PORT" << std::endl;
+  std::cout << "  the first drone listens on --port (default " << DEFAULT_PORT << "), the spawned ones on the next free ports, --game-mode-port 0"
+            << " serves the first drone only (default " << DEFAULT_GAME_MODE_PORT << ")" << std::endl;
+  std::cout << "  the camera and lidar data wait for their delay on top of the response delay, every delay gets up to the jitter more" << std::endl;
+  std::cout << "  --replay answers the drone requests by the responses of a capture (see SocketClient::SetRecorder()) recorded on --replay-port"
+            << " (default the port with the most response data) in their order per message type, --replay-timing 1 also waits their latency"
+            << std::endl;
+}
+
+std::chrono::microseconds parseMilliseconds(const std::string& value) {
+  return std::chrono::microseconds(static_cast<int64_t>(std::stod(value) * 1000.0));
+}
+
+int main(int argc, char** argv) {
+
+  std::string                       address        = LOCALHOST;
+  int                               port           = DEFAULT_PORT;
+  int                               game_mode_port = DEFAULT_GAME_MODE_PORT;
+  std::string                       replay_path;
+  int                               replay_port   = 0;
+  bool                              replay_timing = false;
+  ueds_connector::MockServerOptions options;
+
+  for (int i = 1; i < argc; i++) {
+
+    const std::string argument = argv[i];
+
+    if (argument == "--help" || i + 1 >= argc) {
+      printUsage();
+      return argument == "--help" ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+
+    if (argument == "--address") {
+      address = value;
+    } else if (argument == "--port") {
+      port = std::stoi(value);
+    } else if (argument == "--game-mode-port") {
+      game_mode_port = std::stoi(value);
+    } else if (argument == "--width") {
+      options.image_width = std::stoi(value);
+    } else if (argument == "--height") {
+      options.image_height = std::stoi(value);
+    } else if (argument == "--lidar-horizontal-rays") {
+      options.lidar_horizontal_rays = std::stoi(value);
+    } else if (argument == "--lidar-vertical-rays") {
+      options.lidar_vertical_rays = std::stoi(value);
+    } else if (argument == "--stream-frequency") {
+      options.stream_frequency = std::stod(value);
+    } else if (argument == "--fps") {
+      options.fps = std::stof(value);
+    } else if (argument == "--response-delay") {
+      options.response_delay = parseMilliseconds(value);
+    } else if (argument == "--camera-delay") {
+      options.camera_delay = parseMilliseconds(value);
+    } else if (argument == "--lidar-delay") {
+      options.lidar_delay = parseMilliseconds(value);
+    } else if (argument == "--delay-jitter") {
+      options.delay_jitter = parseMilliseconds(value);
+    } else if (argument == "--replay") {
+      replay_path = value;
+    } else if (argument == "--replay-port") {
+      replay_port = std::stoi(value);
+    } else if (argument == "--replay-timing") {
+      replay_timing = std::stoi(value) != 0;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (!replay_path.empty()) {
+    auto replay = std::make_shared<ueds_connector::MockReplay>();
+
+    if (!replay->Load(replay_path, static_cast<uint16_t>(replay_port))) {
+      std::cerr << "Failed to load the responses of port " << replay_port << " from the capture " << replay_path << std::endl;
+      return 1;
+    }
+
+    replay->timing = replay_timing;
+    options.replay = replay;
+  }
+
+  // the game mode serves the drones on their own threads, without it the only drone accepts on this one
+  ueds_connector::MockServer server(options, game_mode_port > 0);
+
+  const auto listen_port = game_mode_port > 0 ? game_mode_port : port;
+
+  if (!server.Listen(address, static_cast<uint16_t>(listen_port))) {
+    std::cerr << "Failed to listen on " << address << ":" << listen_port << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  if (game_mode_port > 0 && server.SpawnDrone(static_cast<uint16_t>(port)) == 0) {
+    std::cerr << "Failed to listen on " << address << ":" << port << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  struct sigaction sigIntHandler {};
+  sigIntHandler.sa_handler = interruptHandler;
+  sigemptyset(&sigIntHandler.sa_mask);
+  sigIntHandler.sa_flags = 0;
+  sigaction(SIGINT, &sigIntHandler, nullptr);
+  sigaction(SIGTERM, &sigIntHandler, nullptr);
+
+  mockServer = &server;
+
+  std::cout << "Mock " << (game_mode_port > 0 ? "game mode" : "server") << " listening on " << address << ":" << listen_port << std::endl;
+  server.Run();
+
+  mockServer = nullptr;
+  server.Stop();
+
+  return 0;
+}
@@ -0,0 +1,1698 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include "mock_server.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <numbers>
+#include <random>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <flight_forge_connector/serialization/serializable_extended.h>
+#include <flight_forge_connector/capture_file.h>
+#include <flight_forge_connector/game_mode_controller.h>
+#include <flight_forge_connector/lidar_quantization.h>
+#include <flight_forge_connector/transport.h>
+
+using ueds_connector::CaptureDirection;
+using ueds_connector::Coordinates;
+using ueds_connector::FrameMode;
+using ueds_connector::LidarCloud;
+using ueds_connector::MockReplay;
+using ueds_connector::MockServer;
+using ueds_connector::MockServerOptions;
+
+namespace
+{
+
+// initial capacity of the per-connection response buffer, grows on demand
+constexpr size_t RESPONSE_BUFFER_SIZE = 4096;
+// sentinel framed requests carry no length, one recv() is one request
+constexpr size_t SENTINEL_REQUEST_SIZE = 4096;
+// horizontal shift of the right stereo image in pixels
+constexpr size_t STEREO_DISPARITY = 8;
+// the synthetic scans of the initial lidar config
+constexpr double LIDAR_BEAM_LENGTH  = 100.0;
+constexpr double LIDAR_FOV_VERTICAL = 15.0;
+// limits of the configs, the larger data would not fit into a frame
+constexpr size_t MAX_LIDAR_BEAMS  = 4u << 20;
+constexpr size_t MAX_IMAGE_PIXELS = 64u << 20;
+// free ports looked for after the last drone when spawning a new one
+constexpr int SPAWN_PORT_ATTEMPTS = 100;
+
+/* ReceiveAll() //{ */
+
+bool ReceiveAll(int fd, std::byte* data, size_t size) {
+
+  while (size > 0) {
+    const auto received = ::recv(fd, data, size, 0);
+    if (received <= 0) {
+      return false;
+    }
+    data += received;
+    size -= static_cast<size_t>(received);
+  }
+
+  return true;
+}
+
+//}
+
+/* SendAll() //{ */
+
+bool SendAll(int fd, const std::byte* data, size_t size) {
+
+  while (size > 0) {
+    const auto sent = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+
+  return true;
+}
+
+//}
+
+/* FillImage() //{ */
+
+// gradient test pattern, shifted horizontally by offset pixels, the segmentation image has coarse bands of labels instead
+void FillImage(std::span<unsigned char> image, size_t offset, bool segmented) {
+  for (size_t i = 0; i < image.size(); i++) {
+    const auto pixel = i / 3 + offset;
+    image[i]         = static_cast<unsigned char>(segmented ? pixel / 64 * 40 : pixel);
+  }
+}
+
+//}
+
+/* PackBeams() //{ */
+
+// the wire layout of the lidar beams, four doubles optionally followed by the label or intensity
+void PackBeams(const LidarCloud& scan, const std::vector<int>* extra, std::span<unsigned char> destination) {
+
+  const size_t beam_size = 4 * sizeof(double) + (extra != nullptr ? sizeof(int) : 0);
+
+  auto* beam = destination.data();
+  for (size_t i = 0; i < scan.size(); i++, beam += beam_size) {
+    std::memcpy(beam, &scan.distance[i], sizeof(double));
+    std::memcpy(beam + sizeof(double), &scan.dir_x[i], sizeof(double));
+    std::memcpy(beam + 2 * sizeof(double), &scan.dir_y[i], sizeof(double));
+    std::memcpy(beam + 3 * sizeof(double), &scan.dir_z[i], sizeof(double));
+    if (extra != nullptr) {
+      std::memcpy(beam + 4 * sizeof(double), &(*extra)[i], sizeof(int));
+    }
+  }
+}
+
+//}
+
+/* Load() //{ */
+
+template <typename TRequest>
+bool Load(std::span<const std::byte> data, TRequest& request) {
+
+  try {
+    ueds_connector::SpanInputArchive ia(data);
+    ia(request);
+  }
+  catch (cereal::Exception& exception) {
+    std::cerr << "MOCK-SERVER malformed request: " << exception.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+//}
+
+}  // namespace
+
+/* MockServer() //{ */
+
+MockServer::MockServer(const MockServerOptions& options, bool game_mode) : options_(options), game_mode_(game_mode) {
+
+  lidar_config_.Enable       = true;
+  lidar_config_.BeamLength   = LIDAR_BEAM_LENGTH;
+  lidar_config_.BeamHorRays  = options_.lidar_horizontal_rays;
+  lidar_config_.BeamVertRays = options_.lidar_vertical_rays;
+  lidar_config_.Frequency    = options_.stream_frequency;
+  lidar_config_.FOVHorLeft   = 180.0;
+  lidar_config_.FOVHorRight  = 180.0;
+  lidar_config_.FOVVertUp    = options_.lidar_vertical_rays > 1 ? LIDAR_FOV_VERTICAL : 0.0;
+  lidar_config_.FOVVertDown  = options_.lidar_vertical_rays > 1 ? LIDAR_FOV_VERTICAL : 0.0;
+
+  rgb_config_.fov_    = 90.0;
+  rgb_config_.width_  = options_.image_width;
+  rgb_config_.height_ = options_.image_height;
+
+  stereo_config_.fov_      = 90.0;
+  stereo_config_.width_    = options_.image_width;
+  stereo_config_.height_   = options_.image_height;
+  stereo_config_.baseline_ = 0.1;
+
+  // the game mode has no sensors
+  if (!game_mode_) {
+    RenderImages_();
+  }
+}
+
+//}
+
+/* ~MockServer() //{ */
+
+MockServer::~MockServer() {
+
+  Stop();
+
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+  }
+
+  if (!unix_path_.empty()) {
+    ::unlink(unix_path_.c_str());
+  }
+}
+
+//}
+
+/* Listen() //{ */
+
+bool MockServer::Listen(const std::string& address, uint16_t port) {
+
+  address_ = address;
+  port_    = port;
+
+  if (IsUnixSocketAddress(address)) {
+
+    unix_path_ = UnixSocketPath(address, port);
+
+    sockaddr_un socket_address{};
+    socket_address.sun_family = AF_UNIX;
+
+    if (unix_path_.size() >= sizeof(socket_address.sun_path)) {
+      return false;
+    }
+
+    std::memcpy(socket_address.sun_path, unix_path_.c_str(), unix_path_.size() + 1);
+
+    // a stale socket file of a previous run would make bind() fail
+    ::unlink(unix_path_.c_str());
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0) {
+      return false;
+    }
+
+  } else {
+
+    sockaddr_in socket_address{};
+    socket_address.sin_family      = AF_INET;
+    socket_address.sin_port        = htons(port);
+    socket_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    const int enable = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0) {
+      return false;
+    }
+  }
+
+  // set here already, a drone removed right after its spawn must not start accepting
+  running_ = ::listen(listen_fd_, SOMAXCONN) == 0;
+  return running_;
+}
+
+//}
+
+/* Run() //{ */
+
+void MockServer::Run() {
+
+  while (running_) {
+
+    pollfd descriptor{listen_fd_, POLLIN, 0};
+
+    // wake up periodically to notice Stop()
+    if (::poll(&descriptor, 1, 200) <= 0) {
+      continue;
+    }
+
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    std::scoped_lock lock(mutex_);
+    connections_.push_back(fd);
+    threads_.emplace_back(&MockServer::Serve_, this, fd);
+  }
+}
+
+//}
+
+/* RequestStop() //{ */
+
+void MockServer::RequestStop() {
+  running_ = false;
+}
+
+//}
+
+/* Stop() //{ */
+
+void MockServer::Stop() {
+
+  running_ = false;
+
+  std::vector<std::thread> threads;
+  std::map<int, Drone_>    drones;
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    // unblocks the connection threads waiting in recv()
+    for (const auto fd : connections_) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+
+    threads.swap(threads_);
+    drones.swap(drones_);
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto& [port, drone] : drones) {
+    drone.server->Stop();
+    drone.thread.join();
+  }
+}
+
+//}
+
+/* SpawnDrone() //{ */
+
+int MockServer::SpawnDrone(uint16_t port, const Coordinates& location) {
+
+  if (!game_mode_) {
+    return 0;
+  }
+
+  std::scoped_lock lock(mutex_);
+
+  auto server = std::make_unique<MockServer>(options_);
+  server->location_ = location;
+
+  // the next port after the last drone, skipping the ones taken by other processes
+  int  candidate = port > 0 ? port : (drones_.empty() ? port_ : drones_.rbegin()->first) + 1;
+  bool listening = false;
+
+  for (int attempt = 0; attempt < (port > 0 ? 1 : SPAWN_PORT_ATTEMPTS) && candidate <= UINT16_MAX; attempt++, candidate++) {
+    if (!drones_.contains(candidate) && server->Listen(address_, static_cast<uint16_t>(candidate))) {
+      listening = true;
+      break;
+    }
+
+    // a failed listener cannot be bound again
+    server = std::make_unique<MockServer>(options_);
+    server->location_ = location;
+  }
+
+  if (!listening) {
+    std::cerr << "MOCK-SERVER no free port to spawn a drone on" << std::endl;
+    return 0;
+  }
+
+  auto& drone  = drones_[candidate];
+  drone.server = std::move(server);
+  drone.thread = std::thread(&MockServer::Run, drone.server.get());
+
+  std::cout << "Mock drone spawned on " << address_ << ":" << candidate << std::endl;
+  return candidate;
+}
+
+//}
+
+/* RemoveDrone() //{ */
+
+bool MockServer::RemoveDrone(int port) {
+
+  Drone_ drone;
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    const auto it = drones_.find(port);
+    if (it == drones_.end()) {
+      return false;
+    }
+
+    drone = std::move(it->second);
+    drones_.erase(it);
+  }
+
+  // its connections are closed, the clients of the drone see it disappear
+  drone.server->Stop();
+  drone.thread.join();
+
+  std::cout << "Mock drone removed from " << address_ << ":" << port << std::endl;
+  return true;
+}
+
+//}
+
+/* Serve_() //{ */
+
+void MockServer::Serve_(int fd) {
+
+  Connection_ connection;
+  connection.fd = fd;
+  connection.response.resize(RESPONSE_BUFFER_SIZE);
+
+  while (ReadRequest_(connection) && Handle_(connection, connection.request)) {
+  }
+
+  StopPushing_(connection);
+
+  std::scoped_lock lock(mutex_);
+  std::erase(connections_, fd);
+  ::close(fd);
+}
+
+//}
+
+/* ReadRequest_() //{ */
+
+bool MockServer::ReadRequest_(Connection_& connection) {
+
+  if (connection.frame_mode == FrameMode::SENTINEL) {
+
+    connection.request.resize(SENTINEL_REQUEST_SIZE);
+
+    const auto received = ::recv(connection.fd, connection.request.data(), connection.request.size(), 0);
+    if (received <= 0) {
+      return false;
+    }
+
+    connection.request.resize(static_cast<size_t>(received));
+    return true;
+  }
+
+  std::array<std::byte, SEQUENCED_FRAME_HEADER_SIZE> header{};
+  if (!ReceiveAll(connection.fd, header.data(), FrameHeaderSize(connection.frame_mode))) {
+    return false;
+  }
+
+  const auto frame_size = ReadFrameHeader(header.data());
+  const auto size       = frame_size & ~FRAME_COMPRESSED_FLAG;
+  if (size == 0 || size > MAX_FRAME_SIZE) {
+    return false;
+  }
+
+  connection.sequence = connection.frame_mode == FrameMode::SEQUENCED ? ReadFrameHeader(header.data() + FRAME_HEADER_SIZE) : 0;
+
+  if ((frame_size & FRAME_COMPRESSED_FLAG) == 0) {
+    connection.request.resize(size);
+    return ReceiveAll(connection.fd, connection.request.data(), size);
+  }
+
+  auto& compressed = connection.compressed_request;
+  compressed.resize(size);
+
+  if (!ReceiveAll(connection.fd, compressed.data(), size)) {
+    return false;
+  }
+
+  const auto original_size = CompressedPayloadSize(compressed);
+  if (original_size == 0 || original_size > MAX_FRAME_SIZE) {
+    return false;
+  }
+
+  connection.request.resize(original_size);
+  return Lz4Decompress(std::span<const std::byte>(compressed).subspan(COMPRESSED_PAYLOAD_HEADER_SIZE), connection.request);
+}
+
+//}
+
+/* Handle_() //{ */
+
+bool MockServer::Handle_(Connection_& connection, std::span<const std::byte> payload) {
+
+  namespace Common = Serializable::Common;
+
+  Common::NetworkRequest header{};
+  if (!Load(payload, header)) {
+    return false;
+  }
+
+  switch (header.type) {
+
+    case Common::MessageType::ping: {
+      Common::Ping::Response response(true);
+      return Reply_(connection, response);
+    }
+
+    case Common::MessageType::set_frame_mode: {
+      Common::SetFrameMode::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      // the framing cannot change in the middle of a batch response
+      const auto supported = request.frame_mode <= FrameMode::SEQUENCED && connection.batch_offset == 0;
+
+      // the reply uses the old framing, the connection switches right after it
+      Common::SetFrameMode::Response response(supported);
+      if (!Reply_(connection, response)) {
+        return false;
+      }
+
+      if (supported) {
+        connection.frame_mode = static_cast<FrameMode>(request.frame_mode);
+      }
+      return true;
+    }
+
+    case Common::MessageType::set_compression: {
+      Common::SetCompression::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      // the compressed frames are marked by their size, the legacy framing has none
+      const auto supported = connection.frame_mode != FrameMode::SENTINEL;
+
+      Common::SetCompression::Response response(supported);
+      if (!Reply_(connection, response)) {
+        return false;
+      }
+
+      if (supported) {
+        std::scoped_lock lock(connection.writer->mutex);
+        connection.writer->compression = CompressionOptions{request.enable, request.threshold, request.acceleration};
+      }
+      return true;
+    }
+
+    case Common::MessageType::set_shared_frames: {
+      Common::SetSharedFrames::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      Common::SetSharedFrames::Response response(true);
+
+      if (request.enable) {
+        response.status = EnableSharedFrames_(connection, request.slot_count, request.slot_size);
+      } else {
+        connection.shared_frames.Close();
+      }
+
+      response.name       = connection.shared_frames.GetName();
+      response.slot_count = connection.shared_frames.GetSlotCount();
+      response.slot_size  = connection.shared_frames.GetSlotSize();
+      return Reply_(connection, response);
+    }
+
+    default: {
+      if (game_mode_) {
+        return HandleGameMode_(connection, payload, header.type);
+      }
+
+      if (options_.replay) {
+        const auto replayed = options_.replay->responses.find(header.type);
+
+        if (replayed != options_.replay->responses.end() && !replayed->second.empty()) {
+          auto& cursor = connection.replay_cursor[header.type];
+          return ReplayResponse_(connection, replayed->second[cursor++ % replayed->second.size()]);
+        }
+      }
+
+      return HandleDrone_(connection, payload, header.type);
+    }
+  }
+}
+
+//}
+
+/* HandleDrone_() //{ */
+
+bool MockServer::HandleDrone_(Connection_& connection, std::span<const std::byte> payload, unsigned short type) {
+
+  namespace Common = Serializable::Common;
+  namespace Drone  = Serializable::Drone;
+
+  // the sensor data take their render time on top of the response delay, a batch takes the time of its entries
+  if (type != Drone::MessageType::batch) {
+    const auto camera = type == Drone::MessageType::get_rgb_camera_data || type == Drone::MessageType::get_rgb_seg_camera_data ||
+                        type == Drone::MessageType::get_stereo_camera_data;
+    const auto lidar = type == Drone::MessageType::get_lidar_data || type == Drone::MessageType::get_lidar_seg ||
+                       type == Drone::MessageType::get_lidar_int || type == Drone::MessageType::get_lidar_distances ||
+                       type == Drone::MessageType::get_lidar_quantized;
+
+    Delay_(camera ? options_.camera_delay : lidar ? options_.lidar_delay : std::chrono::microseconds(0));
+  }
+
+  switch (type) {
+
+    case Drone::MessageType::get_location: {
+      Drone::GetLocation::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.x = location_.x;
+        response.y = location_.y;
+        response.z = location_.z;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_location: {
+      Drone::SetLocation::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(mutex_);
+        location_ = Coordinates{request.x, request.y, request.z};
+      }
+
+      Drone::SetLocation::Response response(true);
+      response.teleportedToX = request.x;
+      response.teleportedToY = request.y;
+      response.teleportedToZ = request.z;
+      response.isHit         = false;
+      response.impactPointX  = 0;
+      response.impactPointY  = 0;
+      response.impactPointZ  = 0;
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_rotation: {
+      Drone::GetRotation::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.pitch = rotation_.pitch;
+        response.yaw   = rotation_.yaw;
+        response.roll  = rotation_.roll;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_rotation: {
+      Drone::SetRotation::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(mutex_);
+        rotation_.pitch = request.pitch;
+        rotation_.yaw   = request.yaw;
+        rotation_.roll  = request.roll;
+      }
+
+      Drone::SetRotation::Response response(true);
+      response.rotatedToPitch = request.pitch;
+      response.rotatedToYaw   = request.yaw;
+      response.rotatedToRoll  = request.roll;
+      response.isHit          = false;
+      response.impactPointX   = 0;
+      response.impactPointY   = 0;
+      response.impactPointZ   = 0;
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_location_and_rotation:
+    case Drone::MessageType::set_location_and_rotation_async: {
+      // both requests have the same layout
+      Drone::SetLocationAndRotation::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(mutex_);
+        location_ = Coordinates{request.x, request.y, request.z};
+        rotation_ = Rotation{request.pitch, request.yaw, request.roll};
+      }
+
+      if (type == Drone::MessageType::set_location_and_rotation_async) {
+        Drone::SetLocationAndRotationAsync::Response response(true);
+        return Reply_(connection, response);
+      }
+
+      Drone::SetLocationAndRotation::Response response(true);
+      response.teleportedToX  = request.x;
+      response.teleportedToY  = request.y;
+      response.teleportedToZ  = request.z;
+      response.rotatedToPitch = request.pitch;
+      response.rotatedToYaw   = request.yaw;
+      response.rotatedToRoll  = request.roll;
+      response.isHit          = false;
+      response.impactPointX   = 0;
+      response.impactPointY   = 0;
+      response.impactPointZ   = 0;
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_lidar_config: {
+      Drone::GetLidarConfig::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.config = lidar_config_;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_lidar_config: {
+      Drone::SetLidarConfig::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      const auto& config = request.config;
+      const auto  beams  = static_cast<size_t>(std::max(config.BeamHorRays, 0)) * static_cast<size_t>(std::max(config.BeamVertRays, 0));
+      const auto  valid  = beams > 0 && beams <= MAX_LIDAR_BEAMS && config.BeamLength > 0.0;
+
+      if (valid) {
+        std::scoped_lock lock(mutex_);
+        lidar_config_ = config;
+        // the clients caching the beam directions fetch them again
+        lidar_directions_id_++;
+      }
+
+      Drone::SetLidarConfig::Response response(valid);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_rgb_camera_config: {
+      Drone::GetRgbCameraConfig::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.config = rgb_config_;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_rgb_camera_config:
+    case Drone::MessageType::set_stereo_camera_config: {
+      int width  = 0;
+      int height = 0;
+
+      Drone::SetRgbCameraConfig::Request    rgb_request{};
+      Drone::SetStereoCameraConfig::Request stereo_request{};
+
+      if (type == Drone::MessageType::set_rgb_camera_config) {
+        if (!Load(payload, rgb_request)) {
+          return false;
+        }
+        width  = rgb_request.config.width_;
+        height = rgb_request.config.height_;
+      } else {
+        if (!Load(payload, stereo_request)) {
+          return false;
+        }
+        width  = stereo_request.config.width_;
+        height = stereo_request.config.height_;
+      }
+
+      const auto valid = width > 0 && height > 0 && static_cast<size_t>(width) * static_cast<size_t>(height) <= MAX_IMAGE_PIXELS;
+
+      if (valid) {
+        std::scoped_lock lock(mutex_);
+
+        if (type == Drone::MessageType::set_rgb_camera_config) {
+          rgb_config_ = rgb_request.config;
+        } else {
+          stereo_config_ = stereo_request.config;
+        }
+
+        RenderImages_();
+      }
+
+      // both responses are the bare header of their type
+      Common::NetworkResponse response(type, valid);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_stereo_camera_config: {
+      Drone::GetStereoCameraConfig::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.config = stereo_config_;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_move_line_visible: {
+      Drone::GetMoveLineVisible::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.visible = move_line_visible_;
+      }
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::set_move_line_visible: {
+      Drone::SetMoveLineVisible::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(mutex_);
+        move_line_visible_ = request.visible;
+      }
+
+      Drone::SetMoveLineVisible::Response response(true);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_crash_state: {
+      Drone::GetCrashState::Response response(true);
+      response.crashed = false;
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_rangefinder_data: {
+      // slowly undulating ground below the drone
+      Drone::GetRangefinderData::Response response(true);
+      response.range = 10.0 + 2.0 * std::sin(Stamp_());
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::subscribe: {
+      Drone::Subscribe::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      const auto sensor = request.sensor;
+      const auto known  = sensor == Drone::MessageType::get_lidar_data || sensor == Drone::MessageType::get_lidar_seg ||
+                         sensor == Drone::MessageType::get_lidar_int || sensor == Drone::MessageType::get_rangefinder_data ||
+                         sensor == Drone::MessageType::get_rgb_camera_data || sensor == Drone::MessageType::get_rgb_seg_camera_data ||
+                         sensor == Drone::MessageType::get_stereo_camera_data;
+
+      // the pushes are told apart from the responses by the sequence id only
+      const auto success = known && connection.frame_mode == FrameMode::SEQUENCED && request.frequency >= 0.0;
+
+      // the sensor rate of the lidar is the frequency of its config
+      auto sensor_rate = options_.stream_frequency;
+
+      if (sensor == Drone::MessageType::get_lidar_data || sensor == Drone::MessageType::get_lidar_seg ||
+          sensor == Drone::MessageType::get_lidar_int) {
+        std::scoped_lock lock(mutex_);
+        sensor_rate = lidar_config_.Frequency > 0.0 ? lidar_config_.Frequency : sensor_rate;
+      }
+
+      if (success) {
+        std::scoped_lock lock(connection.subscriptions_mutex);
+
+        connection.subscriptions[sensor] = request.frequency > 0.0 ? request.frequency : sensor_rate;
+
+        if (!connection.pushing) {
+          connection.pushing = true;
+          connection.pusher  = std::thread(&MockServer::Push_, this, std::ref(connection));
+        }
+      }
+
+      connection.subscriptions_condition.notify_all();
+
+      Drone::Subscribe::Response response(success);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::unsubscribe: {
+      Drone::Unsubscribe::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      bool success = false;
+
+      {
+        std::scoped_lock lock(connection.subscriptions_mutex);
+        success = connection.subscriptions.erase(request.sensor) > 0;
+      }
+
+      connection.subscriptions_condition.notify_all();
+
+      Drone::Unsubscribe::Response response(success);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_rgb_camera_data:
+    case Drone::MessageType::get_rgb_seg_camera_data: {
+      const auto  images = GetImages_();
+      const auto& image  = type == Drone::MessageType::get_rgb_seg_camera_data ? images->segmented : images->rgb;
+
+      if (connection.shared_frames.IsOpen()) {
+        return ShareFrame_(connection, type, image.size(), image.size(), Coordinates{0, 0, 0},
+                           [&image](std::span<unsigned char> destination) { std::memcpy(destination.data(), image.data(), image.size()); });
+      }
+
+      if (type == Drone::MessageType::get_rgb_seg_camera_data) {
+        Drone::GetRgbSegCameraData::Response response(true);
+        response.image_ = image;
+        response.stamp_ = Stamp_();
+        return Reply_(connection, response);
+      }
+
+      Drone::GetRgbCameraData::Response response(true);
+      response.image_ = image;
+      response.stamp_ = Stamp_();
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_stereo_camera_data: {
+      const auto images = GetImages_();
+      const auto size   = images->stereo_left.size();
+
+      if (connection.shared_frames.IsOpen()) {
+        return ShareFrame_(connection, type, 2 * size, size, Coordinates{0, 0, 0}, [&images, size](std::span<unsigned char> destination) {
+          std::memcpy(destination.data(), images->stereo_left.data(), size);
+          std::memcpy(destination.data() + size, images->stereo_right.data(), size);
+        });
+      }
+
+      Drone::GetStereoCameraData::Response response(true);
+      response.image_left_  = images->stereo_left;
+      response.image_right_ = images->stereo_right;
+      response.stamp_       = Stamp_();
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_lidar_data:
+    case Drone::MessageType::get_lidar_seg:
+    case Drone::MessageType::get_lidar_int: {
+      FillScan_(connection);
+
+      const auto& scan  = connection.scan;
+      const auto* extra = type == Drone::MessageType::get_lidar_seg   ? &scan.label
+                          : type == Drone::MessageType::get_lidar_int ? &scan.intensity
+                                                                      : nullptr;
+
+      if (connection.shared_frames.IsOpen()) {
+        const auto size = scan.size() * (4 * sizeof(double) + (extra != nullptr ? sizeof(int) : 0));
+        return ShareFrame_(connection, type, size, size, scan.start,
+                           [&scan, extra](std::span<unsigned char> beams) { PackBeams(scan, extra, beams); });
+      }
+
+      // the cloud responses serialize the scan in the layout of the regular ones
+      if (type == Drone::MessageType::get_lidar_seg) {
+        Drone::GetLidarSegData::CloudResponse response(connection.scan);
+        return Reply_(connection, response);
+      }
+
+      if (type == Drone::MessageType::get_lidar_int) {
+        Drone::GetLidarIntData::CloudResponse response(connection.scan);
+        return Reply_(connection, response);
+      }
+
+      Drone::GetLidarData::CloudResponse response(connection.scan);
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_lidar_directions: {
+      FillScan_(connection);
+
+      Drone::GetLidarDirections::Response response(true);
+      response.table_id   = connection.scan_id;
+      response.directionX = connection.scan.dir_x;
+      response.directionY = connection.scan.dir_y;
+      response.directionZ = connection.scan.dir_z;
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_lidar_distances: {
+      Drone::GetLidarDistances::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      FillScan_(connection);
+
+      const auto& scan = connection.scan;
+
+      Drone::GetLidarDistances::Response response(true);
+      response.startX    = scan.start.x;
+      response.startY    = scan.start.y;
+      response.startZ    = scan.start.z;
+      response.table_id  = connection.scan_id;
+      response.distances = scan.distance;
+
+      if (request.source == Drone::MessageType::get_lidar_seg) {
+        response.extra = scan.label;
+      } else if (request.source == Drone::MessageType::get_lidar_int) {
+        response.extra = scan.intensity;
+      }
+
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::get_lidar_quantized: {
+      Drone::GetLidarQuantized::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      FillScan_(connection);
+
+      const auto& scan = connection.scan;
+
+      Drone::GetLidarQuantized::Response response(true);
+      response.startX     = scan.start.x;
+      response.startY     = scan.start.y;
+      response.startZ     = scan.start.z;
+      response.table_id   = connection.scan_id;
+      response.resolution = request.resolution > 0.0 ? request.resolution : LidarRangeResolution(connection.scan_beam_length);
+      response.ranges.resize(scan.size());
+      QuantizeRanges(scan.distance, response.resolution, response.ranges);
+      response.value_size = 0;
+
+      // labels in one byte while they fit, intensities clamped to one byte
+      if (request.source == Drone::MessageType::get_lidar_seg || request.source == Drone::MessageType::get_lidar_int) {
+        const auto& values = request.source == Drone::MessageType::get_lidar_seg ? scan.label : scan.intensity;
+        const auto  wide   = request.source == Drone::MessageType::get_lidar_seg && std::any_of(values.begin(), values.end(), [](int value) {
+                            return value > UINT8_MAX;
+                          });
+
+        response.value_size = wide ? 2 : 1;
+        response.values.resize(values.size() * response.value_size);
+
+        for (size_t i = 0; i < values.size(); i++) {
+          const auto value = static_cast<unsigned int>(std::clamp(values[i], 0, wide ? UINT16_MAX : UINT8_MAX));
+          for (size_t byte = 0; byte < response.value_size; byte++) {
+            response.values[i * response.value_size + byte] = static_cast<unsigned char>((value >> (8 * byte)) & 0xff);
+          }
+        }
+      }
+
+      return Reply_(connection, response);
+    }
+
+    case Drone::MessageType::batch: {
+      // a batch within a batch is not executed
+      if (connection.batch_offset > 0) {
+        Common::NetworkResponse response(type, false);
+        return Reply_(connection, response);
+      }
+
+      return HandleBatch_(connection, payload);
+    }
+
+    default: {
+      // not part of the drone protocol
+      Common::NetworkResponse response(type, false);
+      return Reply_(connection, response);
+    }
+  }
+}
+
+//}
+
+/* HandleGameMode_() //{ */
+
+bool MockServer::HandleGameMode_(Connection_& connection, std::span<const std::byte> payload, unsigned short type) {
+
+  namespace Common   = Serializable::Common;
+  namespace GameMode = Serializable::GameMode;
+
+  Delay_(std::chrono::microseconds(0));
+
+  switch (type) {
+
+    case GameMode::MessageType::get_drones: {
+      GameMode::GetDrones::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        for (const auto& [port, drone] : drones_) {
+          response.ports.push_back(port);
+        }
+      }
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::spawn_drone: {
+      GameMode::SpawnDrone::Response response(true);
+      response.port   = SpawnDrone();
+      response.status = response.port > 0;
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::spawn_drone_at_location: {
+      GameMode::SpawnDroneAtLocation::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      // the mesh of the drone makes no difference here
+      GameMode::SpawnDroneAtLocation::Response response{};
+      response.port   = SpawnDrone(0, Coordinates{request.x, request.y, request.z});
+      response.status = response.port > 0;
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::remove_drone: {
+      GameMode::RemoveDrone::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      GameMode::RemoveDrone::Response response(RemoveDrone(request.port));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::get_camera_capture_mode: {
+      GameMode::GetCameraCaptureMode::Response response(true);
+      {
+        std::scoped_lock lock(mutex_);
+        response.cameraCaptureMode = camera_capture_mode_;
+      }
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_camera_capture_mode: {
+      GameMode::SetCameraCaptureMode::Request request{};
+      if (!Load(payload, request)) {
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(mutex_);
+        camera_capture_mode_ = request.cameraCaptureMode;
+      }
+
+      GameMode::SetCameraCaptureMode::Response response(true);
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::get_fps: {
+      GameMode::GetFps::Response response(true);
+      response.fps = options_.fps;
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::get_time: {
+      GameMode::GetTime::Response response(true);
+      response.time = Stamp_();
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::get_api_version: {
+      GameMode::GetApiVersion::Response response(true);
+      response.api_version_major = API_VERSION_MAJOR;
+      response.api_version_minor = API_VERSION_LATEST_MINOR;
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::get_world_origin: {
+      GameMode::GetWorldOrigin::Response response(true);
+      response.x = 0;
+      response.y = 0;
+      response.z = 0;
+      return Reply_(connection, response);
+    }
+
+    // the world settings are accepted without any effect on the synthetic data
+    case GameMode::MessageType::set_graphics_settings: {
+      GameMode::SetGraphicsSettings::Request request{};
+      Common::NetworkResponse                response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::switch_world_level: {
+      GameMode::SwitchWorldLevel::Request request{};
+      Common::NetworkResponse             response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_forest_density: {
+      GameMode::SetForestDensity::Request request{};
+      Common::NetworkResponse             response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_forest_hilly_level: {
+      GameMode::SetForestHillyLevel::Request request{};
+      Common::NetworkResponse                response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_weather: {
+      GameMode::SetWeather::Request request{};
+      Common::NetworkResponse       response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_daytime: {
+      GameMode::SetDaytime::Request request{};
+      Common::NetworkResponse       response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    case GameMode::MessageType::set_mutual_visibility: {
+      GameMode::SetMutualVisibility::Request request{};
+      Common::NetworkResponse                response(type, Load(payload, request));
+      return Reply_(connection, response);
+    }
+
+    default: {
+      // not part of the game mode protocol
+      Common::NetworkResponse response(type, false);
+      return Reply_(connection, response);
+    }
+  }
+}
+
+//}
+
+/* HandleBatch_() //{ */
+
+bool MockServer::HandleBatch_(Connection_& connection, std::span<const std::byte> payload) {
+
+  namespace Drone = Serializable::Drone;
+
+  Drone::Batch::Request request{};
+  if (!Load(payload, request)) {
+    return false;
+  }
+
+  // the response header goes in front of the entries once their size is known, its size does not depend on the values
+  const auto header_offset = FrameHeaderSize(connection.frame_mode);
+
+  Drone::Batch::Response response(true);
+  response.count = request.count;
+
+  SpanOutputArchive header_size_probe(std::span<std::byte>(connection.response).subspan(header_offset));
+  header_size_probe(response);
+
+  const auto entries_offset = header_offset + header_size_probe.written();
+  connection.batch_offset   = entries_offset;
+
+  SpanInputArchive requests(std::as_bytes(std::span<const unsigned char>(request.requests)));
+  bool             success = true;
+
+  try {
+    for (unsigned int i = 0; i < request.count && success; i++) {
+      uint32_t size = 0;
+      requests(size);
+      success = Handle_(connection, requests.takeBinary(size));
+    }
+  }
+  catch (cereal::Exception& exception) {
+    std::cerr << "MOCK-SERVER malformed batch: " << exception.what() << std::endl;
+    success = false;
+  }
+
+  const auto entries_size = connection.batch_offset - entries_offset;
+  connection.batch_offset = 0;
+
+  if (!success) {
+    return false;
+  }
+
+  SpanOutputArchive oa(std::span<std::byte>(connection.response).subspan(header_offset));
+  oa(static_cast<Serializable::Common::NetworkResponse&>(response), response.count,
+     cereal::make_size_tag(static_cast<cereal::size_type>(entries_size)));
+
+  return WriteResponse_(connection, oa.written() + entries_size);
+}
+
+//}
+
+/* Reply_() //{ */
+
+template <typename TResponse>
+bool MockServer::Reply_(Connection_& connection, TResponse& response) {
+
+  // an entry of the batch response, prefixed by its size
+  if (connection.batch_offset > 0) {
+    connection.response.resize(std::max(connection.response.size(), connection.batch_offset + RESPONSE_BUFFER_SIZE));
+
+    while (true) {
+      try {
+        SpanOutputArchive oa(std::span<std::byte>(connection.response).subspan(connection.batch_offset + sizeof(uint32_t)));
+        oa(response);
+
+        const auto size = static_cast<uint32_t>(oa.written());
+        std::memcpy(connection.response.data() + connection.batch_offset, &size, sizeof(size));
+        connection.batch_offset += sizeof(size) + size;
+        return true;
+      }
+      catch (SpanOverflow&) {
+        connection.response.resize(connection.response.size() * 2);
+      }
+    }
+  }
+
+  const auto header_size = FrameHeaderSize(connection.frame_mode);
+
+  while (true) {
+    try {
+      SpanOutputArchive oa(std::span<std::byte>(connection.response).subspan(header_size));
+      oa(response);
+      return WriteResponse_(connection, oa.written());
+    }
+    catch (SpanOverflow&) {
+      connection.response.resize(connection.response.size() * 2);
+    }
+  }
+}
+
+//}
+
+/* WriteResponse_() //{ */
+
+bool MockServer::WriteResponse_(Connection_& connection, size_t size) {
+
+  auto& data   = connection.response;
+  auto& writer = *connection.writer;
+
+  std::scoped_lock lock(writer.mutex);
+
+  const auto header_size = FrameHeaderSize(connection.frame_mode);
+
+  // sent compressed only if it gets smaller
+  if (writer.compression.enabled && header_size > 0 && size >= writer.compression.threshold) {
+
+    writer.compressed.resize(std::max(writer.compressed.size(), header_size + size));
+
+    const auto compressed_size = CompressPayload(std::span<const std::byte>(data).subspan(header_size, size),
+                                                 std::span<std::byte>(writer.compressed).subspan(header_size), writer.compression.acceleration);
+
+    if (compressed_size > 0) {
+      const auto frame_size = static_cast<uint32_t>(compressed_size) | FRAME_COMPRESSED_FLAG;
+
+      if (connection.frame_mode == FrameMode::SEQUENCED) {
+        WriteSequencedFrameHeader(writer.compressed.data(), frame_size, connection.sequence);
+      } else {
+        WriteFrameHeader(writer.compressed.data(), frame_size);
+      }
+
+      return SendAll(connection.fd, writer.compressed.data(), header_size + compressed_size);
+    }
+  }
+
+  switch (connection.frame_mode) {
+
+    case FrameMode::SEQUENCED:
+      WriteSequencedFrameHeader(data.data(), static_cast<uint32_t>(size), connection.sequence);
+      return SendAll(connection.fd, data.data(), SEQUENCED_FRAME_HEADER_SIZE + size);
+
+    case FrameMode::LENGTH_PREFIXED:
+      WriteFrameHeader(data.data(), static_cast<uint32_t>(size));
+      return SendAll(connection.fd, data.data(), FRAME_HEADER_SIZE + size);
+
+    default:
+      if (data.size() < size + END_OF_MESSAGE_LENGTH) {
+        data.resize(size + END_OF_MESSAGE_LENGTH);
+      }
+      std::memset(data.data() + size, '$', END_OF_MESSAGE_LENGTH);
+      return SendAll(connection.fd, data.data(), size + END_OF_MESSAGE_LENGTH);
+  }
+}
+
+//}
+
+/* ReplayResponse_() //{ */
+
+bool MockServer::ReplayResponse_(Connection_& connection, const MockReplay::Response& response) {
+
+  if (options_.replay->timing) {
+    std::this_thread::sleep_for(response.latency);
+  }
+
+  const auto& payload = response.payload;
+
+  // an entry of the batch response, prefixed by its size
+  if (connection.batch_offset > 0) {
+    const auto size = static_cast<uint32_t>(payload.size());
+
+    connection.response.resize(std::max(connection.response.size(), connection.batch_offset + sizeof(size) + payload.size()));
+    std::memcpy(connection.response.data() + connection.batch_offset, &size, sizeof(size));
+    std::memcpy(connection.response.data() + connection.batch_offset + sizeof(size), payload.data(), payload.size());
+    connection.batch_offset += sizeof(size) + payload.size();
+    return true;
+  }
+
+  const auto header_size = FrameHeaderSize(connection.frame_mode);
+
+  connection.response.resize(std::max(connection.response.size(), header_size + payload.size()));
+  std::memcpy(connection.response.data() + header_size, payload.data(), payload.size());
+
+  return WriteResponse_(connection, payload.size());
+}
+
+//}
+
+/* EnableSharedFrames_() //{ */
+
+bool MockServer::EnableSharedFrames_(Connection_& connection, unsigned int slot_count, unsigned int slot_size) {
+
+  if (connection.shared_frames.IsOpen()) {
+    return true;
+  }
+
+  const auto images = GetImages_();
+  size_t     beams  = 0;
+
+  {
+    std::scoped_lock lock(mutex_);
+    beams = static_cast<size_t>(lidar_config_.BeamHorRays) * static_cast<size_t>(lidar_config_.BeamVertRays);
+  }
+
+  // large enough for the stereo pair and for the lidar scan with labels of the current configs
+  const auto largest_frame = std::max({images->rgb.size(), 2 * images->stereo_left.size(), beams * (4 * sizeof(double) + sizeof(int))});
+
+  const auto name = "/flightforge-mock-" + std::to_string(::getpid()) + "-" + std::to_string(connection.fd);
+
+  return connection.shared_frames.Create(name, slot_count > 0 ? slot_count : SHARED_FRAMES_DEFAULT_SLOTS,
+                                         slot_size > 0 ? slot_size : static_cast<uint32_t>(largest_frame));
+}
+
+//}
+
+/* ShareFrame_() //{ */
+
+bool MockServer::ShareFrame_(Connection_& connection, unsigned short type, size_t size, size_t split, const Coordinates& start,
+                             const std::function<void(std::span<unsigned char>)>& fill) {
+
+  uint32_t   slot        = 0;
+  const auto destination = connection.shared_frames.BeginWrite(static_cast<uint32_t>(size), slot);
+
+  if (destination.data() == nullptr) {
+    std::cerr << "MOCK-SERVER frame of " << size << " bytes does not fit into the shared slots of " << connection.shared_frames.GetSlotSize()
+              << " bytes" << std::endl;
+    Serializable::Common::FrameDescriptor::Response response(type, false);
+    return Reply_(connection, response);
+  }
+
+  fill(destination);
+
+  Serializable::Common::FrameDescriptor::Response response(type, true);
+  response.slot     = slot;
+  response.sequence = connection.shared_frames.CommitWrite(slot);
+  response.size     = static_cast<unsigned int>(size);
+  response.split    = static_cast<unsigned int>(split);
+  response.stamp_   = Stamp_();
+  response.startX   = start.x;
+  response.startY   = start.y;
+  response.startZ   = start.z;
+  return Reply_(connection, response);
+}
+
+//}
+
+/* Push_() //{ */
+
+void MockServer::Push_(Connection_& connection) {
+
+  using Clock = std::chrono::steady_clock;
+
+  // the pushes are produced by the handlers of the data requests, written with their own buffers between the responses
+  Connection_ push;
+  push.fd          = connection.fd;
+  push.frame_mode  = FrameMode::SEQUENCED;
+  push.sequence    = 0;
+  push.writer      = connection.writer;
+  push.response.resize(RESPONSE_BUFFER_SIZE);
+
+  std::map<unsigned short, Clock::time_point> due;
+  std::vector<unsigned short>                 ready;
+  std::array<std::byte, 16>                   request;
+
+  std::unique_lock lock(connection.subscriptions_mutex);
+
+  while (connection.pushing) {
+
+    const auto now  = Clock::now();
+    auto       wake = now + std::chrono::milliseconds(200);
+
+    std::erase_if(due, [&connection](const auto& entry) { return !connection.subscriptions.contains(entry.first); });
+    ready.clear();
+
+    for (const auto& [sensor, frequency] : connection.subscriptions) {
+
+      auto& at = due.try_emplace(sensor, now).first->second;
+
+      if (at <= now) {
+        ready.push_back(sensor);
+        // a late push does not cause a burst of the missed ones
+        at = std::max(at + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frequency)), now);
+      }
+
+      wake = std::min(wake, at);
+    }
+
+    lock.unlock();
+
+    for (const auto sensor : ready) {
+
+      Serializable::Common::NetworkRequest header(sensor);
+      SpanOutputArchive                    oa(request);
+      oa(header);
+
+      if (!Handle_(push, std::span<const std::byte>(request).first(oa.written()))) {
+        lock.lock();
+        connection.pushing = false;
+        return;
+      }
+    }
+
+    lock.lock();
+    connection.subscriptions_condition.wait_until(lock, wake, [&connection] { return !connection.pushing; });
+  }
+}
+
+//}
+
+/* StopPushing_() //{ */
+
+void MockServer::StopPushing_(Connection_& connection) {
+
+  {
+    std::scoped_lock lock(connection.subscriptions_mutex);
+    connection.pushing = false;
+  }
+
+  connection.subscriptions_condition.notify_all();
+
+  if (connection.pusher.joinable()) {
+    connection.pusher.join();
+  }
+}
+
+//}
+
+/* Delay_() //{ */
+
+void MockServer::Delay_(std::chrono::microseconds render_time) const {
+
+  auto delay = options_.response_delay + render_time;
+
+  if (options_.delay_jitter.count() > 0) {
+    thread_local std::minstd_rand random(std::random_device{}());
+    delay += std::chrono::microseconds(std::uniform_int_distribution<int64_t>(0, options_.delay_jitter.count())(random));
+  }
+
+  if (delay.count() > 0) {
+    std::this_thread::sleep_for(delay);
+  }
+}
+
+//}
+
+/* RenderImages_() //{ */
+
+void MockServer::RenderImages_() {
+
+  auto images = std::make_shared<Images_>();
+
+  images->rgb.resize(static_cast<size_t>(rgb_config_.width_) * rgb_config_.height_ * 3);
+  images->segmented.resize(images->rgb.size());
+  images->stereo_left.resize(static_cast<size_t>(stereo_config_.width_) * stereo_config_.height_ * 3);
+  images->stereo_right.resize(images->stereo_left.size());
+
+  // the right camera sees the pattern shifted by a constant disparity
+  FillImage(images->rgb, 0, false);
+  FillImage(images->segmented, 0, true);
+  FillImage(images->stereo_left, 0, false);
+  FillImage(images->stereo_right, STEREO_DISPARITY, false);
+
+  images_ = std::move(images);
+}
+
+//}
+
+/* GetImages_() //{ */
+
+std::shared_ptr<const MockServer::Images_> MockServer::GetImages_() const {
+  std::scoped_lock lock(mutex_);
+  return images_;
+}
+
+//}
+
+/* Stamp_() //{ */
+
+double MockServer::Stamp_() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+}
+
+//}
+
+/* FillScan_() //{ */
+
+// the beam grid of the lidar config around the drone, the distance undulates with the azimuth and the elevation
+void MockServer::FillScan_(Connection_& connection) const {
+
+  Serializable::Drone::LidarConfig config{};
+  unsigned int                     id = 0;
+
+  auto& scan = connection.scan;
+
+  {
+    std::scoped_lock lock(mutex_);
+    scan.start = location_;
+    config     = lidar_config_;
+    id         = lidar_directions_id_;
+  }
+
+  // the beams stay the same until the config changes
+  if (connection.scan_id == id) {
+    return;
+  }
+
+  connection.scan_id          = id;
+  connection.scan_beam_length = config.BeamLength;
+
+  const auto horizontal = static_cast<size_t>(config.BeamHorRays);
+  const auto vertical   = static_cast<size_t>(config.BeamVertRays);
+  const auto beams      = horizontal * vertical;
+
+  scan.resize(beams);
+  scan.label.resize(beams);
+  scan.intensity.resize(beams);
+
+  const auto to_radians = std::numbers::pi / 180.0;
+
+  // a full circle does not repeat its first beam, a narrower field of view includes both of its edges
+  const auto horizontal_fov  = config.FOVHorLeft + config.FOVHorRight;
+  const auto horizontal_step = horizontal_fov / static_cast<double>(horizontal_fov >= 360.0 ? horizontal : std::max<size_t>(horizontal - 1, 1));
+  const auto vertical_step   = (config.FOVVertUp + config.FOVVertDown) / static_cast<double>(std::max<size_t>(vertical - 1, 1));
+
+  for (size_t row = 0; row < vertical; row++) {
+
+    const auto elevation = (static_cast<double>(row) * vertical_step - config.FOVVertDown) * to_radians;
+
+    for (size_t column = 0; column < horizontal; column++) {
+
+      const auto azimuth = (static_cast<double>(column) * horizontal_step - config.FOVHorLeft) * to_radians;
+      const auto i       = row * horizontal + column;
+
+      scan.distance[i]  = std::min(10.0 + 2.0 * std::sin(4 * azimuth) + std::cos(3 * elevation), config.BeamLength);
+      scan.dir_x[i]     = std::cos(elevation) * std::cos(azimuth);
+      scan.dir_y[i]     = std::cos(elevation) * std::sin(azimuth);
+      scan.dir_z[i]     = std::sin(elevation);
+      scan.label[i]     = static_cast<int>(column * 8 / horizontal);
+      scan.intensity[i] = static_cast<int>(100 + i % 50);
+    }
+  }
+}
+
+//}
+
+/* MockReplay::Load() //{ */
+
+bool MockReplay::Load(const std::string& path, uint16_t port) {
+
+  CaptureReader reader;
+  if (!reader.Open(path)) {
+    return false;
+  }
+
+  const auto records = reader.Records();
+
+  if (port == 0) {
+    std::map<uint16_t, size_t> response_bytes;
+
+    for (const auto& record : records) {
+      if (record.direction == CaptureDirection::RESPONSE) {
+        response_bytes[record.port] += record.payload.size();
+      }
+    }
+
+    const auto busiest = std::max_element(response_bytes.begin(), response_bytes.end(),
+                                          [](const auto& a, const auto& b) { return a.second < b.second; });
+
+    port = busiest != response_bytes.end() ? busiest->first : 0;
+  }
+
+  // the responses are paired with their requests by the sequence id, in the other framings by the order of the requests of their type
+  std::map<uint32_t, std::chrono::nanoseconds>                   sequenced_requests;
+  std::map<unsigned short, std::deque<std::chrono::nanoseconds>> pending_requests;
+
+  responses.clear();
+
+  for (const auto& record : records) {
+
+    if (record.port != port) {
+      continue;
+    }
+
+    const auto type = record.MessageType();
+
+    if (record.direction == CaptureDirection::REQUEST) {
+      if (record.sequence != 0) {
+        sequenced_requests[record.sequence] = record.timestamp;
+      } else {
+        pending_requests[type].push_back(record.timestamp);
+      }
+      continue;
+    }
+
+    if (record.direction != CaptureDirection::RESPONSE) {
+      continue;
+    }
+
+    auto requested = record.timestamp;
+
+    if (const auto request = sequenced_requests.find(record.sequence); record.sequence != 0 && request != sequenced_requests.end()) {
+      requested = request->second;
+      sequenced_requests.erase(request);
+    } else if (auto& pending = pending_requests[type]; record.sequence == 0 && !pending.empty()) {
+      requested = pending.front();
+      pending.pop_front();
+    }
+
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(record.timestamp - requested);
+    responses[type].push_back({std::vector<std::byte>(record.payload.begin(), record.payload.end()), latency});
+  }
+
+  return !responses.empty();
+}
+
+//}
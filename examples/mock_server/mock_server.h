@@ -0,0 +1,236 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <flight_forge_connector/compression.h>
+#include <flight_forge_connector/data_types.h>
+#include <flight_forge_connector/framing.h>
+#include <flight_forge_connector/shared_frame_ring.h>
+#include <flight_forge_connector/serialization/serializable_shared.h>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Responses of a capture (see CaptureRecorder) which the drone servers send instead of the synthetic ones.
+ *
+ * The responses are served by their message type in the captured order and from the start again, the types missing in the capture are still
+ * synthesized. The framing and the compression are those of the replaying connection, the pushes of the subscriptions stay synthetic.
+ */
+struct MockReplay
+{
+  struct Response
+  {
+    std::vector<std::byte> payload;
+    // from the request to its response in the capture
+    std::chrono::microseconds latency{0};
+  };
+
+  std::map<unsigned short, std::vector<Response>> responses;
+  // waits the captured latency before each response, reproduces the stalls of the captured session
+  bool timing = false;
+
+  // the responses received from the port, from the port with the most response bytes for 0, which is a drone rather than the game mode
+  bool Load(const std::string& path, uint16_t port = 0);
+};
+
+struct MockServerOptions
+{
+  // initial size of the synthetic RGB and stereo images, 3 bytes per pixel, the camera configs change it
+  int image_width  = 640;
+  int image_height = 480;
+  // initial beam grid of the synthetic lidar scans, the lidar config changes it
+  int lidar_horizontal_rays = 3600;
+  int lidar_vertical_rays   = 1;
+  // pushes per second of the subscriptions which follow the sensor rate, the initial frequency of the lidar config
+  double stream_frequency = 10.0;
+  // waited before every response, the camera and lidar data wait for their render time on top of it
+  std::chrono::microseconds response_delay{0};
+  std::chrono::microseconds camera_delay{0};
+  std::chrono::microseconds lidar_delay{0};
+  // upper bound of the uniformly random time added to every delay
+  std::chrono::microseconds delay_jitter{0};
+  // reported by the game mode
+  float fps = 60.0f;
+  // served by every drone, nullptr synthesizes all the responses
+  std::shared_ptr<const MockReplay> replay;
+};
+
+/**
+ * @brief Local stand-in for the FlightForge simulator, one instance serves either a drone or the game mode.
+ *
+ * Listens on TCP or on a unix socket (UNIX_SOCKET_SCHEME address), speaks all frame modes, batches and compression. A drone server keeps the
+ * pose and the sensor configs of its drone and renders synthetic camera images of the configured size and lidar scans of the configured beam
+ * grid. The game mode server spawns the drone servers on new ports and removes them, it accepts the world settings without any effect.
+ * The responses wait for the configured delays, which stand in for the rendering and the simulation step.
+ *
+ * Each connection is served by its own thread. It is also the reference producer of the shared frames, a connection which enables them gets
+ * its own SharedFrameRing and the camera and lidar bodies are written there instead of to the socket. The subscribed sensors of a sequenced
+ * connection are pushed by a pusher thread of the connection at the requested frequency, or at the sensor rate when asked for.
+ */
+class MockServer {
+public:
+  explicit MockServer(const MockServerOptions& options, bool game_mode = false);
+  ~MockServer();
+
+  MockServer(const MockServer&)            = delete;
+  MockServer& operator=(const MockServer&) = delete;
+
+  bool Listen(const std::string& address, uint16_t port);
+
+  // accepts connections until RequestStop() or Stop()
+  void Run();
+
+  // only flags the accept loop to finish, safe to call from a signal handler
+  void RequestStop();
+
+  // closes the connections and joins their threads, the game mode also stops its drones
+  void Stop();
+
+  // game mode only: starts a drone server on the port, or on the first free one after the last drone for port 0, returns its port or 0
+  int SpawnDrone(uint16_t port = 0, const Coordinates& location = Coordinates{0, 0, 0});
+
+  // game mode only: stops the drone server on the port
+  bool RemoveDrone(int port);
+
+private:
+  // the responses and the pushes of a connection are written by different threads, they share the lock and the negotiated compression
+  struct Writer_
+  {
+    std::mutex             mutex;
+    CompressionOptions     compression;
+    std::vector<std::byte> compressed;
+  };
+
+  struct Connection_
+  {
+    int       fd         = -1;
+    FrameMode frame_mode = FrameMode::SENTINEL;
+    uint32_t  sequence   = 0;
+
+    std::vector<std::byte> request;
+    std::vector<std::byte> response;
+    // the compressed requests are received here and decompressed into the request
+    std::vector<std::byte> compressed_request;
+    // while a batch is handled the replies are appended to its response from this offset on instead of being sent
+    size_t batch_offset = 0;
+
+    SharedFrameRing shared_frames;
+
+    // the synthetic scan of the lidar directions id, only its start follows the drone until the lidar config changes
+    LidarCloud   scan;
+    unsigned int scan_id          = 0;
+    double       scan_beam_length = 0.0;
+
+    std::shared_ptr<Writer_> writer = std::make_shared<Writer_>();
+
+    // pushes per second by the message type of the sensor data
+    std::map<unsigned short, double> subscriptions;
+    std::mutex                       subscriptions_mutex;
+    std::condition_variable          subscriptions_condition;
+    std::thread                      pusher;
+    bool                             pushing = false;
+
+    // the next captured response of the message type
+    std::map<unsigned short, size_t> replay_cursor;
+  };
+
+  // a drone server spawned by the game mode, accepting on its own thread
+  struct Drone_
+  {
+    std::unique_ptr<MockServer> server;
+    std::thread                 thread;
+  };
+
+  // the synthetic images of the current camera configs, replaced as a whole when a config changes
+  struct Images_
+  {
+    std::vector<unsigned char> rgb;
+    std::vector<unsigned char> segmented;
+    std::vector<unsigned char> stereo_left;
+    std::vector<unsigned char> stereo_right;
+  };
+
+  MockServerOptions options_;
+  bool              game_mode_;
+
+  int         listen_fd_ = -1;
+  uint16_t    port_      = 0;
+  std::string address_;
+  std::string unix_path_;
+
+  std::atomic<bool>        running_ = false;
+  mutable std::mutex       mutex_;
+  std::vector<std::thread> threads_;
+  std::vector<int>         connections_;
+
+  // drone state shared by the connections
+  Coordinates location_{0, 0, 0};
+  Rotation    rotation_{0, 0, 0};
+  bool        move_line_visible_ = false;
+
+  Serializable::Drone::LidarConfig        lidar_config_{};
+  Serializable::Drone::RgbCameraConfig    rgb_config_{};
+  Serializable::Drone::StereoCameraConfig stereo_config_{};
+
+  // identifies the beam directions of the lidar config, bumped by every change of it
+  unsigned int lidar_directions_id_ = 1;
+
+  // the requests only copy the images, a connection keeps the previous ones alive while a new config renders them again
+  std::shared_ptr<const Images_> images_;
+
+  // game mode state, the drones by their ports
+  std::map<int, Drone_>                        drones_;
+  Serializable::GameMode::CameraCaptureModeEnum camera_capture_mode_ = Serializable::GameMode::CAPTURE_ALL_FRAMES;
+
+  std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+
+  void Serve_(int fd);
+  bool ReadRequest_(Connection_& connection);
+  bool Handle_(Connection_& connection, std::span<const std::byte> request);
+  bool HandleDrone_(Connection_& connection, std::span<const std::byte> request, unsigned short type);
+  bool HandleGameMode_(Connection_& connection, std::span<const std::byte> request, unsigned short type);
+  bool HandleBatch_(Connection_& connection, std::span<const std::byte> request);
+  bool WriteResponse_(Connection_& connection, size_t size);
+  bool ReplayResponse_(Connection_& connection, const MockReplay::Response& response);
+
+  template <typename TResponse>
+  bool Reply_(Connection_& connection, TResponse& response);
+
+  bool EnableSharedFrames_(Connection_& connection, unsigned int slot_count, unsigned int slot_size);
+
+  // answers the subscribed data requests at their frequency with the sequence id 0, runs on its own thread per connection
+  void Push_(Connection_& connection);
+  void StopPushing_(Connection_& connection);
+
+  // writes the frame body by the fill function into the next slot and replies with its descriptor
+  bool ShareFrame_(Connection_& connection, unsigned short type, size_t size, size_t split, const Coordinates& start,
+                   const std::function<void(std::span<unsigned char>)>& fill);
+
+  // sleeps for the response delay, the render time of the requested data and the jitter
+  void Delay_(std::chrono::microseconds render_time) const;
+
+  // renders the images of the current camera configs, called with the mutex locked
+  void RenderImages_();
+
+  [[nodiscard]] std::shared_ptr<const Images_> GetImages_() const;
+
+  [[nodiscard]] double Stamp_() const;
+  void                 FillScan_(Connection_& connection) const;
+};
+
+}  // namespace ueds_connector
@@ -0,0 +1,49 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Single background thread executing posted tasks in FIFO order.
+ *
+ * Each SocketClient owns one, the thread is started by the first posted task so clients using only the blocking API never spawn it.
+ */
+class AsyncWorker {
+public:
+  AsyncWorker() = default;
+  ~AsyncWorker();
+
+  AsyncWorker(const AsyncWorker&)            = delete;
+  AsyncWorker& operator=(const AsyncWorker&) = delete;
+
+  void Post(std::function<void()> task);
+
+  // runs the already posted tasks to completion and joins the thread, tasks posted afterwards start it again, refused from a task of the
+  // worker itself, which could not join its own thread, so a task must not destroy the owner of its worker either
+  bool Stop();
+
+  [[nodiscard]] bool IsWorkerThread() const;
+
+private:
+  mutable std::mutex                mutex_;
+  std::condition_variable           condition_;
+  std::deque<std::function<void()>> tasks_;
+  std::thread                       thread_;
+  std::thread::id                   worker_id_;
+  bool                              stopping_ = false;
+
+  void Start_();
+
+  void Run_();
+};
+
+}  // namespace ueds_connector
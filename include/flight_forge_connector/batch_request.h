@@ -0,0 +1,167 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <flight_forge_connector/serialization/serializable_extended.h>
+
+// first API version of the server which understands Drone::Batch
+#define BATCH_MIN_API_MAJOR 0
+#define BATCH_MIN_API_MINOR 15
+// initial capacity of the serialized requests, grows on demand
+#define BATCH_BUFFER_SIZE 256
+
+namespace ueds_connector
+{
+
+/* SupportsBatch() //{ */
+
+inline bool SupportsBatch(int api_version_major, int api_version_minor) {
+  return api_version_major > BATCH_MIN_API_MAJOR || (api_version_major == BATCH_MIN_API_MAJOR && api_version_minor >= BATCH_MIN_API_MINOR);
+}
+
+//}
+
+/**
+ * @brief Builder of a Drone::Batch message, the drone requests added to it are executed in order by one round trip (UedsConnector::ExecuteBatch()).
+ *
+ * Every request is paired with the response object it is answered into, e.g. one RL step
+ *
+ *   batch.Clear();
+ *   batch.Add(set_location, set_location_response).Add(camera, camera_response).Add(lidar, lidar_response).Add(crash, crash_response);
+ *
+ * The requests are serialized by Add(), the responses have to stay alive until the batch is executed. The status of every response tells whether
+ * the server executed its request. With the shared frames enabled the camera and lidar requests are answered by Common::FrameDescriptor::Response.
+ * Clear() keeps the buffers, a batch reused for every tick does not allocate once it fits the largest one.
+ */
+class BatchRequest {
+public:
+  BatchRequest() {
+    request_.count = 0;
+    request_.requests.reserve(BATCH_BUFFER_SIZE);
+  }
+
+  template <typename TRequest, typename TResponse>
+  BatchRequest& Add(TRequest& request, TResponse& response) {
+
+    static_assert(std::is_base_of_v<Serializable::Common::NetworkRequest, TRequest>, "batch entries are drone requests");
+    static_assert(std::is_base_of_v<Serializable::Common::NetworkResponse, TResponse>, "batch entries are answered by drone responses");
+
+    auto&      requests = request_.requests;
+    const auto offset   = requests.size();
+
+    // the entry is serialized behind its size prefix, the buffer doubles until it fits
+    requests.resize(std::max(requests.capacity(), offset + BATCH_BUFFER_SIZE));
+
+    while (true) {
+      try {
+        SpanOutputArchive oa(std::as_writable_bytes(std::span<unsigned char>(requests)).subspan(offset + sizeof(uint32_t)));
+        oa(request);
+
+        const auto size = static_cast<uint32_t>(oa.written());
+        std::memcpy(requests.data() + offset, &size, sizeof(size));
+        requests.resize(offset + sizeof(size) + size);
+        break;
+      }
+      catch (SpanOverflow&) {
+        requests.resize(requests.size() * 2);
+      }
+    }
+
+    const auto type = request.type;
+
+    decoders_.push_back([&response, type](std::span<const std::byte> data) {
+      SpanInputArchive ia(data);
+
+      // the server answers the requests it cannot execute by a bare NetworkResponse
+      Serializable::Common::NetworkResponse header{};
+      ia(header);
+
+      if (header.type != type) {
+        throw cereal::Exception("Batch entry answered by type " + std::to_string(header.type) + " instead of " + std::to_string(type));
+      }
+
+      if (!header.status) {
+        response.status = false;
+        return;
+      }
+
+      SpanInputArchive entry(data);
+      entry(response);
+    });
+
+    request_.count++;
+    return *this;
+  }
+
+  void Clear() {
+    request_.count = 0;
+    request_.requests.clear();
+    decoders_.clear();
+    executed_ = false;
+  }
+
+  [[nodiscard]] size_t GetSize() const {
+    return decoders_.size();
+  }
+
+  [[nodiscard]] bool IsEmpty() const {
+    return decoders_.empty();
+  }
+
+  // whether the server executed the last sent batch, the responses are filled in then
+  [[nodiscard]] bool IsExecuted() const {
+    return executed_;
+  }
+
+  // the message to send
+  Serializable::Drone::Batch::Request& GetRequest() {
+    executed_ = false;
+    return request_;
+  }
+
+  // reads the Drone::Batch::Response in place and deserializes its entries into the responses of Add()
+  void load(SpanInputArchive& archive) {
+
+    Serializable::Common::NetworkResponse header{};
+    archive(header);
+
+    // a server without the batch support rejects the whole message
+    if (!header.status) {
+      return;
+    }
+
+    unsigned int      count = 0;
+    cereal::size_type size  = 0;
+    archive(count, cereal::make_size_tag(size));
+
+    if (header.type != Serializable::Drone::MessageType::batch || count != decoders_.size() || size > archive.remaining()) {
+      throw cereal::Exception("Batch response of " + std::to_string(count) + " entries does not match the request of " +
+                              std::to_string(decoders_.size()));
+    }
+
+    for (auto& decoder : decoders_) {
+      uint32_t entry_size = 0;
+      archive(entry_size);
+      decoder(archive.takeBinary(entry_size));
+    }
+
+    executed_ = true;
+  }
+
+private:
+  Serializable::Drone::Batch::Request                          request_;
+  std::vector<std::function<void(std::span<const std::byte>)>> decoders_;
+  bool                                                         executed_ = false;
+};
+
+}  // namespace ueds_connector
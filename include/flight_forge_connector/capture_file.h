@@ -0,0 +1,117 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// space reserved for the records of a capture, the file stays sparse until they are written and is truncated to them when closed
+#define CAPTURE_DEFAULT_CAPACITY (size_t{1} << 32)
+
+namespace ueds_connector
+{
+
+enum class CaptureDirection : uint8_t
+{
+  REQUEST,
+  RESPONSE,
+  // a frame pushed by the server for a subscription
+  PUSH,
+};
+
+// a record of a capture, the payload points into the mapped file
+struct CaptureRecord
+{
+  // since the capture was opened
+  std::chrono::nanoseconds timestamp{0};
+  uint16_t                 port      = 0;
+  CaptureDirection         direction = CaptureDirection::REQUEST;
+  // id of the sequenced framing, 0 in the other framings and for the pushes
+  uint32_t sequence = 0;
+  // size of the frame on the wire, including the frame header and the compression
+  uint32_t wire_size = 0;
+  // the serialized message as the (de)serialization sees it, without framing and uncompressed
+  std::span<const std::byte> payload;
+
+  // NetworkRequest::type or NetworkResponse::type, serialized first by every message
+  [[nodiscard]] unsigned short MessageType() const;
+};
+
+/**
+ * @brief Appends the frames of the clients recording into it (see SocketClient::SetRecorder()) to a memory-mapped capture file.
+ *
+ * The capacity is mapped at once, the writers reserve their records with a single atomic add and copy the payload in without any lock, the
+ * records which do not fit anymore are dropped. Each record is marked complete after its payload, so the capture of a crashed process is read
+ * up to the first unfinished record. Close() waits for nothing, the clients must stop using the recorder first, as the destructor does.
+ */
+class CaptureRecorder {
+public:
+  CaptureRecorder() = default;
+  ~CaptureRecorder();
+
+  CaptureRecorder(const CaptureRecorder&)            = delete;
+  CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+  // creates or replaces the file
+  bool Open(const std::string& path, size_t capacity = CAPTURE_DEFAULT_CAPACITY);
+
+  // truncates the file to the recorded size
+  void Close();
+
+  [[nodiscard]] bool IsOpen() const {
+    return base_ != nullptr;
+  }
+
+  bool Append(uint16_t port, CaptureDirection direction, uint32_t sequence, uint32_t wire_size, std::span<const std::byte> payload);
+
+  // bytes of the file taken by the header and the records
+  [[nodiscard]] size_t GetSize() const {
+    return std::min(offset_.load(std::memory_order_relaxed), capacity_);
+  }
+
+  [[nodiscard]] size_t GetDroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  int                                   fd_       = -1;
+  std::byte*                            base_     = nullptr;
+  size_t                                capacity_ = 0;
+  std::atomic<size_t>                   offset_   = 0;
+  std::atomic<size_t>                   dropped_  = 0;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// maps a capture read-only, valid also while it is still recorded
+class CaptureReader {
+public:
+  CaptureReader() = default;
+  ~CaptureReader();
+
+  CaptureReader(const CaptureReader&)            = delete;
+  CaptureReader& operator=(const CaptureReader&) = delete;
+
+  bool Open(const std::string& path);
+  void Close();
+
+  // the complete records in the order of their reservation, the payloads stay valid until Close()
+  [[nodiscard]] std::vector<CaptureRecord> Records() const;
+
+  // wall clock time of the start of the capture, nanoseconds since the Unix epoch
+  [[nodiscard]] int64_t GetStartTime() const {
+    return start_time_;
+  }
+
+private:
+  const std::byte* base_       = nullptr;
+  size_t           size_       = 0;
+  int64_t          start_time_ = 0;
+};
+
+}  // namespace ueds_connector
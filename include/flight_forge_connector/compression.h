@@ -0,0 +1,378 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// set in the size of a framed message whose payload is compressed, the sizes are limited by MAX_FRAME_SIZE far below it
+#define FRAME_COMPRESSED_FLAG 0x80000000u
+// the compressed payload starts by the little-endian uint32 size of the original payload
+#define COMPRESSED_PAYLOAD_HEADER_SIZE 4
+// payloads below it are sent as they are unless CompressionOptions says otherwise
+#define DEFAULT_COMPRESSION_THRESHOLD 4096
+
+// first API version of the server which understands Common::SetCompression
+#define COMPRESSION_MIN_API_MAJOR 0
+#define COMPRESSION_MIN_API_MINOR 17
+
+// LZ4 block format constants, the last match starts MFLIMIT bytes before the end at the latest and the block ends by LAST_LITERALS literals
+#define LZ4_MIN_MATCH 4
+#define LZ4_MFLIMIT 12
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG 12
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Compression of the framed messages, negotiated per connection by SocketClient::NegotiateCompression().
+ *
+ * Both sides compress the payloads of at least threshold bytes which get smaller by it, e.g. the camera images. The acceleration trades the ratio for
+ * speed, 1 is the default of LZ4 and every step up skips more positions while looking for a match.
+ */
+struct CompressionOptions
+{
+  bool     enabled      = false;
+  uint32_t threshold    = DEFAULT_COMPRESSION_THRESHOLD;
+  int      acceleration = 1;
+};
+
+/* SupportsCompression() //{ */
+
+inline bool SupportsCompression(int api_version_major, int api_version_minor) {
+  return api_version_major > COMPRESSION_MIN_API_MAJOR ||
+         (api_version_major == COMPRESSION_MIN_API_MAJOR && api_version_minor >= COMPRESSION_MIN_API_MINOR);
+}
+
+//}
+
+/* Lz4CompressBound() //{ */
+
+// largest block Lz4Compress() can produce from size bytes
+inline size_t Lz4CompressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+//}
+
+/* Lz4Compress() //{ */
+
+/**
+ * @brief Compresses the source into an LZ4 block (the raw block format, without the LZ4 frame), readable by any LZ4 decoder.
+ *
+ * @return size of the block, 0 if it does not fit into the destination
+ */
+inline size_t Lz4Compress(std::span<const std::byte> source, std::span<std::byte> destination, int acceleration = 1) {
+
+  const auto* const begin = reinterpret_cast<const uint8_t*>(source.data());
+  const auto* const end   = begin + source.size();
+  auto*             out   = reinterpret_cast<uint8_t*>(destination.data());
+  auto* const       limit = out + destination.size();
+
+  const auto read32 = [](const uint8_t* position) {
+    uint32_t value;
+    std::memcpy(&value, position, sizeof(value));
+    return value;
+  };
+
+  const auto hash = [](uint32_t sequence) { return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG); };
+
+  // token, then the length above its nibble in bytes of 255 and the rest
+  const auto write_length = [&out](size_t length) {
+    for (; length >= 255; length -= 255) {
+      *out++ = 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+  };
+
+  // bytes write_length() adds for a literal or match length beyond the nibble of the token
+  const auto length_bytes = [](size_t length) -> size_t { return length >= 15 ? (length - 15) / 255 + 1 : 0; };
+
+  auto        anchor = begin;
+  const auto* input  = begin;
+
+  if (source.size() > LZ4_MFLIMIT) {
+
+    // positions relative to the source, the candidates are verified so the initial zeros do no harm
+    std::array<uint32_t, 1u << LZ4_HASH_LOG> table{};
+
+    const auto* const match_start_limit = end - LZ4_MFLIMIT;
+    const auto* const match_end_limit   = end - LZ4_LAST_LITERALS;
+    const uint32_t    skip_trigger      = static_cast<uint32_t>(std::max(acceleration, 1)) << 6;
+
+    input++;
+
+    while (true) {
+
+      // look for a 4 byte match, the step grows in the incompressible regions
+      const uint8_t* match  = nullptr;
+      uint32_t       search = skip_trigger;
+
+      while (true) {
+
+        if (input > match_start_limit) {
+          goto last_literals;
+        }
+
+        const auto value = read32(input);
+        auto&      slot  = table[hash(value)];
+        match            = begin + slot;
+        slot             = static_cast<uint32_t>(input - begin);
+
+        if (match < input && input - match <= LZ4_MAX_OFFSET && read32(match) == value) {
+          break;
+        }
+
+        input += search++ >> 6;
+      }
+
+      // the match may start earlier
+      while (input > anchor && match > begin && input[-1] == match[-1]) {
+        input--;
+        match--;
+      }
+
+      const auto literals = static_cast<size_t>(input - anchor);
+      const auto offset   = static_cast<uint16_t>(input - match);
+
+      auto* match_end = input + LZ4_MIN_MATCH;
+      match += LZ4_MIN_MATCH;
+
+      // eight bytes at a time, the first differing byte is found from the lowest set bit of the difference (little-endian)
+      while (match_end + sizeof(uint64_t) <= match_end_limit) {
+        uint64_t current, previous;
+        std::memcpy(&current, match_end, sizeof(current));
+        std::memcpy(&previous, match, sizeof(previous));
+
+        const auto difference = current ^ previous;
+        if (difference != 0) {
+          const auto same = static_cast<size_t>(std::countr_zero(difference) / 8);
+          match_end += same;
+          match += same;
+          goto match_found;
+        }
+
+        match_end += sizeof(uint64_t);
+        match += sizeof(uint64_t);
+      }
+
+      while (match_end < match_end_limit && *match_end == *match) {
+        match_end++;
+        match++;
+      }
+
+    match_found:
+
+      const auto match_length = static_cast<size_t>(match_end - input - LZ4_MIN_MATCH);
+
+      if (static_cast<size_t>(limit - out) < 1 + length_bytes(literals) + literals + 2 + length_bytes(match_length)) {
+        return 0;
+      }
+
+      auto* token = out++;
+      *token      = static_cast<uint8_t>((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(match_length, 15));
+
+      if (literals >= 15) {
+        write_length(literals - 15);
+      }
+
+      std::memcpy(out, anchor, literals);
+      out += literals;
+
+      *out++ = static_cast<uint8_t>(offset & 0xff);
+      *out++ = static_cast<uint8_t>(offset >> 8);
+
+      if (match_length >= 15) {
+        write_length(match_length - 15);
+      }
+
+      input  = match_end;
+      anchor = input;
+
+      if (input > match_start_limit) {
+        break;
+      }
+
+      // the position right before the next search is a good candidate for repeating data
+      table[hash(read32(input - 2))] = static_cast<uint32_t>(input - 2 - begin);
+    }
+  }
+
+last_literals:
+
+  // the block always ends by a sequence of literals only
+  const auto literals = static_cast<size_t>(end - anchor);
+
+  if (static_cast<size_t>(limit - out) < 1 + length_bytes(literals) + literals) {
+    return 0;
+  }
+
+  *out++ = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+
+  if (literals >= 15) {
+    write_length(literals - 15);
+  }
+
+  if (literals > 0) {
+    std::memcpy(out, anchor, literals);
+    out += literals;
+  }
+
+  return static_cast<size_t>(out - reinterpret_cast<uint8_t*>(destination.data()));
+}
+
+//}
+
+/* Lz4Decompress() //{ */
+
+/**
+ * @brief Decompresses an LZ4 block into the destination, which has the exact size of the original data.
+ *
+ * Safe for untrusted input, never reads or writes outside of the spans.
+ *
+ * @return true if the block is valid and fills the destination exactly
+ */
+inline bool Lz4Decompress(std::span<const std::byte> source, std::span<std::byte> destination) {
+
+  const auto*       input     = reinterpret_cast<const uint8_t*>(source.data());
+  const auto* const input_end = input + source.size();
+  auto*             out       = reinterpret_cast<uint8_t*>(destination.data());
+  auto* const       out_begin = out;
+  auto* const       out_end   = out + destination.size();
+
+  const auto read_length = [&input, input_end](size_t& length) {
+    uint8_t next = 255;
+    while (next == 255) {
+      if (input >= input_end) {
+        return false;
+      }
+      next = *input++;
+      length += next;
+    }
+    return true;
+  };
+
+  while (input < input_end) {
+
+    const auto token    = *input++;
+    size_t     literals = token >> 4;
+
+    if (literals == 15 && !read_length(literals)) {
+      return false;
+    }
+
+    if (literals > static_cast<size_t>(input_end - input) || literals > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+
+    if (literals > 0) {
+      std::memcpy(out, input, literals);
+      input += literals;
+      out += literals;
+    }
+
+    // the last sequence has no match
+    if (input == input_end) {
+      break;
+    }
+
+    if (input_end - input < 2) {
+      return false;
+    }
+
+    const size_t offset = input[0] | (input[1] << 8);
+    input += 2;
+
+    size_t match_length = token & 0x0f;
+
+    if (match_length == 15 && !read_length(match_length)) {
+      return false;
+    }
+
+    match_length += LZ4_MIN_MATCH;
+
+    if (offset == 0 || offset > static_cast<size_t>(out - out_begin) || match_length > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+
+    const auto* match = out - offset;
+
+    if (offset >= match_length) {
+      std::memcpy(out, match, match_length);
+      out += match_length;
+      continue;
+    }
+
+    // overlapping match repeats the last offset bytes, the copied chunk doubles with every step
+    auto* const match_end = out + match_length;
+
+    while (out < match_end) {
+      const auto chunk = std::min(static_cast<size_t>(out - match), static_cast<size_t>(match_end - out));
+      std::memcpy(out, match, chunk);
+      out += chunk;
+    }
+  }
+
+  return out == out_end;
+}
+
+//}
+
+/* CompressPayload() //{ */
+
+/**
+ * @brief Writes the compressed payload (its original size and the LZ4 block) to the destination.
+ *
+ * @return size of the compressed payload, 0 if it would not be smaller than the original one
+ */
+inline size_t CompressPayload(std::span<const std::byte> payload, std::span<std::byte> destination, int acceleration) {
+
+  if (destination.size() <= COMPRESSED_PAYLOAD_HEADER_SIZE || payload.size() <= COMPRESSED_PAYLOAD_HEADER_SIZE) {
+    return 0;
+  }
+
+  const auto limit = std::min(destination.size(), payload.size()) - COMPRESSED_PAYLOAD_HEADER_SIZE;
+  const auto size  = Lz4Compress(payload, destination.subspan(COMPRESSED_PAYLOAD_HEADER_SIZE, limit), acceleration);
+
+  if (size == 0) {
+    return 0;
+  }
+
+  const auto original = static_cast<uint32_t>(payload.size());
+  for (size_t i = 0; i < COMPRESSED_PAYLOAD_HEADER_SIZE; i++) {
+    destination[i] = static_cast<std::byte>((original >> (8 * i)) & 0xff);
+  }
+
+  return COMPRESSED_PAYLOAD_HEADER_SIZE + size;
+}
+
+//}
+
+/* CompressedPayloadSize() //{ */
+
+// size of the original payload, 0 if the compressed one is too short
+inline uint32_t CompressedPayloadSize(std::span<const std::byte> compressed) {
+
+  if (compressed.size() <= COMPRESSED_PAYLOAD_HEADER_SIZE) {
+    return 0;
+  }
+
+  uint32_t size = 0;
+  for (size_t i = 0; i < COMPRESSED_PAYLOAD_HEADER_SIZE; i++) {
+    size |= static_cast<uint32_t>(compressed[i]) << (8 * i);
+  }
+
+  return size;
+}
+
+//}
+
+}  // namespace ueds_connector
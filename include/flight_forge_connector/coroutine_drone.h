@@ -0,0 +1,83 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <flight_forge_connector/data_types.h>
+#include <flight_forge_connector/event_loop.h>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Drone connection served by an EventLoop, the requests are awaitable from coroutines.
+ *
+ *   Task<void> Mission(CoroutineDrone& drone) {
+ *     auto location = co_await drone.GetLocationAsync().WithTimeout(std::chrono::milliseconds(100));
+ *     if (!location) { ... }
+ *   }
+ *
+ * The out-parameters (images, lidar clouds) must stay alive until the request is awaited or the loop finishes.
+ */
+class CoroutineDrone {
+public:
+  CoroutineDrone(EventLoop& loop, const std::string& address, uint16_t port);
+  ~CoroutineDrone();
+
+  CoroutineDrone(const CoroutineDrone&)            = delete;
+  CoroutineDrone& operator=(const CoroutineDrone&) = delete;
+
+  // blocking connect and framing handshake, see FleetReactor::AddDrone()
+  bool Connect(FrameMode frame_mode = FrameMode::SEQUENCED);
+
+  bool Disconnect();
+
+  [[nodiscard]] bool IsConnected() const;
+
+  RequestAwaitable<Coordinates> GetLocationAsync();
+
+  RequestAwaitable<Rotation> GetRotationAsync();
+
+  RequestAwaitable<bool> GetCrashStateAsync();
+
+  // teleported to, is hit, impact point
+  RequestAwaitable<std::tuple<Coordinates, bool, Coordinates>> SetLocationAsync(const Coordinates& coordinates, bool checkCollisions);
+
+  // rotated to, is hit, impact point
+  RequestAwaitable<std::tuple<Rotation, bool, Coordinates>> SetRotationAsync(const Rotation& rotation);
+
+  // yields the stamp of the image
+  RequestAwaitable<double> GetRgbCameraDataAsync(std::vector<unsigned char>& image);
+
+  RequestAwaitable<double> GetStereoCameraDataAsync(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right);
+
+  RequestAwaitable<double> GetRgbSegmentedAsync(std::vector<unsigned char>& image);
+
+  RequestAwaitable<double> GetRangefinderDataAsync();
+
+  RequestAwaitable<void> GetLidarDataAsync(LidarCloud& cloud);
+
+  RequestAwaitable<void> GetLidarSegDataAsync(LidarCloud& cloud);
+
+  RequestAwaitable<void> GetLidarIntDataAsync(LidarCloud& cloud);
+
+  uint16_t getPort() const {
+    return port_;
+  }
+
+  std::string getAddress() const {
+    return address_;
+  }
+
+private:
+  EventLoop&  loop_;
+  std::string address_;
+  uint16_t    port_;
+  int         drone_ = -1;
+};
+
+}  // namespace ueds_connector
@@ -0,0 +1,170 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace ueds_connector
+{
+
+template <typename T>
+class Task;
+
+namespace detail
+{
+
+/* TaskPromiseBase //{ */
+
+struct TaskPromiseBase
+{
+  std::coroutine_handle<> continuation;
+  std::exception_ptr      exception;
+
+  // the finished task resumes the coroutine awaiting it without growing the stack
+  struct FinalAwaiter
+  {
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    template <typename TPromise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> handle) noexcept {
+      const auto continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  std::suspend_always initial_suspend() const noexcept {
+    return {};
+  }
+
+  FinalAwaiter final_suspend() const noexcept {
+    return {};
+  }
+
+  void unhandled_exception() noexcept {
+    exception = std::current_exception();
+  }
+};
+
+//}
+
+/* TaskPromise //{ */
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase
+{
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+
+  template <typename TValue>
+  void return_value(TValue&& result) {
+    value.emplace(std::forward<TValue>(result));
+  }
+
+  T Result() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+    return std::move(*value);
+  }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept {
+  }
+
+  void Result() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+//}
+
+}  // namespace detail
+
+/**
+ * @brief Lazily started coroutine, it runs when awaited (or when spawned on an EventLoop) and resumes the awaiting coroutine when it finishes.
+ */
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() = default;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+  }
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  Task(const Task&)            = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  [[nodiscard]] bool Done() const {
+    return !handle_ || handle_.done();
+  }
+
+  bool await_ready() const noexcept {
+    return !handle_ || handle_.done();
+  }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+
+  T await_resume() {
+    return handle_.promise().Result();
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle_ = nullptr;
+};
+
+namespace detail
+{
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+}  // namespace detail
+
+}  // namespace ueds_connector
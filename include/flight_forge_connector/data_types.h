@@ -5,6 +5,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace ueds_connector
 {
@@ -166,6 +167,48 @@ struct LidarIntData
   }
 };
 
+/**
+ * @brief Lidar scan stored as a struct of arrays, one contiguous array per beam attribute.
+ *
+ * label is filled by GetLidarSegData only, intensity by GetLidarIntData only, they are empty otherwise.
+ */
+struct LidarCloud
+{
+  LidarCloud() = default;
+
+  Coordinates start{};
+
+  std::vector<double> distance;
+  std::vector<double> dir_x;
+  std::vector<double> dir_y;
+  std::vector<double> dir_z;
+
+  std::vector<int> label;
+  std::vector<int> intensity;
+
+  size_t size() const {
+    return distance.size();
+  }
+
+  bool empty() const {
+    return distance.empty();
+  }
+
+  // keeps the capacity, repeated scans of the same size do not allocate
+  void resize(size_t size) {
+    distance.resize(size);
+    dir_x.resize(size);
+    dir_y.resize(size);
+    dir_z.resize(size);
+  }
+
+  void clear() {
+    resize(0);
+    label.clear();
+    intensity.clear();
+  }
+};
+
 struct LidarConfig
 {
   LidarConfig() = default;
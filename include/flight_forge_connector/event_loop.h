@@ -0,0 +1,281 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <flight_forge_connector/coroutine_task.h>
+#include <flight_forge_connector/fleet_reactor.h>
+
+namespace ueds_connector
+{
+
+enum class AwaitStatus
+{
+  PENDING,
+  OK,
+  // the request failed, the drone disconnected or the response could not be deserialized
+  FAILED,
+  TIMEOUT,
+  CANCELLED,
+};
+
+/* AwaitResult //{ */
+
+template <typename T>
+struct AwaitResult
+{
+  AwaitStatus status = AwaitStatus::PENDING;
+  T           value{};
+
+  explicit operator bool() const {
+    return status == AwaitStatus::OK;
+  }
+};
+
+template <>
+struct AwaitResult<void>
+{
+  AwaitStatus status = AwaitStatus::PENDING;
+
+  explicit operator bool() const {
+    return status == AwaitStatus::OK;
+  }
+};
+
+//}
+
+/* CancellationToken //{ */
+
+/**
+ * @brief Shared cancellation flag, the copies refer to the same state. Cancel() resolves every operation awaiting with the token as CANCELLED.
+ *
+ * A default constructed token is never cancelled. Like the rest of the event loop it must only be used on the thread running the loop.
+ */
+class CancellationToken {
+public:
+  CancellationToken() = default;
+
+  static CancellationToken Create();
+
+  void Cancel();
+
+  [[nodiscard]] bool IsCancelled() const {
+    return state_ && state_->cancelled;
+  }
+
+  [[nodiscard]] bool CanBeCancelled() const {
+    return state_ != nullptr;
+  }
+
+  // internal, used by the awaitables
+  uint64_t Register_(std::function<void()> callback);
+  void     Unregister_(uint64_t registration);
+
+private:
+  struct State_
+  {
+    bool                                                    cancelled         = false;
+    uint64_t                                                next_registration = 1;
+    std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+  };
+
+  std::shared_ptr<State_> state_;
+};
+
+//}
+
+class EventLoop;
+
+namespace detail
+{
+
+/* AwaitOperation //{ */
+
+// shared state of a suspended operation, resolved exactly once by the response, the timer or the cancellation
+struct AwaitOperation : std::enable_shared_from_this<AwaitOperation>
+{
+  EventLoop*              loop   = nullptr;
+  AwaitStatus             status = AwaitStatus::PENDING;
+  std::coroutine_handle<> handle = nullptr;
+  uint64_t                timer  = 0;
+  CancellationToken       token;
+  uint64_t                registration = 0;
+
+  void Resolve(AwaitStatus result);
+
+  // the timer resolves the operation with timer_status, it is not started for a zero timeout
+  void Suspend(std::coroutine_handle<> awaiting, std::chrono::milliseconds timeout, AwaitStatus timer_status);
+};
+
+//}
+
+}  // namespace detail
+
+/**
+ * @brief Single-threaded event loop resuming coroutines on the completions of a FleetReactor driven in the manual mode, and on timers.
+ *
+ * Every coroutine is resumed from Run()/RunOnce(), so the mission code of dozens of drones runs sequentially on one thread without locking.
+ */
+class EventLoop {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  EventLoop() = default;
+
+  EventLoop(const EventLoop&)            = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  FleetReactor& GetReactor() {
+    return reactor_;
+  }
+
+  // starts the task on the next loop iteration, the loop keeps it alive until it finishes
+  void Spawn(Task<void> task);
+
+  // runs until all spawned tasks finish
+  void Run();
+
+  // one iteration, waits at most timeout_ms for I/O when no coroutine is ready, returns false once all spawned tasks finished
+  bool RunOnce(int timeout_ms);
+
+  [[nodiscard]] size_t GetActiveTaskCount() const {
+    return active_tasks_;
+  }
+
+  // internal, used by the awaitables
+  void     Schedule_(std::coroutine_handle<> handle);
+  uint64_t AddTimer_(Clock::time_point deadline, std::function<void()> callback);
+  void     CancelTimer_(uint64_t timer);
+
+private:
+  FleetReactor reactor_;
+
+  std::deque<std::coroutine_handle<>> ready_;
+  size_t                              active_tasks_ = 0;
+
+  uint64_t                                                                next_timer_ = 1;
+  std::map<std::pair<Clock::time_point, uint64_t>, std::function<void()>> timers_;
+  std::unordered_map<uint64_t, Clock::time_point>                         timer_deadlines_;
+
+  void ResumeReady_();
+  void FireTimers_();
+  int  NextTimeout_(int timeout_ms) const;
+};
+
+/* RequestAwaitable //{ */
+
+/**
+ * @brief Result of a drone request, co_await yields AwaitResult<T>.
+ *
+ * The request is submitted when the awaitable is created, so several requests created before awaiting the first one are pipelined on the
+ * connection. The timeout counts from the co_await, a timed out or cancelled request drops its late response.
+ */
+template <typename T>
+class [[nodiscard]] RequestAwaitable {
+public:
+  using Value   = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+  using Decoder = std::function<bool(std::span<const std::byte>, Value&)>;
+
+  template <typename TRequest>
+  RequestAwaitable(EventLoop& loop, int drone, TRequest& request, Decoder decoder) : state_(std::make_shared<State_>()) {
+
+    state_->loop = &loop;
+
+    auto completion = [state = state_, decoder = std::move(decoder)](bool success, std::span<const std::byte> payload) {
+      if (state->status != AwaitStatus::PENDING) {
+        return;
+      }
+      success = success && decoder(payload, state->value);
+      state->Resolve(success ? AwaitStatus::OK : AwaitStatus::FAILED);
+    };
+
+    const auto submitted = loop.GetReactor().Submit(drone, request, std::move(completion));
+
+    if (!submitted) {
+      state_->status = AwaitStatus::FAILED;
+    }
+  }
+
+  RequestAwaitable& WithTimeout(std::chrono::milliseconds timeout) {
+    timeout_ = timeout;
+    return *this;
+  }
+
+  RequestAwaitable& WithCancellation(const CancellationToken& token) {
+    state_->token = token;
+    return *this;
+  }
+
+  bool await_ready() const {
+    return state_->status != AwaitStatus::PENDING || state_->token.IsCancelled();
+  }
+
+  void await_suspend(std::coroutine_handle<> awaiting) {
+    state_->Suspend(awaiting, timeout_, AwaitStatus::TIMEOUT);
+  }
+
+  AwaitResult<T> await_resume() {
+
+    if (state_->status == AwaitStatus::PENDING) {
+      state_->Resolve(AwaitStatus::CANCELLED);
+    }
+
+    AwaitResult<T> result;
+    result.status = state_->status;
+
+    if constexpr (!std::is_void_v<T>) {
+      result.value = std::move(state_->value);
+    }
+
+    return result;
+  }
+
+private:
+  struct State_ : detail::AwaitOperation
+  {
+    Value value{};
+  };
+
+  std::shared_ptr<State_>   state_;
+  std::chrono::milliseconds timeout_{0};
+};
+
+//}
+
+/* SleepAwaitable //{ */
+
+// co_await Sleep(...) yields AwaitResult<void>, OK after the delay or CANCELLED
+class [[nodiscard]] SleepAwaitable {
+public:
+  SleepAwaitable(EventLoop& loop, std::chrono::milliseconds delay, const CancellationToken& token);
+
+  bool await_ready() const;
+
+  void await_suspend(std::coroutine_handle<> awaiting);
+
+  AwaitResult<void> await_resume();
+
+private:
+  std::shared_ptr<detail::AwaitOperation> state_;
+  std::chrono::milliseconds               delay_;
+};
+
+SleepAwaitable Sleep(EventLoop& loop, std::chrono::milliseconds delay, const CancellationToken& token = {});
+
+//}
+
+}  // namespace ueds_connector
@@ -0,0 +1,243 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <flight_forge_connector/framing.h>
+#include <flight_forge_connector/receive_buffer.h>
+#include <flight_forge_connector/serialization/serializable_extended.h>
+
+// maximal number of socket events handled by a single Poll()
+#define REACTOR_MAX_EVENTS 64
+// timeout of the blocking framing handshake done by AddDrone()
+#define REACTOR_HANDSHAKE_TIMEOUT_MS 1000
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Serves the connections of many drones from one thread, the sockets are non-blocking and multiplexed by epoll (Linux only).
+ *
+ * Every drone has its own queue of requests, they are written back to back without waiting for the responses and the responses are matched back
+ * by the sequence id (FrameMode::SEQUENCED) or in the submission order (FrameMode::LENGTH_PREFIXED). The sentinel framing is not supported.
+ *
+ * Submit() may be called from any thread, the completions run on the thread calling Poll(), either the application thread or the one started by
+ * Start(). A completion may submit further requests, it must not block on a future of the same reactor.
+ */
+class FleetReactor {
+public:
+  // called with the payload of the response, success is false when the drone disconnected or was removed before the response arrived
+  using Completion = std::function<void(bool success, std::span<const std::byte> payload)>;
+
+  // called on the polling thread when the connection of a drone is lost
+  using DisconnectCallback = std::function<void(int drone)>;
+
+  FleetReactor();
+  ~FleetReactor();
+
+  FleetReactor(const FleetReactor&)            = delete;
+  FleetReactor& operator=(const FleetReactor&) = delete;
+
+  /**
+   * @brief Connects to the drone server and switches the connection to the given framing, blocks for at most the handshake.
+   *
+   * @param frame_mode FrameMode::LENGTH_PREFIXED or FrameMode::SEQUENCED, the server has to support it (see SupportsFrameMode())
+   *
+   * @return drone handle used by the other methods, -1 on failure
+   */
+  int AddDrone(const std::string& address, uint16_t port, FrameMode frame_mode = FrameMode::SEQUENCED);
+
+  // closes the connection, the pending requests complete unsuccessfully
+  bool RemoveDrone(int drone);
+
+  [[nodiscard]] bool IsConnected(int drone) const;
+
+  [[nodiscard]] size_t GetPendingCount(int drone) const;
+
+  void SetDisconnectCallback(DisconnectCallback callback);
+
+  // queues the serialized request, returns false if the drone is unknown or disconnected
+  template <typename TRequest>
+  bool Submit(int drone, TRequest& request, Completion completion) {
+
+    std::scoped_lock lock(mutex_);
+
+    auto it = drones_.find(drone);
+    if (it == drones_.end() || it->second->fd < 0) {
+      return false;
+    }
+
+    auto& connection = *it->second;
+
+    const auto sequence    = connection.next_sequence;
+    const auto header_size = FrameHeaderSize(connection.frame_mode);
+    size_t     reserve     = SEND_CHUNK_SIZE_;
+
+    while (true) {
+
+      const auto destination = PrepareSend_(connection, header_size + reserve);
+
+      try {
+        SpanOutputArchive oa(destination.subspan(header_size));
+        oa(request);
+
+        if (connection.frame_mode == FrameMode::SEQUENCED) {
+          WriteSequencedFrameHeader(destination.data(), static_cast<uint32_t>(oa.written()), sequence);
+        } else {
+          WriteFrameHeader(destination.data(), static_cast<uint32_t>(oa.written()));
+        }
+
+        connection.send_size += header_size + oa.written();
+        break;
+      }
+      catch (SpanOverflow&) {
+        if (destination.size() >= MAX_FRAME_SIZE) {
+          return false;
+        }
+        reserve = destination.size() * 2;
+      }
+      catch (cereal::Exception& exception) {
+        std::cerr << "FLEET-REACTOR serialization error: " << exception.what() << std::endl;
+        return false;
+      }
+    }
+
+    if (++connection.next_sequence == 0) {
+      connection.next_sequence = 1;
+    }
+
+    connection.pending.push_back(Pending_{sequence, std::move(completion)});
+    MarkDirty_(connection);
+
+    return true;
+  }
+
+  // the response is deserialized into the caller-owned object, which has to stay alive until the callback runs
+  template <typename TRequest, typename TResponse>
+  bool Submit(int drone, TRequest& request, TResponse& response, std::function<void(bool)> callback) {
+    return Submit(drone, request, [&response, callback = std::move(callback)](bool success, std::span<const std::byte> payload) {
+      callback(success && Deserialize_(payload, response));
+    });
+  }
+
+  // the future holds false and a default constructed response on failure
+  template <typename TResponse, typename TRequest>
+  std::future<std::pair<bool, TResponse>> Submit(int drone, TRequest& request) {
+
+    auto promise = std::make_shared<std::promise<std::pair<bool, TResponse>>>();
+    auto future  = promise->get_future();
+
+    const auto submitted = Submit(drone, request, [promise](bool success, std::span<const std::byte> payload) {
+      TResponse response{};
+      success = success && Deserialize_(payload, response);
+      promise->set_value(std::make_pair(success, std::move(response)));
+    });
+
+    if (!submitted) {
+      promise->set_value(std::make_pair(false, TResponse{}));
+    }
+
+    return future;
+  }
+
+  /**
+   * @brief Sends the queued requests, receives the available responses and runs their completions.
+   *
+   * @param timeout_ms maximal time to wait for socket activity, -1 waits indefinitely, Wakeup() interrupts the wait
+   *
+   * @return number of completed requests
+   */
+  int Poll(int timeout_ms);
+
+  // runs Poll() on an own thread until Stop()
+  void Start();
+
+  void Stop();
+
+  // interrupts a Poll() waiting for socket activity
+  void Wakeup();
+
+private:
+  static constexpr size_t SEND_CHUNK_SIZE_ = 256;
+
+  struct Pending_
+  {
+    uint32_t   sequence = 0;
+    Completion completion;
+  };
+
+  struct Connection_
+  {
+    int       id            = -1;
+    int       fd            = -1;
+    FrameMode frame_mode    = FrameMode::SEQUENCED;
+    uint32_t  next_sequence = 1;
+
+    // send_buffer[send_offset, send_size) holds the frames not written to the socket yet
+    std::vector<std::byte> send_buffer;
+    size_t                 send_offset = 0;
+    size_t                 send_size   = 0;
+    bool                   dirty       = false;
+    bool                   write_armed = false;
+
+    ReceiveBuffer        receive_buffer;
+    std::deque<Pending_> pending;
+  };
+
+  mutable std::mutex                                     mutex_;
+  std::unordered_map<int, std::shared_ptr<Connection_>> drones_;
+  std::vector<std::shared_ptr<Connection_>>              dirty_;
+  int                                                    next_id_ = 0;
+
+  int epoll_fd_  = -1;
+  int wakeup_fd_ = -1;
+
+  DisconnectCallback disconnect_callback_;
+
+  std::thread       thread_;
+  std::atomic<bool> running_ = false;
+  std::thread::id   polling_thread_;
+
+  template <typename TResponse>
+  static bool Deserialize_(std::span<const std::byte> payload, TResponse& response) {
+
+    try {
+      SpanInputArchive ia(payload);
+      ia(response);
+
+      return true;
+    }
+    catch (cereal::Exception& exception) {
+      std::cerr << "FLEET-REACTOR deserialization error: " << exception.what() << std::endl;
+    }
+
+    return false;
+  }
+
+  // returns the free tail of the send buffer, at least min_size bytes
+  static std::span<std::byte> PrepareSend_(Connection_& connection, size_t min_size);
+
+  void MarkDirty_(Connection_& connection);
+  void FlushDirty_();
+  bool WriteConnection_(Connection_& connection);
+  int  ReadConnection_(const std::shared_ptr<Connection_>& connection, std::unique_lock<std::mutex>& lock, std::vector<Pending_>& failed);
+  void CloseConnection_(Connection_& connection, std::vector<Pending_>& failed);
+  bool Handshake_(int fd, FrameMode frame_mode);
+};
+
+}  // namespace ueds_connector
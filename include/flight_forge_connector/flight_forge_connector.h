@@ -3,10 +3,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include <flight_forge_connector/batch_request.h>
 #include <flight_forge_connector/data_types.h>
+#include <flight_forge_connector/lidar_directions.h>
+#include <flight_forge_connector/lidar_quantization.h>
+#include <flight_forge_connector/sensor_stream.h>
+#include <flight_forge_connector/shared_frame_ring.h>
 #include <flight_forge_connector/socket_client.h>
 
 namespace ueds_connector
@@ -21,6 +34,10 @@ public:
   UedsConnector(const std::string& address, uint16_t port) : SocketClient(address, port) {
   }
 
+  ~UedsConnector() override {
+    StopBackgroundWork_();
+  }
+
   std::pair<bool, Coordinates> GetLocation();
 
   std::pair<bool, bool> GetCrashState();
@@ -33,6 +50,13 @@ public:
 
   std::tuple<bool, std::vector<unsigned char>, double, uint32_t> GetRgbSegmented();
 
+  // the image is received into the caller-owned buffer, no reallocation happens while the resolution stays the same
+  bool GetRgbCameraData(std::vector<unsigned char>& image, double& stamp);
+
+  bool GetStereoCameraData(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right, double& stamp);
+
+  bool GetRgbSegmented(std::vector<unsigned char>& image, double& stamp);
+
   std::pair<bool, Rotation> GetRotation();
 
   std::tuple<bool, Rotation, bool, Coordinates> SetRotation(const Rotation& rotation);
@@ -49,10 +73,53 @@ public:
   
   std::tuple<bool, std::vector<LidarIntData>, Coordinates> GetLidarIntData();
 
+  // struct-of-arrays variants filled directly by the deserializer, the arrays of the cloud are reused between scans
+  bool GetLidarData(LidarCloud& cloud);
+
+  bool GetLidarSegData(LidarCloud& cloud);
+
+  bool GetLidarIntData(LidarCloud& cloud);
+
   std::pair<bool, LidarConfig> GetLidarConfig();
 
   bool SetLidarConfig(const LidarConfig& config);
 
+  /**
+   * @brief Switches the lidar requests to the scans without the beam directions if the server API version supports it.
+   *
+   * The directions are requested once and cached, every scan then carries the distances (and the labels or intensities) only, about a quarter of
+   * the data. The cache is dropped by SetLidarConfig() and refilled whenever the server reports another pattern. The Livox pattern changes with
+   * every scan, the server refuses such scans and the connector returns to the full ones. The shared frames keep the full scans.
+   *
+   * @return true if the lidar scans are requested without the directions after the call
+   */
+  bool EnableLidarDistanceOnly(const std::pair<int, int>& api_version);
+
+  void DisableLidarDistanceOnly();
+
+  [[nodiscard]] bool IsUsingLidarDistanceOnly() const {
+    return lidar_distance_only_;
+  }
+
+  /**
+   * @brief Switches the lidar requests to the quantized scans if the server API version supports it, takes precedence over the distance-only ones.
+   *
+   * The ranges travel as uint16 steps of the resolution, the labels as uint8 or uint16 and the intensities as uint8, with the directions of the
+   * cached table (see EnableLidarDistanceOnly()) about 3 bytes per beam instead of 36. They are dequantized by the vectorized kernels of
+   * lidar_quantization.h straight from the receive buffer.
+   *
+   * @param resolution meters per step, 0 lets the server cover LidarConfig::beamLength (about 1.5 mm for 100 m)
+   *
+   * @return true if the lidar scans are requested quantized after the call
+   */
+  bool EnableLidarQuantization(const std::pair<int, int>& api_version, double resolution = 0.0);
+
+  void DisableLidarQuantization();
+
+  [[nodiscard]] bool IsUsingLidarQuantization() const {
+    return lidar_quantization_;
+  }
+
   std::pair<bool, RgbCameraConfig> GetRgbCameraConfig();
 
   bool SetRgbCameraConfig(const RgbCameraConfig& config);
@@ -64,6 +131,164 @@ public:
   std::pair<bool, bool> GetMoveLineVisible();
 
   bool SetMoveLineVisible(bool visible);
+
+  /**
+   * @brief Sends the requests of the batch in one message, the server executes them in order and answers all of them in one response.
+   *
+   * Requires the API version of SupportsBatch(), e.g. the set location, camera, lidar and crash state requests of one RL step cost a single round
+   * trip instead of four.
+   *
+   * @return true if the server executed the batch, the status of every response tells the result of its request
+   */
+  bool ExecuteBatch(BatchRequest& batch);
+
+  // asynchronous variants, executed on the I/O thread of this connector (see SocketClient::RunAsync()), the out-parameters must stay alive until the
+  // future is ready. SetLocationAndRotationAsync() above is the simulator side non-blocking teleport, run it through RunAsync() if needed.
+  std::future<std::pair<bool, Coordinates>> GetLocationAsync();
+
+  std::future<std::pair<bool, Rotation>> GetRotationAsync();
+
+  std::future<std::pair<bool, bool>> GetCrashStateAsync();
+
+  std::future<std::tuple<bool, Coordinates, bool, Coordinates>> SetLocationAsync(const Coordinates& coordinates, bool checkCollisions);
+
+  std::future<std::tuple<bool, Rotation, bool, Coordinates>> SetRotationAsync(const Rotation& rotation);
+
+  std::future<std::tuple<bool, std::vector<unsigned char>, double, uint32_t>> GetRgbCameraDataAsync();
+
+  std::future<bool> GetRgbCameraDataAsync(std::vector<unsigned char>& image, double& stamp);
+
+  std::future<bool> GetStereoCameraDataAsync(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right, double& stamp);
+
+  std::future<bool> GetRgbSegmentedAsync(std::vector<unsigned char>& image, double& stamp);
+
+  std::future<std::tuple<bool, double>> GetRangefinderDataAsync();
+
+  std::future<bool> GetLidarDataAsync(LidarCloud& cloud);
+
+  std::future<bool> GetLidarSegDataAsync(LidarCloud& cloud);
+
+  std::future<bool> GetLidarIntDataAsync(LidarCloud& cloud);
+
+  std::future<bool> ExecuteBatchAsync(BatchRequest& batch);
+
+  /**
+   * @brief Moves the bodies of the camera and lidar frames to a shared memory ring created by the server, the socket then carries only descriptors.
+   *
+   * Works with a server on the same host only, the connection keeps the socket transfer otherwise. The regular camera and lidar methods stay
+   * available and copy the frame out of the ring, the *Frame methods below hand out views of the ring without any copy. Enable it before the
+   * connector is used from several threads, the ring is released on Disconnect().
+   *
+   * @param api_version (major, minor) as reported by GameModeController::GetApiVersion()
+   * @param slot_count number of frames in the ring, has to exceed the number of frames in flight and held as views at the same time
+   * @param slot_size size of the largest frame body, 0 lets the server derive it from its sensor configuration
+   *
+   * @return true if the frames are received through the shared memory after the call
+   */
+  bool EnableSharedFrames(const std::pair<int, int>& api_version, uint32_t slot_count = SHARED_FRAMES_DEFAULT_SLOTS, uint32_t slot_size = 0);
+
+  bool DisableSharedFrames();
+
+  [[nodiscard]] bool IsUsingSharedFrames() const {
+    return shared_frames_.IsOpen();
+  }
+
+  // zero-copy frames, require EnableSharedFrames(), check view.IsValid() after processing the data
+  bool GetRgbCameraFrame(SharedFrameView& view);
+
+  // the left image is view.GetFirst(), the right one view.GetSecond()
+  bool GetStereoCameraFrame(SharedFrameView& view);
+
+  bool GetRgbSegmentedFrame(SharedFrameView& view);
+
+  // the beams are packed as on the wire, see Serializable::Drone::LidarCloudResponse::beam_size, the scan origin is view.GetStart()
+  bool GetLidarDataFrame(SharedFrameView& view);
+
+  bool GetLidarSegDataFrame(SharedFrameView& view);
+
+  bool GetLidarIntDataFrame(SharedFrameView& view);
+
+  /**
+   * @brief Asks the server to push the data of the sensor as it is produced, no request is needed per frame.
+   *
+   * Requires the SEQUENCED framing (see NegotiateFrameMode()) and the API version of SupportsSubscriptions(). The pushes always carry the whole
+   * frame over the socket. The callback runs on the push receiver thread of the connector, one frame after another, it may use the connector but
+   * a slow callback delays the frames of all streams and gets only the last STREAM_CALLBACK_PENDING_FRAMES of its own. Subscribing a stream
+   * again replaces its subscription, the subscriptions are restored after a reconnect.
+   *
+   * @param frequency pushes per second, 0 follows the rate of the sensor (LidarConfig::Frequency for the lidar)
+   */
+  bool Subscribe(SensorStream stream, std::function<void(const StreamFrame&)> callback, double frequency = 0.0);
+
+  // as above, the frames are put into the queue, which drops its oldest frame when the consumer does not keep up
+  bool Subscribe(SensorStream stream, std::shared_ptr<StreamQueue> queue, double frequency = 0.0);
+
+  bool Unsubscribe(SensorStream stream);
+
+  [[nodiscard]] bool IsSubscribed(SensorStream stream) const;
+
+protected:
+  void OnConnectionReset_() override;
+
+  std::string TraceLabel_() const override {
+    return "drone";
+  }
+
+  // re-applies the sensor configs, the shared frames and the subscriptions set before, a restarted simulator spawns the drone with the default ones
+  bool OnReconnected_() override;
+
+  void OnPushMessage_(std::span<const std::byte> message) override;
+  void OnPushesReceived_() override;
+
+private:
+  SharedFrameRing shared_frames_;
+
+  struct SharedFramesSettings_
+  {
+    std::pair<int, int> api_version;
+    uint32_t            slot_count = 0;
+    uint32_t            slot_size  = 0;
+  };
+
+  // last successfully applied settings, written by the application threads and read by the reconnect on the I/O thread
+  std::mutex                           settings_mutex_;
+  std::optional<LidarConfig>           lidar_config_;
+  std::optional<RgbCameraConfig>       rgb_camera_config_;
+  std::optional<StereoCameraConfig>    stereo_camera_config_;
+  std::optional<bool>                  move_line_visible_;
+  std::optional<SharedFramesSettings_> shared_frames_settings_;
+
+  struct Subscription_
+  {
+    double                                  frequency = 0.0;
+    std::function<void(const StreamFrame&)> callback;
+    std::shared_ptr<StreamQueue>            queue;
+  };
+
+  std::atomic<bool>   lidar_distance_only_ = false;
+  std::mutex          lidar_directions_mutex_;
+  LidarDirectionTable lidar_directions_;
+
+  std::atomic<bool>   lidar_quantization_            = false;
+  std::atomic<double> lidar_quantization_resolution_ = 0.0;
+
+  // source is the message type of the full scan, extra the label or intensity array of the cloud
+  bool GetLidarScan_(unsigned short source, LidarCloud& cloud);
+  bool GetLidarDistances_(unsigned short source, LidarCloud& cloud, std::vector<int>* extra);
+  bool GetLidarQuantized_(unsigned short source, LidarCloud& cloud, std::vector<int>* extra);
+  // fills the directions of the scan from the cached table, fetches the table first if the scan refers to another one
+  bool ApplyLidarDirections_(uint32_t table_id, LidarCloud& cloud);
+
+  mutable std::mutex                    stream_mutex_;
+  std::map<SensorStream, Subscription_> subscriptions_;
+  // frames of the callback subscriptions, delivered by the push receiver outside of the connection lock, bounded per stream
+  std::deque<StreamFrame> pending_frames_;
+
+  bool Subscribe_(SensorStream stream, Subscription_ subscription);
+  bool RequestSubscription_(SensorStream stream, double frequency);
+
+  template <typename TRequest>
+  bool RequestSharedFrame_(SharedFrameView& view);
 };
 
 }  // namespace ueds_connector
@@ -0,0 +1,97 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define END_OF_MESSAGE_LENGTH 3
+
+#define FRAME_HEADER_SIZE 4
+// size + sequence id
+#define SEQUENCED_FRAME_HEADER_SIZE 8
+#define MAX_FRAME_SIZE (512u * 1024u * 1024u)
+// maximal number of requests waiting for a response on a single connection in the sequenced framing
+#define MAX_IN_FLIGHT_REQUESTS 16
+
+// first API version of the server which understands Common::SetFrameMode
+#define FRAME_MODE_MIN_API_MAJOR 0
+#define FRAME_MODE_MIN_API_MINOR 12
+// first API version of the server which understands FrameMode::SEQUENCED
+#define SEQUENCED_FRAME_MODE_MIN_API_MINOR 13
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Wire framing of the messages exchanged with the simulator.
+ *
+ * SENTINEL is the legacy framing, the response is terminated by END_OF_MESSAGE_LENGTH x END_OF_MESSAGE and requests are sent as raw payload.
+ * LENGTH_PREFIXED prepends a little-endian uint32 payload size (FRAME_HEADER_SIZE bytes) to every message in both directions.
+ * SEQUENCED follows the size by a little-endian uint32 sequence id (SEQUENCED_FRAME_HEADER_SIZE bytes). The server echoes the id of the request in its
+ * response, so several requests can be in flight on one connection and the responses are matched back by id. The id 0 is never used by requests.
+ */
+enum FrameMode : unsigned short
+{
+  SENTINEL        = 0x0,
+  LENGTH_PREFIXED = 0x1,
+  SEQUENCED       = 0x2,
+};
+
+/* FrameHeaderSize() //{ */
+
+inline size_t FrameHeaderSize(FrameMode frame_mode) {
+  switch (frame_mode) {
+    case FrameMode::LENGTH_PREFIXED:
+      return FRAME_HEADER_SIZE;
+    case FrameMode::SEQUENCED:
+      return SEQUENCED_FRAME_HEADER_SIZE;
+    default:
+      return 0;
+  }
+}
+
+//}
+
+/* WriteFrameHeader() //{ */
+
+inline void WriteFrameHeader(std::byte* destination, uint32_t payload_size) {
+  destination[0] = static_cast<std::byte>(payload_size & 0xff);
+  destination[1] = static_cast<std::byte>((payload_size >> 8) & 0xff);
+  destination[2] = static_cast<std::byte>((payload_size >> 16) & 0xff);
+  destination[3] = static_cast<std::byte>((payload_size >> 24) & 0xff);
+}
+
+//}
+
+/* WriteSequencedFrameHeader() //{ */
+
+inline void WriteSequencedFrameHeader(std::byte* destination, uint32_t payload_size, uint32_t sequence) {
+  WriteFrameHeader(destination, payload_size);
+  WriteFrameHeader(destination + FRAME_HEADER_SIZE, sequence);
+}
+
+//}
+
+/* ReadFrameHeader() //{ */
+
+inline uint32_t ReadFrameHeader(const std::byte* source) {
+  return static_cast<uint32_t>(source[0]) | (static_cast<uint32_t>(source[1]) << 8) | (static_cast<uint32_t>(source[2]) << 16) |
+         (static_cast<uint32_t>(source[3]) << 24);
+}
+
+//}
+
+/* SupportsFrameMode() //{ */
+
+inline bool SupportsFrameMode(int api_version_major, int api_version_minor, FrameMode frame_mode = FrameMode::LENGTH_PREFIXED) {
+
+  const int min_minor = frame_mode == FrameMode::SEQUENCED ? SEQUENCED_FRAME_MODE_MIN_API_MINOR : FRAME_MODE_MIN_API_MINOR;
+
+  return api_version_major > FRAME_MODE_MIN_API_MAJOR || (api_version_major == FRAME_MODE_MIN_API_MAJOR && api_version_minor >= min_minor);
+}
+
+//}
+
+}  // namespace ueds_connector
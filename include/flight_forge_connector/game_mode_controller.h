@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <future>
 #include <string>
 #include <vector>
 
@@ -10,9 +11,13 @@
 #include <flight_forge_connector/socket_client.h>
 #include <flight_forge_connector/serialization/serializable_shared.h>
 
+// the oldest server API the connector talks to, the newer features check their own *_MIN_API_* versions
 #define API_VERSION_MAJOR 0
 #define API_VERSION_MINOR 11
 
+// the newest server API the features of the connector know
+#define API_VERSION_LATEST_MINOR 19
+
 namespace ueds_connector
 {
 
@@ -23,6 +28,10 @@ public:
   GameModeController(const std::string& address, uint16_t port) : SocketClient(address, port) {
   }
 
+  ~GameModeController() override {
+    StopBackgroundWork_();
+  }
+
   std::pair<bool, std::vector<int>> GetDrones();
 
   std::pair<bool, int> SpawnDrone();
@@ -39,6 +48,16 @@ public:
 
   std::pair<bool, std::pair<int,int>> GetApiVersion();
 
+  using SocketClient::NegotiateFrameMode;
+
+  // queries the server API version and switches this connection to the requested framing when supported
+  bool NegotiateFrameMode(FrameMode frame_mode = FrameMode::LENGTH_PREFIXED);
+
+  using SocketClient::NegotiateCompression;
+
+  // queries the server API version and applies the compression options to this connection when supported
+  bool NegotiateCompression(const CompressionOptions& options);
+
   std::pair<bool, double> GetTime();
   
   bool SetGraphicsSettings(const int& graphicsSettings);
@@ -56,6 +75,22 @@ public:
   bool SetDatetime(const int& hour, const int& minute);
 
   bool SetMutualDroneVisibility(const bool& enabled);
+
+  // asynchronous variants, executed on the I/O thread of this controller (see SocketClient::RunAsync())
+  std::future<std::pair<bool, std::vector<int>>> GetDronesAsync();
+
+  std::future<std::pair<bool, int>> SpawnDroneAsync();
+
+  std::future<bool> RemoveDroneAsync(const int port);
+
+  std::future<std::pair<bool, float>> GetFpsAsync();
+
+  std::future<std::pair<bool, double>> GetTimeAsync();
+
+protected:
+  std::string TraceLabel_() const override {
+    return "game mode";
+  }
 };
 
 }  // namespace ueds_connector
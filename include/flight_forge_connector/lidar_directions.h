@@ -0,0 +1,62 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <flight_forge_connector/data_types.h>
+
+// first API version of the server which sends the lidar scans without the beam directions
+#define LIDAR_DISTANCES_MIN_API_MAJOR 0
+#define LIDAR_DISTANCES_MIN_API_MINOR 18
+
+namespace ueds_connector
+{
+
+/* SupportsLidarDistances() //{ */
+
+inline bool SupportsLidarDistances(int api_version_major, int api_version_minor) {
+  return api_version_major > LIDAR_DISTANCES_MIN_API_MAJOR ||
+         (api_version_major == LIDAR_DISTANCES_MIN_API_MAJOR && api_version_minor >= LIDAR_DISTANCES_MIN_API_MINOR);
+}
+
+//}
+
+/**
+ * @brief Beam directions of a fixed lidar pattern, received once per config and combined with the distance-only scans.
+ *
+ * The directions of the non-Livox lidars depend on LidarConfig only (the rays and the FOV), the server identifies the current pattern by the id
+ * it sends with every scan.
+ */
+struct LidarDirectionTable
+{
+  uint32_t            id    = 0;
+  bool                valid = false;
+  std::vector<double> dir_x;
+  std::vector<double> dir_y;
+  std::vector<double> dir_z;
+
+  [[nodiscard]] size_t size() const {
+    return dir_x.size();
+  }
+
+  // whether the scan of the given table id and number of beams can use the cached directions
+  [[nodiscard]] bool Matches(uint32_t table_id, size_t beams) const {
+    return valid && id == table_id && size() == beams;
+  }
+
+  void Invalidate() {
+    valid = false;
+  }
+
+  // copies the directions into the cloud, whose distances are already filled in
+  void Apply(LidarCloud& cloud) const {
+    cloud.dir_x.assign(dir_x.begin(), dir_x.end());
+    cloud.dir_y.assign(dir_y.begin(), dir_y.end());
+    cloud.dir_z.assign(dir_z.begin(), dir_z.end());
+  }
+};
+
+}  // namespace ueds_connector
@@ -0,0 +1,49 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// first API version of the server which sends the quantized lidar scans
+#define LIDAR_QUANTIZED_MIN_API_MAJOR 0
+#define LIDAR_QUANTIZED_MIN_API_MINOR 19
+// quantization steps within the beam length, the distances beyond it become the largest range, which is past the beam length as well
+#define LIDAR_RANGE_STEPS 65534u
+
+namespace ueds_connector
+{
+
+/* SupportsLidarQuantization() //{ */
+
+inline bool SupportsLidarQuantization(int api_version_major, int api_version_minor) {
+  return api_version_major > LIDAR_QUANTIZED_MIN_API_MAJOR ||
+         (api_version_major == LIDAR_QUANTIZED_MIN_API_MAJOR && api_version_minor >= LIDAR_QUANTIZED_MIN_API_MINOR);
+}
+
+//}
+
+/* LidarRangeResolution() //{ */
+
+// meters per quantization step covering the beam length (LidarConfig::beamLength), about 1.5 mm for 100 m
+inline double LidarRangeResolution(double beam_length) {
+  return beam_length / LIDAR_RANGE_STEPS;
+}
+
+//}
+
+// rounds the distances to the steps of the resolution, clamped to uint16
+void QuantizeRanges(std::span<const double> distance, double resolution, std::span<uint16_t> ranges);
+
+// converts the quantized ranges as received (packed little-endian uint16, no alignment) to the distances of LidarCloud, vectorized
+void DequantizeRanges(std::span<const std::byte> ranges, double resolution, std::span<double> distance);
+
+// widens the packed uint8 (value_size 1) or little-endian uint16 (value_size 2) labels or intensities, vectorized
+void WidenLidarValues(std::span<const std::byte> values, size_t value_size, std::span<int> out);
+
+// name of the instruction set the quantization kernels were compiled for ("avx2", "sse2" or "scalar")
+const char* LidarQuantizationBackend();
+
+}  // namespace ueds_connector
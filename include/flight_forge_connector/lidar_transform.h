@@ -0,0 +1,56 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <flight_forge_connector/data_types.h>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Rigid transform of lidar points, p' = rotation * p + translation.
+ *
+ * Rotations follow the Unreal rotator convention (pitch, yaw, roll in degrees), as used by Rotation and LidarConfig::orientation.
+ */
+struct LidarTransform
+{
+  // row-major 3x3 rotation matrix
+  std::array<double, 9> rotation{1, 0, 0, 0, 1, 0, 0, 0, 1};
+  Coordinates           translation{0, 0, 0};
+
+  static LidarTransform Identity();
+
+  static LidarTransform FromPose(const Coordinates& translation, const Rotation& rotation);
+
+  // sensor frame to the drone body frame, uses LidarConfig::offset and LidarConfig::orientation
+  static LidarTransform SensorToBody(const LidarConfig& config);
+
+  // sensor frame to the world frame, start is the scan origin reported by the simulator (LidarCloud::start)
+  static LidarTransform SensorToWorld(const Coordinates& start, const LidarConfig& config, const Rotation& drone_rotation);
+
+  // composition, (a * b)(p) == a(b(p))
+  LidarTransform operator*(const LidarTransform& other) const;
+};
+
+/**
+ * @brief Converts a lidar scan to interleaved XYZ points in one vectorized pass.
+ *
+ * Every beam becomes transform * (distance * direction), the directions are expected in the sensor frame. Beams without a return (distance <= 0 or
+ * distance >= max_range, typically LidarConfig::beamLength) are written as NaN so the output keeps the beam order of the scan.
+ *
+ * @param xyz resized to 3 * cloud.size(), the capacity is reused between calls
+ *
+ * @return number of valid points
+ */
+size_t LidarCloudToPoints(const LidarCloud& cloud, const LidarTransform& transform, double max_range, std::vector<float>& xyz);
+
+size_t LidarCloudToPoints(const LidarCloud& cloud, const LidarTransform& transform, double max_range, std::vector<double>& xyz);
+
+// name of the instruction set the lidar kernels were compiled for ("avx2", "sse2" or "scalar")
+const char* LidarSimdBackend();
+
+}  // namespace ueds_connector
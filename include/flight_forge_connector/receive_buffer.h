@@ -0,0 +1,61 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Growable receive buffer reused across requests of a single connection.
+ *
+ * The socket writes directly into the writable tail (PrepareWrite() + Commit()), the deserializer reads the readable head in place (Readable()) and
+ * Consume() releases it. The storage only grows, so once it fits the largest message of the session no further heap allocation happens.
+ */
+class ReceiveBuffer {
+public:
+  ReceiveBuffer() = default;
+
+  // returns a writable region of at least min_size bytes after the readable data
+  std::span<std::byte> PrepareWrite(size_t min_size);
+
+  void Commit(size_t size);
+
+  void Consume(size_t size);
+
+  void Clear();
+
+  [[nodiscard]] std::span<const std::byte> Readable() const {
+    return {storage_.data() + read_position_, write_position_ - read_position_};
+  }
+
+  [[nodiscard]] size_t ReadableSize() const {
+    return write_position_ - read_position_;
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return read_position_ == write_position_;
+  }
+
+  [[nodiscard]] size_t Capacity() const {
+    return storage_.size();
+  }
+
+  // number of times the storage had to be (re)allocated since construction
+  [[nodiscard]] size_t GetAllocationCount() const {
+    return allocation_count_;
+  }
+
+private:
+  std::vector<std::byte> storage_;
+
+  size_t read_position_    = 0;
+  size_t write_position_   = 0;
+  size_t allocation_count_ = 0;
+};
+
+}  // namespace ueds_connector
@@ -0,0 +1,177 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// log2 buckets of nanoseconds, the last one collects everything from 2^38 ns (about 4.5 minutes) up
+#define METRICS_HISTOGRAM_BUCKETS 40
+// distinct message types of one client, the protocol of a connection uses far fewer
+#define METRICS_MAX_MESSAGE_TYPES 64
+// key of the requests without a NetworkRequest::type
+#define METRICS_UNKNOWN_TYPE 0xffff
+
+namespace ueds_connector
+{
+
+enum class RequestStage
+{
+  SERIALIZE,
+  // the send() calls including the compression of the frame
+  SEND,
+  // from the start of the wait until the first byte of the response is readable, zero for a response received ahead
+  WAIT,
+  // from the first byte until the whole response frame is received (and decompressed)
+  RECEIVE,
+  DESERIALIZE,
+  COUNT,
+};
+
+const char* RequestStageName(RequestStage stage);
+
+/**
+ * @brief Log2-bucketed histogram of durations, bucket i counts the durations of [2^(i-1), 2^i) ns, bucket 0 the ones below 1 ns.
+ */
+struct LatencyHistogram
+{
+  std::array<uint64_t, METRICS_HISTOGRAM_BUCKETS> buckets{};
+
+  uint64_t count    = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns   = 0;
+
+  // upper bound of the bucket holding the fraction (e.g. 0.99) of the durations, at most 2x the exact percentile
+  [[nodiscard]] std::chrono::nanoseconds Percentile(double fraction) const;
+
+  [[nodiscard]] std::chrono::nanoseconds Mean() const {
+    return std::chrono::nanoseconds(count > 0 ? total_ns / count : 0);
+  }
+};
+
+// snapshot of the metrics of one message type
+struct MessageMetrics
+{
+  unsigned short type = 0;
+
+  uint64_t requests       = 0;
+  uint64_t request_bytes  = 0;
+  uint64_t responses      = 0;
+  uint64_t response_bytes = 0;
+  // the failures other than the timeouts
+  uint64_t errors   = 0;
+  uint64_t timeouts = 0;
+
+  std::array<LatencyHistogram, static_cast<size_t>(RequestStage::COUNT)> stages;
+
+  [[nodiscard]] const LatencyHistogram& Stage(RequestStage stage) const {
+    return stages[static_cast<size_t>(stage)];
+  }
+};
+
+/**
+ * @brief Lock-free per message type counters and stage histograms of the requests of one SocketClient.
+ *
+ * Disabled by default, the requests then only check the flag. Once enabled the slots of the message types are claimed on their first use and
+ * updated with relaxed atomics, Snapshot() reads them without stopping the requests, so a snapshot taken during a request may miss a part of it.
+ */
+class RequestMetrics {
+public:
+  RequestMetrics() = default;
+  ~RequestMetrics();
+
+  RequestMetrics(const RequestMetrics&)            = delete;
+  RequestMetrics& operator=(const RequestMetrics&) = delete;
+
+  // the collected metrics are kept when disabled
+  void SetEnabled(bool enabled);
+
+  [[nodiscard]] bool IsEnabled() const {
+    return enabled_.load(std::memory_order_acquire);
+  }
+
+  void RecordStage(unsigned short type, RequestStage stage, std::chrono::nanoseconds duration);
+  void RecordRequest(unsigned short type, uint64_t bytes);
+  void RecordResponse(unsigned short type, uint64_t bytes);
+  void RecordFailure(unsigned short type, bool timeout);
+
+  // the message types seen so far ordered by type
+  [[nodiscard]] std::vector<MessageMetrics> Snapshot() const;
+
+  void Reset();
+
+  /**
+   * @brief Calls the sink with a snapshot every interval on a thread of its own until StopDump(), replaces the previous dump.
+   *
+   * Without a sink the snapshot is printed to std::cerr by PrintMetrics().
+   */
+  void StartDump(std::chrono::milliseconds interval, std::function<void(const std::vector<MessageMetrics>&)> sink = nullptr);
+
+  void StopDump();
+
+private:
+  struct Counter_
+  {
+    std::atomic<uint64_t> value = 0;
+
+    void Add(uint64_t amount) {
+      value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t Load() const {
+      return value.load(std::memory_order_relaxed);
+    }
+  };
+
+  struct Histogram_
+  {
+    std::array<Counter_, METRICS_HISTOGRAM_BUCKETS> buckets;
+
+    Counter_              count;
+    Counter_              total_ns;
+    std::atomic<uint64_t> max_ns = 0;
+  };
+
+  struct Slot_
+  {
+    // type + 1, 0 marks a free slot
+    std::atomic<uint32_t> key = 0;
+
+    Counter_ requests;
+    Counter_ request_bytes;
+    Counter_ responses;
+    Counter_ response_bytes;
+    Counter_ errors;
+    Counter_ timeouts;
+
+    std::array<Histogram_, static_cast<size_t>(RequestStage::COUNT)> stages;
+  };
+
+  std::atomic<bool> enabled_ = false;
+  // allocated by the first SetEnabled(true) and kept until destruction, the requests use it without a lock
+  std::unique_ptr<Slot_[]> slots_;
+  mutable std::mutex       slots_mutex_;
+
+  std::thread             dump_thread_;
+  std::mutex              dump_mutex_;
+  std::condition_variable dump_condition_;
+  bool                    dumping_ = false;
+
+  // nullptr if the table is full
+  Slot_* FindSlot_(unsigned short type);
+};
+
+// one line per message type with the counts and the p50/p99/max of the stages in microseconds
+void PrintMetrics(std::ostream& out, const std::vector<MessageMetrics>& metrics);
+
+}  // namespace ueds_connector
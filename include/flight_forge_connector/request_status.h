@@ -0,0 +1,43 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+namespace ueds_connector
+{
+
+enum class RequestStatus
+{
+  OK,
+  // no response until the deadline, the connection stays usable and the late response is skipped
+  TIMEOUT,
+  // not connected, the in-flight limit is reached or the socket failed
+  SEND_FAILED,
+  RECEIVE_FAILED,
+  // the response does not match the expected message
+  DESERIALIZATION_FAILED,
+};
+
+/* RequestStatusName() //{ */
+
+inline const char* RequestStatusName(RequestStatus status) {
+
+  switch (status) {
+    case RequestStatus::OK:
+      return "ok";
+    case RequestStatus::TIMEOUT:
+      return "timeout";
+    case RequestStatus::SEND_FAILED:
+      return "send failed";
+    case RequestStatus::RECEIVE_FAILED:
+      return "receive failed";
+    case RequestStatus::DESERIALIZATION_FAILED:
+      return "deserialization failed";
+    default:
+      return "unknown";
+  }
+}
+
+//}
+
+}  // namespace ueds_connector
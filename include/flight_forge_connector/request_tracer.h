@@ -0,0 +1,111 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <flight_forge_connector/request_status.h>
+
+// events kept per thread, 24 bytes each, the oldest ones are overwritten
+#define TRACE_THREAD_BUFFER_EVENTS 32768
+
+namespace ueds_connector
+{
+
+enum class TraceKind : uint8_t
+{
+  // a blocking Request() from the send to the deserialized response
+  REQUEST,
+  SUBMIT,
+  COLLECT,
+};
+
+/**
+ * @brief Records the begin and end of the requests of the clients using it into per-thread rings, exported as Chrome trace events.
+ *
+ * Every thread writes its own ring of the last events without any lock, the export reads the rings meanwhile and skips the events the writers
+ * overwrote during the read. The connections appear as processes of the trace (pid = port) labeled by their clients, the threads as their
+ * threads, so a stalled fleet shows which thread waits on which connection. A request still waiting stays an unfinished slice.
+ *
+ * One tracer is usually shared by all the clients of a process, see SocketClient::SetTracer(). View the output in https://ui.perfetto.dev.
+ */
+class RequestTracer {
+public:
+  explicit RequestTracer(size_t thread_buffer_events = TRACE_THREAD_BUFFER_EVENTS);
+  ~RequestTracer();
+
+  RequestTracer(const RequestTracer&)            = delete;
+  RequestTracer& operator=(const RequestTracer&) = delete;
+
+  // enabled from the construction, a disabled tracer keeps the recorded events
+  void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // names the connection in the trace, e.g. "drone 8080"
+  void RegisterConnection(uint16_t port, const std::string& label);
+
+  void Begin(TraceKind kind, uint16_t port, unsigned short type, uint32_t sequence = 0);
+  void End(TraceKind kind, uint16_t port, unsigned short type, RequestStatus status, uint32_t sequence = 0);
+
+  // the Chrome trace_event JSON of the events recorded since the construction or the last Clear()
+  void WriteChromeTrace(std::ostream& out) const;
+  bool WriteChromeTrace(const std::string& path) const;
+
+  void Clear();
+
+private:
+  struct Event_
+  {
+    std::atomic<uint64_t> timestamp = 0;
+    // type, port, kind, phase and status packed by PackEvent_()
+    std::atomic<uint64_t> data     = 0;
+    std::atomic<uint32_t> sequence = 0;
+  };
+
+  struct ThreadBuffer_
+  {
+    ThreadBuffer_(size_t capacity, uint32_t tid) : events(std::make_unique<Event_[]>(capacity)), capacity(capacity), tid(tid) {
+    }
+
+    std::unique_ptr<Event_[]> events;
+    size_t                    capacity;
+    uint32_t                  tid;
+
+    // number of events ever written, published after the event
+    std::atomic<uint64_t> head = 0;
+    // the events before it were cleared
+    std::atomic<uint64_t> start = 0;
+  };
+
+  // tells the tracers apart in the thread-local cache of the buffers
+  const uint64_t                              id_;
+  const size_t                                thread_buffer_events_;
+  const std::chrono::steady_clock::time_point epoch_   = std::chrono::steady_clock::now();
+  std::atomic<bool>                           enabled_ = true;
+
+  // the buffers outlive their threads, so their events can be exported later
+  mutable std::mutex                          buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer_>> buffers_;
+  std::map<std::thread::id, ThreadBuffer_*>   thread_buffers_;
+  std::map<uint16_t, std::string>             connections_;
+
+  ThreadBuffer_* GetThreadBuffer_();
+  void           Record_(char phase, TraceKind kind, uint16_t port, unsigned short type, RequestStatus status, uint32_t sequence);
+};
+
+}  // namespace ueds_connector
@@ -0,0 +1,137 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <flight_forge_connector/data_types.h>
+
+// first API version of the server which pushes the subscribed sensor data
+#define SUBSCRIPTIONS_MIN_API_MAJOR 0
+#define SUBSCRIPTIONS_MIN_API_MINOR 16
+// frames kept by a StreamQueue unless its constructor is given another capacity
+#define STREAM_QUEUE_DEFAULT_CAPACITY 4
+// frames of a callback subscription waiting for its callback, the oldest one is dropped when a new one does not fit
+#define STREAM_CALLBACK_PENDING_FRAMES 4
+
+namespace ueds_connector
+{
+
+/* SupportsSubscriptions() //{ */
+
+inline bool SupportsSubscriptions(int api_version_major, int api_version_minor) {
+  return api_version_major > SUBSCRIPTIONS_MIN_API_MAJOR ||
+         (api_version_major == SUBSCRIPTIONS_MIN_API_MAJOR && api_version_minor >= SUBSCRIPTIONS_MIN_API_MINOR);
+}
+
+//}
+
+enum class SensorStream
+{
+  LIDAR,
+  LIDAR_SEG,
+  LIDAR_INT,
+  RANGEFINDER,
+  RGB_CAMERA,
+  RGB_SEGMENTED,
+  STEREO_CAMERA,
+};
+
+/* StreamFrame //{ */
+
+// one pushed sensor frame, only the members of its stream are filled in
+struct StreamFrame
+{
+  SensorStream stream = SensorStream::LIDAR;
+
+  // lidar streams, the labels or intensities are filled in for the seg and int variants
+  LidarCloud cloud;
+
+  // camera streams, the left image of the stereo camera is in image
+  std::vector<unsigned char> image;
+  std::vector<unsigned char> image_right;
+  double                     stamp = 0.0;
+
+  double range = 0.0;
+};
+
+//}
+
+/**
+ * @brief Bounded queue of pushed frames, the oldest frame is dropped when a new one does not fit.
+ *
+ * Filled by the connector and drained by the application, a consumer slower than the sensor always gets the most recent frames.
+ */
+class StreamQueue {
+public:
+  explicit StreamQueue(size_t capacity = STREAM_QUEUE_DEFAULT_CAPACITY) : capacity_(capacity > 0 ? capacity : 1) {
+  }
+
+  StreamQueue(const StreamQueue&)            = delete;
+  StreamQueue& operator=(const StreamQueue&) = delete;
+
+  void Push(StreamFrame&& frame) {
+
+    {
+      std::scoped_lock lock(mutex_);
+
+      if (frames_.size() >= capacity_) {
+        frames_.pop_front();
+        dropped_++;
+      }
+
+      frames_.push_back(std::move(frame));
+    }
+
+    condition_.notify_one();
+  }
+
+  // waits at most timeout for a frame, returns false if none came
+  bool Pop(StreamFrame& frame, std::chrono::milliseconds timeout) {
+
+    std::unique_lock lock(mutex_);
+
+    if (!condition_.wait_for(lock, timeout, [this] { return !frames_.empty(); })) {
+      return false;
+    }
+
+    frame = std::move(frames_.front());
+    frames_.pop_front();
+
+    return true;
+  }
+
+  bool TryPop(StreamFrame& frame) {
+    return Pop(frame, std::chrono::milliseconds(0));
+  }
+
+  [[nodiscard]] size_t GetSize() const {
+    std::scoped_lock lock(mutex_);
+    return frames_.size();
+  }
+
+  [[nodiscard]] size_t GetCapacity() const {
+    return capacity_;
+  }
+
+  // frames dropped so far because the consumer did not keep up
+  [[nodiscard]] size_t GetDroppedCount() const {
+    std::scoped_lock lock(mutex_);
+    return dropped_;
+  }
+
+private:
+  const size_t            capacity_;
+  mutable std::mutex      mutex_;
+  std::condition_variable condition_;
+  std::deque<StreamFrame> frames_;
+  size_t                  dropped_ = 0;
+};
+
+}  // namespace ueds_connector
@@ -5,7 +5,52 @@
 
 #include <memory>
 #include <flight_forge_connector/data_types.h>
+#include <flight_forge_connector/lidar_quantization.h>
 #include <flight_forge_connector/serialization/serializable_shared.h>
+#include <flight_forge_connector/serialization/span_archive.h>
+
+namespace ueds_connector
+{
+
+// requests without fields of their own are just the NetworkRequest::type on the wire
+template <class T>
+struct fixed_wire_size<T, std::enable_if_t<std::is_base_of_v<Serializable::Common::NetworkRequest, T> &&
+                                           sizeof(T) == sizeof(Serializable::Common::NetworkRequest)>> : wire_size_of<unsigned short>
+{
+};
+
+// pose streaming requests, sizes follow the member lists of their serialize()
+template <>
+struct fixed_wire_size<Serializable::Drone::SetLocation::Request> : wire_size_of<unsigned short, double, double, double, bool>
+{
+};
+
+template <>
+struct fixed_wire_size<Serializable::Drone::SetRotation::Request> : wire_size_of<unsigned short, double, double, double>
+{
+};
+
+template <>
+struct fixed_wire_size<Serializable::Drone::SetLocationAndRotation::Request>
+    : wire_size_of<unsigned short, double, double, double, double, double, double, bool>
+{
+};
+
+template <>
+struct fixed_wire_size<Serializable::Drone::SetLocationAndRotationAsync::Request>
+    : wire_size_of<unsigned short, double, double, double, double, double, double, bool>
+{
+};
+
+}  // namespace ueds_connector
+
+// lidar beams are four doubles on the wire as well as in memory, the whole scan is loaded with one memcpy
+template <>
+struct ueds_connector::is_wire_packed<Serializable::Drone::GetLidarData::LidarData> : std::true_type
+{
+  static_assert(sizeof(Serializable::Drone::GetLidarData::LidarData) == 4 * sizeof(double));
+  static_assert(std::is_trivially_copyable_v<Serializable::Drone::GetLidarData::LidarData>);
+};
 
 namespace Serializable::GameMode::GetWorldOrigin
 {
@@ -88,3 +133,230 @@ inline std::unique_ptr<Request> ToRequest(const ueds_connector::Coordinates& loc
   return request;
 }
 }  // namespace Serializable::Drone::SetLocationAndRotationAsync
+
+/* LidarCloudResponse //{ */
+
+namespace Serializable::Drone
+{
+
+/**
+ * @brief Reads the GetLidarData, GetLidarSegData and GetLidarIntData responses straight into the arrays of a ueds_connector::LidarCloud.
+ *
+ * The wire layout is the one of the regular responses, TExtra selects the int array receiving the per-beam label/intensity (nullptr for none).
+ */
+template <unsigned short TType, std::vector<int> ueds_connector::LidarCloud::*TExtra>
+struct LidarCloudResponse : public Common::NetworkResponse
+{
+  explicit LidarCloudResponse(ueds_connector::LidarCloud& _cloud) : Common::NetworkResponse(TType), cloud(_cloud) {
+  }
+
+  ueds_connector::LidarCloud& cloud;
+
+  static constexpr size_t beam_size = 4 * sizeof(double) + (TExtra != nullptr ? sizeof(int) : 0);
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+
+    archive(cereal::base_class<Common::NetworkResponse>(this), cloud.start.x, cloud.start.y, cloud.start.z);
+
+    cereal::size_type size = cloud.size();
+    archive(cereal::make_size_tag(size));
+
+    if constexpr (std::is_same_v<Archive, ueds_connector::SpanInputArchive>) {
+
+      if (size > archive.remaining() / beam_size) {
+        throw cereal::Exception("Lidar scan of " + std::to_string(size) + " beams does not fit into the remaining " + std::to_string(archive.remaining()) +
+                                " bytes");
+      }
+
+      LoadBeams(cloud, archive.takeBinary(size * beam_size));
+    } else {
+
+      if constexpr (Archive::is_loading::value) {
+        Resize_(cloud, size);
+      }
+
+      for (size_t i = 0; i < size; i++) {
+        archive(cloud.distance[i], cloud.dir_x[i], cloud.dir_y[i], cloud.dir_z[i]);
+        if constexpr (TExtra != nullptr) {
+          archive((cloud.*TExtra)[i]);
+        }
+      }
+    }
+  }
+
+  // fills the cloud from the packed beams, also used for the scans received through the shared frames
+  static void LoadBeams(ueds_connector::LidarCloud& cloud, std::span<const std::byte> beams) {
+
+    const auto size = beams.size() / beam_size;
+    Resize_(cloud, size);
+
+    // de-interleave the beams in a single pass over the receive buffer
+    const auto* beam = beams.data();
+    for (size_t i = 0; i < size; i++, beam += beam_size) {
+      std::memcpy(&cloud.distance[i], beam, sizeof(double));
+      std::memcpy(&cloud.dir_x[i], beam + sizeof(double), sizeof(double));
+      std::memcpy(&cloud.dir_y[i], beam + 2 * sizeof(double), sizeof(double));
+      std::memcpy(&cloud.dir_z[i], beam + 3 * sizeof(double), sizeof(double));
+      if constexpr (TExtra != nullptr) {
+        std::memcpy(&(cloud.*TExtra)[i], beam + 4 * sizeof(double), sizeof(int));
+      }
+    }
+  }
+
+private:
+  static void Resize_(ueds_connector::LidarCloud& cloud, size_t size) {
+    cloud.resize(size);
+    cloud.label.clear();
+    cloud.intensity.clear();
+    if constexpr (TExtra != nullptr) {
+      (cloud.*TExtra).resize(size);
+    }
+  }
+};
+
+}  // namespace Serializable::Drone
+
+namespace Serializable::Drone::GetLidarData
+{
+using CloudResponse = LidarCloudResponse<MessageType::get_lidar_data, nullptr>;
+}  // namespace Serializable::Drone::GetLidarData
+
+namespace Serializable::Drone::GetLidarSegData
+{
+using CloudResponse = LidarCloudResponse<MessageType::get_lidar_seg, &ueds_connector::LidarCloud::label>;
+}  // namespace Serializable::Drone::GetLidarSegData
+
+namespace Serializable::Drone::GetLidarIntData
+{
+using CloudResponse = LidarCloudResponse<MessageType::get_lidar_int, &ueds_connector::LidarCloud::intensity>;
+}  // namespace Serializable::Drone::GetLidarIntData
+
+//}
+
+/* GetLidarDistances::CloudResponse //{ */
+
+namespace Serializable::Drone::GetLidarDistances
+{
+
+/**
+ * @brief Reads the GetLidarDistances response straight into a ueds_connector::LidarCloud, the directions are filled in from the table.
+ *
+ * The distances and the extra values are loaded by one memcpy each, extra is the label or intensity array of the cloud (nullptr for none).
+ */
+struct CloudResponse : public Common::NetworkResponse
+{
+  CloudResponse(ueds_connector::LidarCloud& _cloud, std::vector<int>* _extra)
+      : Common::NetworkResponse(static_cast<unsigned short>(MessageType::get_lidar_distances)), cloud(_cloud), extra(_extra) {
+  }
+
+  ueds_connector::LidarCloud& cloud;
+  std::vector<int>*           extra;
+  unsigned int                table_id = 0;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+
+    archive(cereal::base_class<Common::NetworkResponse>(this));
+
+    // a refused scan is answered by the header alone
+    if (!status) {
+      return;
+    }
+
+    archive(cloud.start.x, cloud.start.y, cloud.start.z, table_id, cloud.distance);
+
+    cloud.label.clear();
+    cloud.intensity.clear();
+
+    // the extra values go one per beam, the cloud is handed out with its arrays of the same size
+    if (extra != nullptr) {
+      archive(*extra);
+      if (extra->size() != cloud.distance.size()) {
+        throw cereal::Exception("Distance-only scan carries " + std::to_string(extra->size()) + " extra values for " +
+                                std::to_string(cloud.distance.size()) + " beams");
+      }
+    } else {
+      std::vector<int> none;
+      archive(none);
+      if (!none.empty()) {
+        throw cereal::Exception("Distance-only scan carries " + std::to_string(none.size()) + " extra values, none were requested");
+      }
+    }
+  }
+};
+
+}  // namespace Serializable::Drone::GetLidarDistances
+
+//}
+
+/* GetLidarQuantized::CloudResponse //{ */
+
+namespace Serializable::Drone::GetLidarQuantized
+{
+
+/**
+ * @brief Dequantizes the GetLidarQuantized response straight from the receive buffer into a ueds_connector::LidarCloud.
+ *
+ * The directions are filled in from the table, extra is the label or intensity array of the cloud (nullptr for none).
+ */
+struct CloudResponse : public Common::NetworkResponse
+{
+  CloudResponse(ueds_connector::LidarCloud& _cloud, std::vector<int>* _extra)
+      : Common::NetworkResponse(static_cast<unsigned short>(MessageType::get_lidar_quantized)), cloud(_cloud), extra(_extra) {
+  }
+
+  ueds_connector::LidarCloud& cloud;
+  std::vector<int>*           extra;
+  unsigned int                table_id   = 0;
+  double                      resolution = 0.0;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+
+    static_assert(std::is_same_v<Archive, ueds_connector::SpanInputArchive>, "the quantized scans are only loaded in place");
+
+    archive(cereal::base_class<Common::NetworkResponse>(this));
+
+    // a refused scan is answered by the header alone
+    if (!status) {
+      return;
+    }
+
+    archive(cloud.start.x, cloud.start.y, cloud.start.z, table_id, resolution);
+
+    cereal::size_type size = 0;
+    archive(cereal::make_size_tag(size));
+
+    if (size > archive.remaining() / sizeof(uint16_t)) {
+      throw cereal::Exception("Quantized scan of " + std::to_string(size) + " beams does not fit into the remaining " +
+                              std::to_string(archive.remaining()) + " bytes");
+    }
+
+    cloud.distance.resize(size);
+    ueds_connector::DequantizeRanges(archive.takeBinary(size * sizeof(uint16_t)), resolution, cloud.distance);
+
+    unsigned char     value_size = 0;
+    cereal::size_type values     = 0;
+    archive(value_size, cereal::make_size_tag(values));
+
+    if (values > archive.remaining() || (extra != nullptr && (value_size == 0 || value_size > 2 || values != size * value_size))) {
+      throw cereal::Exception("Quantized scan carries " + std::to_string(values) + " bytes of " + std::to_string(value_size) +
+                              " byte values for " + std::to_string(size) + " beams");
+    }
+
+    const auto bytes = archive.takeBinary(values);
+
+    cloud.label.clear();
+    cloud.intensity.clear();
+
+    if (extra != nullptr) {
+      extra->resize(size);
+      ueds_connector::WidenLidarValues(bytes, value_size, *extra);
+    }
+  }
+};
+
+}  // namespace Serializable::Drone::GetLidarQuantized
+
+//}
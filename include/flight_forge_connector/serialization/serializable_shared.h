@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
+#include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
 
 namespace Serializable
@@ -13,7 +16,10 @@ namespace Common
 {
 enum MessageType : unsigned short
 {
-  ping = 0x1
+  ping              = 0x1,
+  set_frame_mode    = 0x100,
+  set_shared_frames = 0x101,
+  set_compression   = 0x102,
 };
 
 /* NetworkRequest //{ */
@@ -78,6 +84,137 @@ struct Response : public Common::NetworkResponse
 
 //}
 
+/* SetFrameMode //{ */
+
+namespace SetFrameMode
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::set_frame_mode)) {
+  }
+
+  unsigned short frame_mode;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), frame_mode);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::set_frame_mode)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::set_frame_mode, _status) {
+  }
+};
+}  // namespace SetFrameMode
+
+//}
+
+/* SetSharedFrames //{ */
+
+namespace SetSharedFrames
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::set_shared_frames)) {
+  }
+
+  bool enable;
+  // 0 lets the server decide
+  unsigned int slot_count;
+  unsigned int slot_size;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), enable, slot_count, slot_size);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::set_shared_frames)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::set_shared_frames, _status) {
+  }
+
+  // shared memory object created by the server
+  std::string  name;
+  unsigned int slot_count;
+  unsigned int slot_size;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), name, slot_count, slot_size);
+  }
+};
+}  // namespace SetSharedFrames
+
+//}
+
+/* SetCompression //{ */
+
+// both sides compress the framed payloads of at least threshold bytes once the server replied
+namespace SetCompression
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::set_compression)) {
+  }
+
+  bool         enable;
+  unsigned int threshold;
+  int          acceleration;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), enable, threshold, acceleration);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::set_compression)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::set_compression, _status) {
+  }
+};
+}  // namespace SetCompression
+
+//}
+
+/* FrameDescriptor //{ */
+
+// reply to the camera and lidar data requests once the shared frames are enabled, the body lies in the shared memory slot
+namespace FrameDescriptor
+{
+struct Response : public Common::NetworkResponse
+{
+  Response() = default;
+  explicit Response(unsigned short _type) : Common::NetworkResponse(_type) {
+  }
+  explicit Response(unsigned short _type, bool _status) : Common::NetworkResponse(_type, _status) {
+  }
+
+  unsigned int       slot;
+  unsigned long long sequence;
+  unsigned int       size;
+  unsigned int       split;
+  double             stamp_;
+  double             startX;
+  double             startY;
+  double             startZ;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), slot, sequence, size, split, stamp_, startX, startY, startZ);
+  }
+};
+}  // namespace FrameDescriptor
+
+//}
+
 }  // namespace Common
 
 namespace Drone
@@ -106,6 +243,12 @@ enum MessageType : unsigned short
   get_crash_state                 = 21,
   get_lidar_int                   = 22,
   get_rangefinder_data            = 23,
+  batch                           = 24,
+  subscribe                       = 25,
+  unsubscribe                     = 26,
+  get_lidar_directions            = 27,
+  get_lidar_distances             = 28,
+  get_lidar_quantized             = 29,
 };
 
 /* struct LidarConfig //{ */
@@ -709,6 +852,129 @@ struct Response : public Common::NetworkResponse
 
 //}
 
+/* GetLidarDirections //{ */
+
+// beam directions of the fixed lidar patterns (not Livox), the distance-only scans refer to them by table_id, which changes with the config
+namespace GetLidarDirections
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::get_lidar_directions)) {
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::get_lidar_directions)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::get_lidar_directions, _status) {
+  }
+
+  unsigned int        table_id;
+  std::vector<double> directionX;
+  std::vector<double> directionY;
+  std::vector<double> directionZ;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), table_id, directionX, directionY, directionZ);
+  }
+};
+}  // namespace GetLidarDirections
+
+//}
+
+/* GetLidarDistances //{ */
+
+// scan without the beam directions, the extra values are the labels for get_lidar_seg and the intensities for get_lidar_int
+namespace GetLidarDistances
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::get_lidar_distances)) {
+  }
+
+  // get_lidar_data, get_lidar_seg or get_lidar_int
+  unsigned short source;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), source);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::get_lidar_distances)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::get_lidar_distances, _status) {
+  }
+
+  double startX;
+  double startY;
+  double startZ;
+
+  unsigned int        table_id;
+  std::vector<double> distances;
+  std::vector<int>    extra;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), startX, startY, startZ, table_id, distances, extra);
+  }
+};
+}  // namespace GetLidarDistances
+
+//}
+
+/* GetLidarQuantized //{ */
+
+// compact scan referring to the direction table of GetLidarDirections, the range of a beam is ranges[i] * resolution meters
+namespace GetLidarQuantized
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::get_lidar_quantized)) {
+  }
+
+  // get_lidar_data, get_lidar_seg or get_lidar_int
+  unsigned short source;
+  // meters per step, 0 lets the server cover the beam length
+  double resolution;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), source, resolution);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::get_lidar_quantized)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::get_lidar_quantized, _status) {
+  }
+
+  double startX;
+  double startY;
+  double startZ;
+
+  unsigned int          table_id;
+  double                resolution;
+  std::vector<uint16_t> ranges;
+  // bytes per label (1 or 2) or intensity (1), 0 for get_lidar_data, the values are little-endian
+  unsigned char              value_size;
+  std::vector<unsigned char> values;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), startX, startY, startZ, table_id, resolution, ranges, value_size, values);
+  }
+};
+}  // namespace GetLidarQuantized
+
+//}
+
 /* GetLidarConfig //{ */
 
 namespace GetLidarConfig
@@ -937,6 +1203,107 @@ struct Response : public Common::NetworkResponse
 
 //}
 
+/* Batch //{ */
+
+// several drone requests executed in order by the server and answered by one response, see ueds_connector::BatchRequest
+namespace Batch
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::batch)) {
+  }
+
+  unsigned int count;
+  // the serialized requests back to back, each prefixed by its size as unsigned int
+  std::vector<unsigned char> requests;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), count, requests);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::batch)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::batch, _status) {
+  }
+
+  // one per request in the order of the requests, a request the server cannot execute is answered by a NetworkResponse with status false
+  unsigned int count;
+  // the serialized responses back to back, each prefixed by its size as unsigned int
+  std::vector<unsigned char> responses;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkResponse>(this), count, responses);
+  }
+};
+}  // namespace Batch
+
+//}
+
+/* Subscribe //{ */
+
+// the server pushes the sensor data as responses to the data request of the sensor, framed with the sequence id 0
+namespace Subscribe
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::subscribe)) {
+  }
+
+  // message type of the data request, e.g. get_lidar_data
+  unsigned short sensor;
+  // pushes per second, 0 follows the rate of the sensor (LidarConfig::Frequency for the lidar)
+  double frequency;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), sensor, frequency);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::subscribe)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::subscribe, _status) {
+  }
+};
+}  // namespace Subscribe
+
+//}
+
+/* Unsubscribe //{ */
+
+namespace Unsubscribe
+{
+struct Request : public Common::NetworkRequest
+{
+  Request() : Common::NetworkRequest(static_cast<unsigned short>(MessageType::unsubscribe)) {
+  }
+
+  unsigned short sensor;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Common::NetworkRequest>(this), sensor);
+  }
+};
+
+struct Response : public Common::NetworkResponse
+{
+  Response() : Common::NetworkResponse(static_cast<unsigned short>(MessageType::unsubscribe)) {
+  }
+  explicit Response(bool _status) : Common::NetworkResponse(MessageType::unsubscribe, _status) {
+  }
+};
+}  // namespace Unsubscribe
+
+//}
+
 }  // namespace Drone
 
 namespace GameMode
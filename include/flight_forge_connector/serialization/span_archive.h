@@ -0,0 +1,179 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cereal/cereal.hpp>
+
+namespace ueds_connector
+{
+
+/**
+ * @brief Marks structs whose cereal binary representation is exactly their in-memory layout (no padding, members serialized in declaration order).
+ *
+ * std::vector of such structs is loaded with a single memcpy by SpanInputArchive.
+ */
+template <class T>
+struct is_wire_packed : std::false_type
+{
+};
+
+/**
+ * @brief Size in bytes of the cereal binary representation of T when it does not depend on the contents, 0 if unknown.
+ *
+ * Requests carrying only the NetworkRequest header are detected automatically, requests with fields specialize it (see serializable_extended.h).
+ */
+template <class T, class = void>
+struct fixed_wire_size : std::integral_constant<size_t, 0>
+{
+};
+
+template <class... TMembers>
+struct wire_size_of : std::integral_constant<size_t, (sizeof(TMembers) + ... + 0)>
+{
+};
+
+/**
+ * @brief Thrown by SpanOutputArchive when the serialized data does not fit into the destination.
+ */
+class SpanOverflow : public cereal::Exception {
+public:
+  explicit SpanOverflow(const std::string& what) : cereal::Exception(what) {
+  }
+};
+
+/**
+ * @brief Binary output archive writing into a caller-provided fixed-capacity byte range, wire compatible with cereal::BinaryOutputArchive.
+ */
+class SpanOutputArchive : public cereal::OutputArchive<SpanOutputArchive, cereal::AllowEmptyClassElision> {
+public:
+  explicit SpanOutputArchive(std::span<std::byte> data)
+      : cereal::OutputArchive<SpanOutputArchive, cereal::AllowEmptyClassElision>(this), data_(data) {
+  }
+
+  ~SpanOutputArchive() CEREAL_NOEXCEPT = default;
+
+  void saveBinary(const void* data, size_t size) {
+
+    if (size > data_.size() - position_) {
+      throw SpanOverflow("Failed to write " + std::to_string(size) + " bytes to output span! Remaining " + std::to_string(data_.size() - position_));
+    }
+
+    std::memcpy(data_.data() + position_, data, size);
+    position_ += size;
+  }
+
+  [[nodiscard]] size_t written() const {
+    return position_;
+  }
+
+private:
+  std::span<std::byte> data_;
+  size_t               position_ = 0;
+};
+
+/**
+ * @brief Binary input archive reading straight from a contiguous byte range, wire compatible with cereal::BinaryInputArchive.
+ *
+ * Unlike the stream based archive it does not copy the payload, every read is bounds checked and throws cereal::Exception when the data runs out.
+ */
+class SpanInputArchive : public cereal::InputArchive<SpanInputArchive, cereal::AllowEmptyClassElision> {
+public:
+  explicit SpanInputArchive(std::span<const std::byte> data)
+      : cereal::InputArchive<SpanInputArchive, cereal::AllowEmptyClassElision>(this), data_(data) {
+  }
+
+  ~SpanInputArchive() CEREAL_NOEXCEPT = default;
+
+  void loadBinary(void* const data, size_t size) {
+    std::memcpy(data, takeBinary(size).data(), size);
+  }
+
+  // returns a view of the next size bytes without copying them
+  std::span<const std::byte> takeBinary(size_t size) {
+
+    if (size > remaining()) {
+      throw cereal::Exception("Failed to read " + std::to_string(size) + " bytes from input span! Remaining " + std::to_string(remaining()));
+    }
+
+    const auto view = data_.subspan(position_, size);
+    position_ += size;
+    return view;
+  }
+
+  [[nodiscard]] size_t remaining() const {
+    return data_.size() - position_;
+  }
+
+private:
+  std::span<const std::byte> data_;
+  size_t                     position_ = 0;
+};
+
+/* arithmetic types //{ */
+
+template <class T>
+inline std::enable_if_t<std::is_arithmetic_v<T>> CEREAL_SAVE_FUNCTION_NAME(SpanOutputArchive& ar, const T& t) {
+  ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
+template <class T>
+inline std::enable_if_t<std::is_arithmetic_v<T>> CEREAL_LOAD_FUNCTION_NAME(SpanInputArchive& ar, T& t) {
+  ar.loadBinary(std::addressof(t), sizeof(t));
+}
+
+template <class Archive, class T>
+inline CEREAL_ARCHIVE_RESTRICT(SpanInputArchive, SpanOutputArchive) CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, cereal::NameValuePair<T>& t) {
+  ar(t.value);
+}
+
+template <class Archive, class T>
+inline CEREAL_ARCHIVE_RESTRICT(SpanInputArchive, SpanOutputArchive) CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, cereal::SizeTag<T>& t) {
+  ar(t.size);
+}
+
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(SpanOutputArchive& ar, const cereal::BinaryData<T>& bd) {
+  ar.saveBinary(bd.data, static_cast<size_t>(bd.size));
+}
+
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(SpanInputArchive& ar, cereal::BinaryData<T>& bd) {
+  ar.loadBinary(bd.data, static_cast<size_t>(bd.size));
+}
+
+//}
+
+/* contiguous vectors //{ */
+
+// vectors of arithmetic and wire-packed types are filled by one memcpy, the size is validated before anything is allocated
+template <class T, class A>
+inline std::enable_if_t<(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) || is_wire_packed<T>::value> CEREAL_LOAD_FUNCTION_NAME(
+    SpanInputArchive& ar, std::vector<T, A>& vector) {
+
+  cereal::size_type size;
+  ar(cereal::make_size_tag(size));
+
+  if (size > ar.remaining() / sizeof(T)) {
+    throw cereal::Exception("Vector of " + std::to_string(size) + " elements does not fit into the remaining " + std::to_string(ar.remaining()) + " bytes");
+  }
+
+  vector.resize(static_cast<size_t>(size));
+  ar.loadBinary(vector.data(), static_cast<size_t>(size) * sizeof(T));
+}
+
+//}
+
+}  // namespace ueds_connector
+
+CEREAL_REGISTER_ARCHIVE(ueds_connector::SpanOutputArchive)
+CEREAL_REGISTER_ARCHIVE(ueds_connector::SpanInputArchive)
+
+CEREAL_SETUP_ARCHIVE_TRAITS(ueds_connector::SpanInputArchive, ueds_connector::SpanOutputArchive)
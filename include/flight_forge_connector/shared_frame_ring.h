@@ -0,0 +1,171 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include <flight_forge_connector/data_types.h>
+
+// first API version of the server which understands Common::SetSharedFrames
+#define SHARED_FRAMES_MIN_API_MAJOR 0
+#define SHARED_FRAMES_MIN_API_MINOR 14
+// frames which may be in flight or held as views at the same time before the producer reuses their slot
+#define SHARED_FRAMES_DEFAULT_SLOTS 8
+
+namespace ueds_connector
+{
+
+/* SupportsSharedFrames() //{ */
+
+inline bool SupportsSharedFrames(int api_version_major, int api_version_minor) {
+  return api_version_major > SHARED_FRAMES_MIN_API_MAJOR ||
+         (api_version_major == SHARED_FRAMES_MIN_API_MAJOR && api_version_minor >= SHARED_FRAMES_MIN_API_MINOR);
+}
+
+//}
+
+/* SharedFrameDescriptor //{ */
+
+// what the socket carries instead of the frame body when the shared frames are enabled
+struct SharedFrameDescriptor
+{
+  uint32_t slot     = 0;
+  uint64_t sequence = 0;
+  uint32_t size     = 0;
+  // size of the first part, the left image of a stereo frame, equals size otherwise
+  uint32_t    split = 0;
+  double      stamp = 0.0;
+  Coordinates start{0, 0, 0};
+};
+
+//}
+
+/* SharedFrameView //{ */
+
+/**
+ * @brief Read-only view of a frame body in the shared memory ring.
+ *
+ * The producer reuses the slot once it wrote as many further frames as the ring has slots. IsValid() tells whether the data seen through the view
+ * was overwritten meanwhile, call it after processing the frame. The view must not outlive the ring (the connector it came from).
+ */
+class SharedFrameView {
+public:
+  SharedFrameView() = default;
+
+  [[nodiscard]] std::span<const unsigned char> GetData() const {
+    return {data_, descriptor_.size};
+  }
+
+  // the left image of a stereo frame
+  [[nodiscard]] std::span<const unsigned char> GetFirst() const {
+    return GetData().first(descriptor_.split);
+  }
+
+  // the right image of a stereo frame
+  [[nodiscard]] std::span<const unsigned char> GetSecond() const {
+    return GetData().subspan(descriptor_.split);
+  }
+
+  [[nodiscard]] double GetStamp() const {
+    return descriptor_.stamp;
+  }
+
+  // origin of a lidar scan
+  [[nodiscard]] const Coordinates& GetStart() const {
+    return descriptor_.start;
+  }
+
+  [[nodiscard]] const SharedFrameDescriptor& GetDescriptor() const {
+    return descriptor_;
+  }
+
+  [[nodiscard]] bool IsValid() const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot_sequence_ != nullptr && slot_sequence_->load(std::memory_order_acquire) == descriptor_.sequence;
+  }
+
+private:
+  friend class SharedFrameRing;
+
+  const unsigned char*         data_          = nullptr;
+  const std::atomic<uint64_t>* slot_sequence_ = nullptr;
+  SharedFrameDescriptor        descriptor_;
+};
+
+//}
+
+/**
+ * @brief Ring of fixed size frame slots in POSIX shared memory, written by the simulator and mapped read-only by the client.
+ *
+ * Every slot is guarded by a sequence lock, the producer makes its sequence odd while rewriting the slot and publishes the next even value, which
+ * the descriptor sent over the socket carries. The reader accepts the slot only while its sequence still equals the one of the descriptor.
+ * Create() and the write methods are the producer side, used by the mock server, Open() and View() the client side.
+ */
+class SharedFrameRing {
+public:
+  SharedFrameRing() = default;
+  ~SharedFrameRing();
+
+  SharedFrameRing(const SharedFrameRing&)            = delete;
+  SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+  // creates and maps the named region read-write, the name is unlinked again by Close()
+  bool Create(const std::string& name, uint32_t slot_count, uint32_t slot_size);
+
+  // maps an existing region read-only
+  bool Open(const std::string& name);
+
+  void Close();
+
+  [[nodiscard]] bool IsOpen() const {
+    return base_ != nullptr;
+  }
+
+  [[nodiscard]] const std::string& GetName() const {
+    return name_;
+  }
+
+  [[nodiscard]] uint32_t GetSlotCount() const {
+    return slot_count_;
+  }
+
+  [[nodiscard]] uint32_t GetSlotSize() const {
+    return slot_size_;
+  }
+
+  /**
+   * @brief Starts rewriting the next slot, the readers reject it until CommitWrite().
+   *
+   * @return memory of the slot to fill, empty if the frame does not fit or the ring is not writable
+   */
+  std::span<unsigned char> BeginWrite(uint32_t size, uint32_t& slot);
+
+  // publishes the slot, returns its sequence for the descriptor
+  uint64_t CommitWrite(uint32_t slot);
+
+  // false if the descriptor is out of the ring or its slot was reused already
+  bool View(const SharedFrameDescriptor& descriptor, SharedFrameView& view) const;
+
+  // shared memory names are a single path component starting with a slash
+  static bool IsValidName(const std::string& name);
+
+private:
+  std::string name_;
+  bool        owner_ = false;
+
+  unsigned char* base_       = nullptr;
+  size_t         mapped_     = 0;
+  uint32_t       slot_count_ = 0;
+  uint32_t       slot_size_  = 0;
+  uint32_t       next_slot_  = 0;
+
+  [[nodiscard]] std::atomic<uint64_t>* SlotSequence_(uint32_t slot) const;
+  [[nodiscard]] unsigned char*         SlotData_(uint32_t slot) const;
+  bool                                 Map_(int fd, size_t size, bool writable);
+};
+
+}  // namespace ueds_connector
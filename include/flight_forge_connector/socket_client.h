@@ -3,11 +3,22 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
-#include <queue>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <span>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -15,73 +26,385 @@
 
 #include <cereal/archives/binary.hpp>
 #include <kissnet/kissnet.hpp>
+#include <flight_forge_connector/async_worker.h>
+#include <flight_forge_connector/capture_file.h>
+#include <flight_forge_connector/compression.h>
+#include <flight_forge_connector/framing.h>
+#include <flight_forge_connector/receive_buffer.h>
+#include <flight_forge_connector/request_metrics.h>
+#include <flight_forge_connector/request_status.h>
+#include <flight_forge_connector/request_tracer.h>
+#include <flight_forge_connector/transport.h>
 #include <flight_forge_connector/serialization/serializable_extended.h>
 
 #define LOCALHOST "127.0.0.1"
 #define DEFAULT_PORT 8080
-#define BUFFER_SIZE 1024
+// minimal free space requested from the receive buffer for a single recv()
+#define BUFFER_SIZE 65536
+// initial capacity of the send buffer for requests without a fixed wire size, grows on demand
+#define SEND_BUFFER_SIZE 256
 
 #define END_OF_MESSAGE '$'
 
+// time a request waits for its response unless the client or the call sets another one
+#define DEFAULT_REQUEST_TIMEOUT_MS 1000
+// longest single select() while waiting without a deadline
+#define RECEIVE_POLL_INTERVAL_MS 1000
+// longest wait of the push receiver, also the delay of the pushes which a request came across before they reach their callbacks
+#define PUSH_POLL_INTERVAL_MS 20
+
 namespace ueds_connector
 {
 
+enum class ConnectionState
+{
+  // not connected yet, closed by Disconnect() or lost without the automatic reconnect
+  DISCONNECTED,
+  CONNECTED,
+  RECONNECTING,
+  // the reconnect gave up after ReconnectPolicy::max_attempts, Connect() or Reconnect() revive the client
+  DEAD,
+};
+
+struct ReconnectPolicy
+{
+  // reconnect in the background, on the I/O thread of the client, as soon as a request finds the connection lost
+  bool automatic = false;
+  // 0 keeps trying until Disconnect()
+  int max_attempts = 20;
+
+  std::chrono::milliseconds initial_delay{100};
+  std::chrono::milliseconds max_delay{2000};
+  double                    multiplier = 2.0;
+  // fraction of every delay drawn at random, spreads the reconnects of a fleet hitting the restarted server at once
+  double jitter = 0.5;
+};
+
 class SocketClient {
 public:
+  using Clock    = std::chrono::steady_clock;
+  using Deadline = Clock::time_point;
+
+  // waits indefinitely
+  static constexpr Deadline NO_DEADLINE = Deadline::max();
+
   SocketClient();
   SocketClient(const std::string& address, uint16_t port);
-  ~SocketClient();
+  virtual ~SocketClient();
 
   kissnet::socket_status::values Connect();
   bool                           ConnectSimple();
   bool                           Disconnect();
 
+  /**
+   * @brief Reconnects with the backoff of the reconnect policy and restores the session, blocks until it succeeds or gives up.
+   *
+   * The framing negotiated before is switched on again and OnReconnected_() re-applies the state of the derived client (e.g. the sensor
+   * configs cached by UedsConnector). An attempt whose restore fails counts as failed.
+   *
+   * @return true if connected, the state is DEAD otherwise (DISCONNECTED when interrupted by Disconnect())
+   */
+  bool Reconnect();
+
+  // reconnects the clients in parallel right away, cancelling their automatic reconnects still waiting out the backoff, returns the number of
+  // connected ones
+  static size_t ReconnectAll(const std::vector<SocketClient*>& clients);
+
+  void SetReconnectPolicy(const ReconnectPolicy& policy) {
+    reconnect_policy_ = policy;
+  }
+
+  const ReconnectPolicy& GetReconnectPolicy() const {
+    return reconnect_policy_;
+  }
+
+  ConnectionState GetConnectionState() const {
+    return connection_state_;
+  }
+
+  // called on every state change, on the thread causing it
+  void SetConnectionStateCallback(std::function<void(ConnectionState)> callback) {
+    std::scoped_lock lock(reconnect_mutex_);
+    connection_state_callback_ = std::move(callback);
+  }
+
   std::tuple<uint32_t, kissnet::socket_status> ReceiveMessage();
 
   bool Ping();
 
+  /**
+   * @brief Switches the connection to the requested framing if the server API version supports it, keeps the current framing otherwise.
+   *
+   * @param api_version (major, minor) as reported by GameModeController::GetApiVersion()
+   * @param frame_mode LENGTH_PREFIXED or SEQUENCED, the latter allows pipelining with SubmitRequest() and CollectResponse()
+   *
+   * @return true if the connection uses the requested framing after the call
+   */
+  bool NegotiateFrameMode(const std::pair<int, int>& api_version, FrameMode frame_mode = FrameMode::LENGTH_PREFIXED);
+
+  /**
+   * @brief Turns the compression of the large payloads on or off (options.enabled) if the server API version supports it.
+   *
+   * Requires the LENGTH_PREFIXED or SEQUENCED framing. The compressed frames are marked by FRAME_COMPRESSED_FLAG in their size, so the frames
+   * already on their way are read either way. Pays off on the links slower than the compression, e.g. camera images over 1 GbE.
+   *
+   * @return true if the connection uses the requested options after the call
+   */
+  bool NegotiateCompression(const std::pair<int, int>& api_version, const CompressionOptions& options);
+
   template <typename TRequest>
   std::tuple<uint32_t, kissnet::socket_status> SendMessage(TRequest& message) {
-    std::stringstream outputStream;
 
-    try {
-      cereal::BinaryOutputArchive oa(outputStream);
-      oa(message);
-    }
-    catch (cereal::Exception& exception) {
-      std::cerr << "Serialization error: " << exception.what() << std::endl;
+    constexpr size_t fixed_size = fixed_wire_size<TRequest>::value;
+
+    const auto type  = MessageTypeOf_(message);
+    const auto start = MetricsNow_();
+
+    // requests of a known size are serialized on the stack, the rest into the reused send buffer
+    if constexpr (fixed_size > 0) {
+      std::array<std::byte, SEQUENCED_FRAME_HEADER_SIZE + fixed_size> buffer;
+
+      size_t size = 0;
+      try {
+        size = SerializeMessage_(message, buffer, next_sequence_);
+      }
+      catch (cereal::Exception& exception) {
+        std::cerr << "Serialization error: " << exception.what() << std::endl;
+      }
+
+      if (size != FrameHeaderSize_() + fixed_size) {
+        std::cerr << "Serialization error: " << typeid(TRequest).name() << " does not match its fixed wire size" << std::endl;
+        return std::make_tuple(0, kissnet::socket_status::errored);
+      }
+
+      return SendSerialized_(type, start, buffer.data(), static_cast<uint32_t>(size));
+    } else {
+      if (send_buffer_.empty()) {
+        send_buffer_.resize(SEND_BUFFER_SIZE);
+      }
+
+      while (true) {
+        try {
+          const auto size = SerializeMessage_(message, send_buffer_, next_sequence_);
+          return SendSerialized_(type, start, send_buffer_.data(), static_cast<uint32_t>(size));
+        }
+        catch (SpanOverflow&) {
+          if (send_buffer_.size() >= MAX_FRAME_SIZE) {
+            break;
+          }
+          send_buffer_.resize(send_buffer_.size() * 2);
+        }
+        catch (cereal::Exception& exception) {
+          std::cerr << "Serialization error: " << exception.what() << std::endl;
+          break;
+        }
+      }
+
       return std::make_tuple(0, kissnet::socket_status::errored);
     }
-
-    std::string str = outputStream.str();
-    return SendMessage_(reinterpret_cast<const std::byte*>(str.c_str()), str.size());
   }
 
+  // waits for the response for the request timeout of the client, see GetLastRequestStatus() for the cause of a failure
   template <typename TRequest, typename TResponse>
   bool Request(TRequest& message, TResponse& response) {
+    return Request(message, response, DefaultDeadline_()) == RequestStatus::OK;
+  }
+
+  /**
+   * @brief Sends the request and waits for its response until the deadline.
+   *
+   * A response arriving after the deadline is skipped by the following requests, in the sequenced framing by its id, in the other framings they
+   * first drain the responses of the timed out requests within their own deadline.
+   */
+  template <typename TRequest, typename TResponse>
+  RequestStatus Request(TRequest& message, TResponse& response, Deadline deadline) {
+
+    std::scoped_lock lock(request_mutex_);
+    TraceSpan_       span(*this, TraceKind::REQUEST, MessageTypeOf_(message), last_request_status_);
+
+    if (frame_mode_ == FrameMode::SEQUENCED) {
+      const auto sequence = SubmitRequest(message);
+      if (sequence == 0) {
+        return SetLastRequestStatus_(RequestStatus::SEND_FAILED);
+      }
+      return CollectResponse(sequence, response, deadline);
+    }
+
+    const auto type = MessageTypeOf_(message);
+
+    const auto drain_status = DrainStaleResponses_(deadline);
+    if (drain_status != RequestStatus::OK) {
+      return FinishRequest_(type, drain_status);
+    }
+
     const auto [send_size, send_status] = SendMessage<TRequest>(message);
 
     if (send_status != kissnet::socket_status::valid || send_size == 0) {
-      return false;
+      return FinishRequest_(type, RequestStatus::SEND_FAILED);
     }
 
-    std::string response_str;
-    if (!GetMessage(response_str)) {
-      return false;
+    std::span<const std::byte> response_data;
+    const auto                 receive_status = ReceiveResponse_(type, 0, response_data, deadline);
+
+    if (receive_status != RequestStatus::OK) {
+      if (receive_status == RequestStatus::TIMEOUT) {
+        stale_responses_++;
+      }
+      return FinishRequest_(type, receive_status);
     }
 
-    try {
-      std::stringstream          ss2(response_str);
-      cereal::BinaryInputArchive ia(ss2);
-      ia(response);
+    const auto success = DeserializeResponse_(type, response_data, response);
 
-      return true;
+    ReleaseMessage_();
+    return FinishRequest_(type, success ? RequestStatus::OK : RequestStatus::DESERIALIZATION_FAILED);
+  }
+
+  template <typename TRequest, typename TResponse>
+  RequestStatus Request(TRequest& message, TResponse& response, std::chrono::milliseconds timeout) {
+    return Request(message, response, Clock::now() + timeout);
+  }
+
+  /**
+   * @brief Sends the request without waiting for its response, requires the SEQUENCED framing (see NegotiateFrameMode()).
+   *
+   * Up to MAX_IN_FLIGHT_REQUESTS requests can be submitted before their responses are collected, e.g. the location, lidar and camera requests of one
+   * tick are written back to back and the connection pays a single round trip for all of them.
+   *
+   * @return sequence id to pass to CollectResponse(), 0 on failure
+   */
+  template <typename TRequest>
+  uint32_t SubmitRequest(TRequest& message) {
+
+    std::scoped_lock lock(request_mutex_);
+
+    if (frame_mode_ != FrameMode::SEQUENCED) {
+      return 0;
     }
-    catch (cereal::Exception& exception) {
-      // TODO
-      std::cout << "SOCKET-CLIENT serialization crashed!!!" << exception.what() << std::endl;
+
+    auto       status = RequestStatus::SEND_FAILED;
+    TraceSpan_ span(*this, TraceKind::SUBMIT, MessageTypeOf_(message), status);
+
+    const auto [send_size, send_status] = SendMessage<TRequest>(message);
+
+    if (send_status != kissnet::socket_status::valid || send_size == 0) {
+      metrics_.RecordFailure(MessageTypeOf_(message), false);
+      return 0;
     }
-    return false;
+
+    status = RequestStatus::OK;
+    span.SetSequence(last_sequence_);
+
+    return last_sequence_;
+  }
+
+  /**
+   * @brief Waits for the response of a request submitted by SubmitRequest().
+   *
+   * The responses can be collected in any order, the ones received before the requested id are parked and handed out by later calls.
+   */
+  template <typename TResponse>
+  bool CollectResponse(uint32_t sequence, TResponse& response) {
+    return CollectResponse(sequence, response, DefaultDeadline_()) == RequestStatus::OK;
+  }
+
+  // a request which timed out is not in flight anymore, its late response is dropped
+  template <typename TResponse>
+  RequestStatus CollectResponse(uint32_t sequence, TResponse& response, Deadline deadline) {
+
+    std::scoped_lock lock(request_mutex_);
+
+    const auto type = metrics_.IsEnabled() || tracer_ ? InFlightType_(sequence) : METRICS_UNKNOWN_TYPE;
+    TraceSpan_ span(*this, TraceKind::COLLECT, type, last_request_status_, sequence);
+
+    std::span<const std::byte> response_data;
+    const auto                 receive_status = ReceiveResponse_(type, sequence, response_data, deadline);
+
+    if (receive_status != RequestStatus::OK) {
+      return FinishRequest_(type, receive_status);
+    }
+
+    const auto success = DeserializeResponse_(type, response_data, response);
+
+    ReleaseMessage_();
+    return FinishRequest_(type, success ? RequestStatus::OK : RequestStatus::DESERIALIZATION_FAILED);
+  }
+
+  /**
+   * @brief Runs the function on the I/O thread of this client, e.g. RunAsync([&] { return drone.GetLocation(); }).
+   *
+   * The tasks of one client are executed one by one in the submission order, the blocking calls made from other threads in the meantime wait
+   * for the running request to finish.
+   */
+  template <typename TFunction>
+  std::future<std::invoke_result_t<TFunction>> RunAsync(TFunction&& function) {
+
+    auto task   = std::make_shared<std::packaged_task<std::invoke_result_t<TFunction>()>>(std::forward<TFunction>(function));
+    auto future = task->get_future();
+
+    async_worker_.Post([task] { (*task)(); });
+
+    return future;
+  }
+
+  // as above, the callback receives the result on the I/O thread and must not block on other requests of the same client
+  template <typename TFunction, typename TCallback>
+  void RunAsync(TFunction&& function, TCallback&& callback) {
+    async_worker_.Post(
+        [function = std::forward<TFunction>(function), callback = std::forward<TCallback>(callback)]() mutable { callback(function()); });
+  }
+
+  // applies to the requests without an explicit deadline, zero waits indefinitely
+  void SetRequestTimeout(std::chrono::milliseconds timeout) {
+    request_timeout_ = timeout;
+  }
+
+  std::chrono::milliseconds GetRequestTimeout() const {
+    return request_timeout_;
+  }
+
+  // outcome of the last request, tells a timeout apart from a failure of the methods returning bool, meaningful when one thread uses the client
+  RequestStatus GetLastRequestStatus() const {
+    return last_request_status_;
+  }
+
+  // number of requests submitted and not collected yet
+  size_t GetInFlightCount() const {
+    std::scoped_lock lock(request_mutex_);
+    return in_flight_.size();
+  }
+
+  /**
+   * @brief Per message type latency histograms of the request stages, byte counts and failures of this client, see RequestMetrics.
+   *
+   * Disabled by default, GetMetrics().SetEnabled(true) turns them on, Snapshot() and StartDump() read them. The requests are keyed by
+   * NetworkRequest::type, so the metrics of the drone and the game mode clients are kept apart by the clients themselves.
+   */
+  RequestMetrics& GetMetrics() {
+    return metrics_;
+  }
+
+  const RequestMetrics& GetMetrics() const {
+    return metrics_;
+  }
+
+  /**
+   * @brief Records the spans of the requests of this client into the tracer, usually shared by all the clients of the process, nullptr stops it.
+   *
+   * The blocking requests, the submits and the collects are traced on the threads calling them, tagged with the port and the message type.
+   */
+  void SetTracer(std::shared_ptr<RequestTracer> tracer);
+
+  /**
+   * @brief Appends every request frame sent and every response and push received by this client to the capture, nullptr stops it.
+   *
+   * The frames are recorded as the (de)serialization sees them, so a capture of the simulator session can be served again by the mock server
+   * (--replay), the requests and responses of other clients sharing the recorder interleave by their timestamps.
+   */
+  void SetRecorder(std::shared_ptr<CaptureRecorder> recorder);
+
+  // number of heap (re)allocations done by the receive side of this connection, stays constant once the buffer fits the largest message
+  size_t GetReceiveAllocationCount() const {
+    return receive_buffer_.GetAllocationCount();
   }
 
   uint16_t getPort() const {
@@ -92,23 +415,286 @@ public:
     return address_;
   }
 
+  FrameMode getFrameMode() const {
+    return frame_mode_;
+  }
+
+  const CompressionOptions& GetCompressionOptions() const {
+    return compression_;
+  }
+
 private:
   uint16_t                             port_    = DEFAULT_PORT;
   std::string                          address_ = LOCALHOST;
   std::unique_ptr<kissnet::tcp_socket> socket_  = nullptr;
 
-  std::queue<std::unique_ptr<std::vector<std::byte>>> in_queue_;
+  // serializes the requests of the application threads and the I/O thread, recursive as Request() nests in the framing negotiation
+  mutable std::recursive_mutex request_mutex_;
+
+  FrameMode frame_mode_ = FrameMode::SENTINEL;
+
+  CompressionOptions compression_;
+  // the compressed requests are built here, the compressed responses are decompressed here and read in place, both only grow
+  std::vector<std::byte> compress_buffer_;
+  std::vector<std::byte> decompress_buffer_;
+
+  std::chrono::milliseconds request_timeout_{DEFAULT_REQUEST_TIMEOUT_MS};
+  RequestStatus             last_request_status_ = RequestStatus::OK;
+  // responses of the timed out requests still expected in the non-sequenced framings
+  size_t stale_responses_ = 0;
+
+  // set by the socket failures, handled once the request finishes
+  bool connection_lost_ = false;
+
+  // restored after a reconnect
+  FrameMode           negotiated_frame_mode_ = FrameMode::SENTINEL;
+  std::pair<int, int> negotiated_api_version_{0, 0};
+  CompressionOptions  negotiated_compression_;
+
+  ReconnectPolicy                      reconnect_policy_;
+  std::atomic<ConnectionState>         connection_state_ = ConnectionState::DISCONNECTED;
+  std::function<void(ConnectionState)> connection_state_callback_;
+  std::mutex                           reconnect_mutex_;
+  std::condition_variable              reconnect_condition_;
+  // changed by Disconnect() and the destructor, interrupts the reconnects started before
+  uint64_t                             reconnect_generation_ = 0;
+  std::minstd_rand                     reconnect_random_{std::random_device{}()};
+
+  std::vector<std::byte> send_buffer_;
+
+  ReceiveBuffer receive_buffer_;
+  size_t        message_size_ = 0;
+
+  RequestMetrics                   metrics_;
+  std::shared_ptr<RequestTracer>   tracer_;
+  std::shared_ptr<CaptureRecorder> recorder_;
+  // wire size of the last received frame
+  size_t received_frame_size_ = 0;
+  // set by WaitReadable_() when the awaited response starts arriving, only while the metrics are enabled
+  bool              awaiting_first_byte_ = false;
+  Clock::time_point first_byte_time_;
+
+  // sequenced framing, ids of the submitted requests and the responses received ahead of their turn
+  struct InFlightRequest
+  {
+    uint32_t       sequence = 0;
+    unsigned short type     = METRICS_UNKNOWN_TYPE;
+  };
+
+  struct ParkedResponse
+  {
+    uint32_t               sequence = 0;
+    std::vector<std::byte> payload;
+  };
+
+  uint32_t                     next_sequence_     = 1;
+  uint32_t                     last_sequence_     = 0;
+  uint32_t                     received_sequence_ = 0;
+  std::vector<InFlightRequest> in_flight_;
+  std::vector<ParkedResponse> parked_;
+  ParkedResponse*             released_parked_ = nullptr;
+
+  AsyncWorker async_worker_;
+
+  // the push receiver waits for the socket without the request lock, the socket is replaced only under the exclusive lock
+  std::shared_mutex       socket_mutex_;
+  std::thread             push_receiver_;
+  std::atomic<bool>       push_receiving_ = false;
+  std::mutex              push_receiver_mutex_;
+  std::condition_variable push_receiver_condition_;
+
+  [[nodiscard]] size_t FrameHeaderSize_() const {
+    return FrameHeaderSize(frame_mode_);
+  }
+
+  [[nodiscard]] Deadline DefaultDeadline_() const {
+    return request_timeout_.count() > 0 ? Clock::now() + request_timeout_ : NO_DEADLINE;
+  }
+
+  // the span of a request from its construction to its destruction, ends with the status as seen then
+  class TraceSpan_ {
+  public:
+    TraceSpan_(SocketClient& client, TraceKind kind, unsigned short type, const RequestStatus& status, uint32_t sequence = 0)
+        : tracer_(client.tracer_ && client.tracer_->IsEnabled() ? client.tracer_.get() : nullptr),
+          port_(client.port_),
+          kind_(kind),
+          type_(type),
+          status_(status),
+          sequence_(sequence) {
+      if (tracer_ != nullptr) {
+        tracer_->Begin(kind_, port_, type_, sequence_);
+      }
+    }
+
+    ~TraceSpan_() {
+      if (tracer_ != nullptr) {
+        tracer_->End(kind_, port_, type_, status_, sequence_);
+      }
+    }
+
+    TraceSpan_(const TraceSpan_&)            = delete;
+    TraceSpan_& operator=(const TraceSpan_&) = delete;
+
+    void SetSequence(uint32_t sequence) {
+      sequence_ = sequence;
+    }
+
+  private:
+    RequestTracer*       tracer_;
+    uint16_t             port_;
+    TraceKind            kind_;
+    unsigned short       type_;
+    const RequestStatus& status_;
+    uint32_t             sequence_;
+  };
+
+  [[nodiscard]] Clock::time_point MetricsNow_() const {
+    return metrics_.IsEnabled() ? Clock::now() : Clock::time_point{};
+  }
+
+  template <typename TMessage>
+  static unsigned short MessageTypeOf_(const TMessage& message) {
+    if constexpr (requires { message.type; }) {
+      return static_cast<unsigned short>(message.type);
+    } else {
+      return METRICS_UNKNOWN_TYPE;
+    }
+  }
+
+  RequestStatus FinishRequest_(unsigned short type, RequestStatus status) {
+
+    if (status != RequestStatus::OK) {
+      metrics_.RecordFailure(type, status == RequestStatus::TIMEOUT);
+    }
+
+    return SetLastRequestStatus_(status);
+  }
+
+  RequestStatus SetLastRequestStatus_(RequestStatus status) {
+
+    last_request_status_ = status;
+
+    if (connection_lost_) {
+      OnConnectionLost_();
+    }
+
+    return status;
+  }
+
+  template <typename TResponse>
+  bool DeserializeMessage_(std::span<const std::byte> data, TResponse& response) {
+
+    try {
+      SpanInputArchive ia(data);
+      ia(response);
+
+      return true;
+    }
+    catch (cereal::Exception&) {
+      // reported by the callers as RequestStatus::DESERIALIZATION_FAILED
+    }
+
+    return false;
+  }
+
+  template <typename TResponse>
+  bool DeserializeResponse_(unsigned short type, std::span<const std::byte> data, TResponse& response) {
+
+    if (!metrics_.IsEnabled()) {
+      return DeserializeMessage_(data, response);
+    }
+
+    const auto start   = Clock::now();
+    const auto success = DeserializeMessage_(data, response);
+
+    metrics_.RecordStage(type, RequestStage::DESERIALIZE, Clock::now() - start);
+    return success;
+  }
+
+  // serializes the message behind the frame header and fills the header in, returns the number of bytes to send
+  template <typename TRequest>
+  size_t SerializeMessage_(TRequest& message, std::span<std::byte> destination, uint32_t sequence) const {
+
+    const auto        header_size = FrameHeaderSize_();
+    SpanOutputArchive oa(destination.subspan(header_size));
+    oa(message);
+
+    if (frame_mode_ == FrameMode::SEQUENCED) {
+      WriteSequencedFrameHeader(destination.data(), static_cast<uint32_t>(oa.written()), sequence);
+    } else if (header_size > 0) {
+      WriteFrameHeader(destination.data(), static_cast<uint32_t>(oa.written()));
+    }
+
+    return header_size + oa.written();
+  }
+
+  kissnet::socket_status::values Connect_();
+  bool                           Disconnect_();
+  void                           OnConnectionLost_();
+  bool                           Reconnect_(uint64_t generation);
+  bool                           RestoreSession_();
+  uint64_t                       CancelReconnect_();
+  void                           SetConnectionState_(ConnectionState state);
+  void                           RunPushReceiver_();
+  void                           DrainPushes_();
+  void                           RouteFrame_(std::span<const std::byte> message);
 
 protected:
-  void                                                       PushToInQueue_(std::unique_ptr<std::vector<std::byte>> item);
-  std::unique_ptr<std::vector<std::byte>>                    PopFromInQueue_();
-  void                                                       ClearInQueue_();
-  [[nodiscard]] bool                                         InQueueEmpty_() const;
+  // called by Connect() and Disconnect(), the state negotiated for the previous connection is gone
+  virtual void OnConnectionReset_() {
+  }
+
+  // names the connection in the traces, followed by the port
+  virtual std::string TraceLabel_() const {
+    return "client";
+  }
+
+  // called by Reconnect() once the framing is restored, returns false to retry the reconnect later
+  virtual bool OnReconnected_() {
+    return true;
+  }
+
+  // stops the push receiver, the reconnects and the I/O thread, a derived client calls it first in its destructor as they use its virtual methods
+  void StopBackgroundWork_();
+
+  /**
+   * @brief Starts the thread receiving the frames the server pushes with the sequence id 0 while no request reads the connection.
+   *
+   * The pushes are received in the SEQUENCED framing only, the requests route the pushes they come across the same way.
+   */
+  void StartPushReceiver_();
+
+  // a pushed frame, called with the connection locked on the thread which received it, the message is valid during the call only
+  virtual void OnPushMessage_([[maybe_unused]] std::span<const std::byte> message) {
+  }
+
+  // called by the push receiver after every wait, without any lock, to hand the received pushes over
+  virtual void OnPushesReceived_() {
+  }
+
   [[nodiscard]] bool                                         IsSocketValid_() const;
   [[nodiscard]] bool                                         IsReadyToSend_() const;
-  [[nodiscard]] std::tuple<uint32_t, kissnet::socket_status> SendMessage_(const std::byte* buffer, uint32_t size) const;
+  [[nodiscard]] std::tuple<uint32_t, kissnet::socket_status> SendMessage_(const std::byte* buffer, uint32_t size,
+                                                                         unsigned short type = METRICS_UNKNOWN_TYPE);
+  // sends the frame serialized since serialize_start, which is a default time point while the metrics are disabled
+  [[nodiscard]] std::tuple<uint32_t, kissnet::socket_status> SendSerialized_(unsigned short type, Clock::time_point serialize_start,
+                                                                            const std::byte* buffer, uint32_t size);
+
+  // the returned view points into the receive buffer and stays valid until ReleaseMessage_()
+  RequestStatus GetMessage(std::span<const std::byte>& message, Deadline deadline);
+  // the response of a request by GetMessage(), or by GetSequencedMessage_() for a non-zero sequence, timed for the metrics
+  RequestStatus ReceiveResponse_(unsigned short type, uint32_t sequence, std::span<const std::byte>& message, Deadline deadline);
+  unsigned short InFlightType_(uint32_t sequence) const;
+  void          ReleaseMessage_();
+  RequestStatus GetSentinelMessage_(std::span<const std::byte>& message, Deadline deadline);
+  RequestStatus GetFramedMessage_(std::span<const std::byte>& message, Deadline deadline);
+  RequestStatus GetSequencedMessage_(uint32_t sequence, std::span<const std::byte>& message, Deadline deadline);
+  RequestStatus DrainStaleResponses_(Deadline deadline);
+  void          ResetSequencing_();
+  RequestStatus FillReceiveBuffer_(size_t size, Deadline deadline);
+  RequestStatus WaitReadable_(Deadline deadline);
 
-  bool GetMessage(std::string& message);
+  [[nodiscard]] std::tuple<uint32_t, kissnet::socket_status> ReceiveMessage_(Deadline deadline);
 };
 
 }  // namespace ueds_connector
@@ -0,0 +1,29 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// addresses starting with the scheme select the AF_UNIX stream transport, e.g. "unix:/run/flightforge/drone-8001.sock"
+#define UNIX_SOCKET_SCHEME "unix:"
+// replaced by the port in unix socket addresses, so one address serves all drones, e.g. "unix:/run/flightforge/drone-{port}.sock"
+#define UNIX_SOCKET_PORT_PLACEHOLDER "{port}"
+
+namespace ueds_connector
+{
+
+bool IsUnixSocketAddress(const std::string& address);
+
+// filesystem path of a unix socket address with the port placeholder substituted
+std::string UnixSocketPath(const std::string& address, uint16_t port);
+
+/**
+ * @brief Connects a blocking AF_UNIX stream socket.
+ *
+ * @return native socket descriptor, -1 on failure or on platforms without unix sockets
+ */
+int ConnectUnixSocket(const std::string& path);
+
+}  // namespace ueds_connector
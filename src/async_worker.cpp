@@ -0,0 +1,123 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/async_worker.h>
+
+#include <iostream>
+#include <utility>
+
+using ueds_connector::AsyncWorker;
+
+/* ~AsyncWorker() //{ */
+
+AsyncWorker::~AsyncWorker() {
+  Stop();
+}
+
+//}
+
+/* Post() //{ */
+
+void AsyncWorker::Post(std::function<void()> task) {
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    tasks_.push_back(std::move(task));
+
+    // during a stop the stopping worker drains the task, or Stop() starts a new one after it
+    if (!thread_.joinable() && !stopping_) {
+      Start_();
+    }
+  }
+
+  condition_.notify_one();
+}
+
+//}
+
+/* Stop() //{ */
+
+bool AsyncWorker::Stop() {
+
+  std::thread thread;
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    if (worker_id_ == std::this_thread::get_id()) {
+      std::cerr << "ASYNC-WORKER cannot stop from its own task" << std::endl;
+      return false;
+    }
+
+    if (!thread_.joinable()) {
+      return true;
+    }
+
+    stopping_ = true;
+    thread    = std::move(thread_);
+  }
+
+  condition_.notify_all();
+  thread.join();
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    stopping_  = false;
+    worker_id_ = std::thread::id();
+
+    // posted after the worker found the queue empty
+    if (!tasks_.empty()) {
+      Start_();
+    }
+  }
+
+  return true;
+}
+
+//}
+
+/* IsWorkerThread() //{ */
+
+bool AsyncWorker::IsWorkerThread() const {
+  std::scoped_lock lock(mutex_);
+  return std::this_thread::get_id() == worker_id_;
+}
+
+//}
+
+/* Start_() //{ */
+
+void AsyncWorker::Start_() {
+  thread_    = std::thread(&AsyncWorker::Run_, this);
+  worker_id_ = thread_.get_id();
+}
+
+//}
+
+/* Run_() //{ */
+
+void AsyncWorker::Run_() {
+
+  while (true) {
+
+    std::function<void()> task;
+
+    {
+      std::unique_lock lock(mutex_);
+      condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+
+      if (tasks_.empty()) {
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+//}
@@ -0,0 +1,319 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/capture_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using ueds_connector::CaptureDirection;
+using ueds_connector::CaptureReader;
+using ueds_connector::CaptureRecord;
+using ueds_connector::CaptureRecorder;
+
+namespace
+{
+
+constexpr char     CAPTURE_MAGIC[8]     = {'F', 'F', 'C', 'A', 'P', 'T', 'R', '1'};
+constexpr uint32_t CAPTURE_VERSION      = 1;
+constexpr uint32_t CAPTURE_RECORD_MAGIC = 0x43524646;  // "FFRC"
+constexpr size_t   CAPTURE_ALIGNMENT    = 8;
+
+struct FileHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  int64_t  start_time;
+  uint64_t reserved;
+};
+
+// the magic is written last, a record without it is not complete yet
+struct RecordHeader
+{
+  uint32_t magic;
+  uint32_t size;
+  uint64_t timestamp;
+  uint32_t sequence;
+  uint32_t wire_size;
+  uint16_t port;
+  uint8_t  direction;
+  uint8_t  reserved[5];
+};
+
+static_assert(sizeof(FileHeader) % CAPTURE_ALIGNMENT == 0 && sizeof(RecordHeader) % CAPTURE_ALIGNMENT == 0);
+
+size_t Align(size_t size) {
+  return (size + CAPTURE_ALIGNMENT - 1) / CAPTURE_ALIGNMENT * CAPTURE_ALIGNMENT;
+}
+
+}  // namespace
+
+/* MessageType() //{ */
+
+unsigned short CaptureRecord::MessageType() const {
+
+  if (payload.size() < sizeof(unsigned short)) {
+    return 0;
+  }
+
+  // the binary archives are little-endian
+  return static_cast<unsigned short>(static_cast<unsigned short>(payload[0]) | (static_cast<unsigned short>(payload[1]) << 8));
+}
+
+//}
+
+/* ~CaptureRecorder() //{ */
+
+CaptureRecorder::~CaptureRecorder() {
+  Close();
+}
+
+//}
+
+/* Open() //{ */
+
+bool CaptureRecorder::Open(const std::string& path, size_t capacity) {
+
+  Close();
+
+#ifdef _WIN32
+  return false;
+#else
+
+  capacity = std::max(Align(capacity), sizeof(FileHeader) + sizeof(RecordHeader));
+
+  const int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0) {
+    return false;
+  }
+
+  // sparse, the pages are allocated as the records reach them
+  void* address = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(capacity)) == 0) {
+    address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+
+  if (address == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+
+  fd_       = fd;
+  base_     = static_cast<std::byte*>(address);
+  capacity_ = capacity;
+  start_    = std::chrono::steady_clock::now();
+  offset_.store(sizeof(FileHeader), std::memory_order_relaxed);
+  dropped_.store(0, std::memory_order_relaxed);
+
+  FileHeader header{};
+  std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+  header.version     = CAPTURE_VERSION;
+  header.header_size = sizeof(FileHeader);
+  header.start_time  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  std::memcpy(base_, &header, sizeof(header));
+
+  return true;
+#endif
+}
+
+//}
+
+/* Close() //{ */
+
+void CaptureRecorder::Close() {
+
+#ifndef _WIN32
+  if (base_ == nullptr) {
+    return;
+  }
+
+  munmap(base_, capacity_);
+
+  // otherwise the unused capacity stays as a sparse hole, the reader stops at it
+  if (ftruncate(fd_, static_cast<off_t>(GetSize())) != 0) {
+    std::cerr << "CAPTURE cannot truncate the capture to " << GetSize() << " bytes" << std::endl;
+  }
+
+  ::close(fd_);
+
+  fd_       = -1;
+  base_     = nullptr;
+  capacity_ = 0;
+#endif
+}
+
+//}
+
+/* Append() //{ */
+
+bool CaptureRecorder::Append(uint16_t port, CaptureDirection direction, uint32_t sequence, uint32_t wire_size,
+                             std::span<const std::byte> payload) {
+
+  if (base_ == nullptr || payload.size() > UINT32_MAX) {
+    return false;
+  }
+
+  const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+  const auto size      = sizeof(RecordHeader) + Align(payload.size());
+  const auto offset    = offset_.fetch_add(size, std::memory_order_relaxed);
+
+  // the offset keeps growing past the capacity, so the later small records are dropped too and the order stays intact
+  if (offset + size > capacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto* record = base_ + offset;
+
+  RecordHeader header{};
+  header.size      = static_cast<uint32_t>(payload.size());
+  header.timestamp = static_cast<uint64_t>(timestamp);
+  header.sequence  = sequence;
+  header.wire_size = wire_size;
+  header.port      = port;
+  header.direction = static_cast<uint8_t>(direction);
+
+  std::memcpy(record, &header, sizeof(header));
+  std::memcpy(record + sizeof(header), payload.data(), payload.size());
+
+  std::atomic_ref<uint32_t>(reinterpret_cast<RecordHeader*>(record)->magic).store(CAPTURE_RECORD_MAGIC, std::memory_order_release);
+
+  return true;
+}
+
+//}
+
+/* ~CaptureReader() //{ */
+
+CaptureReader::~CaptureReader() {
+  Close();
+}
+
+//}
+
+/* Open() //{ */
+
+bool CaptureReader::Open(const std::string& path) {
+
+  Close();
+
+#ifdef _WIN32
+  return false;
+#else
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat status
+  {
+  };
+
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size    = static_cast<size_t>(status.st_size);
+  void*      address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+  ::close(fd);
+
+  if (address == MAP_FAILED) {
+    return false;
+  }
+
+  FileHeader header{};
+  std::memcpy(&header, address, sizeof(header));
+
+  if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != CAPTURE_VERSION ||
+      header.header_size < sizeof(FileHeader) || header.header_size > size) {
+    munmap(address, size);
+    return false;
+  }
+
+  base_       = static_cast<const std::byte*>(address);
+  size_       = size;
+  start_time_ = header.start_time;
+
+  return true;
+#endif
+}
+
+//}
+
+/* Close() //{ */
+
+void CaptureReader::Close() {
+
+#ifndef _WIN32
+  if (base_ != nullptr) {
+    munmap(const_cast<std::byte*>(base_), size_);
+  }
+#endif
+
+  base_ = nullptr;
+  size_ = 0;
+}
+
+//}
+
+/* Records() //{ */
+
+std::vector<CaptureRecord> CaptureReader::Records() const {
+
+  std::vector<CaptureRecord> records;
+
+  if (base_ == nullptr) {
+    return records;
+  }
+
+  FileHeader file_header{};
+  std::memcpy(&file_header, base_, sizeof(file_header));
+
+  size_t offset = file_header.header_size;
+
+  while (offset + sizeof(RecordHeader) <= size_) {
+
+    const auto* record = base_ + offset;
+    const auto  magic  = std::atomic_ref<uint32_t>(const_cast<RecordHeader*>(reinterpret_cast<const RecordHeader*>(record))->magic)
+                            .load(std::memory_order_acquire);
+
+    // the end of the capture or a record still being written
+    if (magic != CAPTURE_RECORD_MAGIC) {
+      break;
+    }
+
+    RecordHeader header{};
+    std::memcpy(&header, record, sizeof(header));
+
+    if (offset + sizeof(RecordHeader) + header.size > size_) {
+      break;
+    }
+
+    CaptureRecord entry;
+    entry.timestamp = std::chrono::nanoseconds(header.timestamp);
+    entry.port      = header.port;
+    entry.direction = static_cast<CaptureDirection>(header.direction);
+    entry.sequence  = header.sequence;
+    entry.wire_size = header.wire_size;
+    entry.payload   = std::span<const std::byte>(record + sizeof(RecordHeader), header.size);
+    records.push_back(entry);
+
+    offset += sizeof(RecordHeader) + Align(header.size);
+  }
+
+  return records;
+}
+
+//}
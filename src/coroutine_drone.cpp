@@ -0,0 +1,328 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/coroutine_drone.h>
+
+#include <iostream>
+
+using ueds_connector::Coordinates;
+using ueds_connector::CoroutineDrone;
+using ueds_connector::FrameMode;
+using ueds_connector::LidarCloud;
+using ueds_connector::RequestAwaitable;
+using ueds_connector::Rotation;
+
+namespace
+{
+
+/* Decode() //{ */
+
+template <typename TResponse>
+bool Decode(std::span<const std::byte> payload, TResponse& response) {
+
+  try {
+    ueds_connector::SpanInputArchive ia(payload);
+    ia(response);
+  }
+  catch (cereal::Exception& exception) {
+    std::cerr << "COROUTINE-DRONE deserialization error: " << exception.what() << std::endl;
+    return false;
+  }
+
+  return response.status;
+}
+
+//}
+
+}  // namespace
+
+/* CoroutineDrone() //{ */
+
+CoroutineDrone::CoroutineDrone(EventLoop& loop, const std::string& address, uint16_t port) : loop_(loop), address_(address), port_(port) {
+}
+
+//}
+
+/* ~CoroutineDrone() //{ */
+
+CoroutineDrone::~CoroutineDrone() {
+  Disconnect();
+}
+
+//}
+
+/* Connect() //{ */
+
+bool CoroutineDrone::Connect(FrameMode frame_mode) {
+
+  Disconnect();
+
+  drone_ = loop_.GetReactor().AddDrone(address_, port_, frame_mode);
+
+  return drone_ >= 0;
+}
+
+//}
+
+/* Disconnect() //{ */
+
+bool CoroutineDrone::Disconnect() {
+
+  if (drone_ < 0) {
+    return false;
+  }
+
+  loop_.GetReactor().RemoveDrone(drone_);
+  drone_ = -1;
+
+  return true;
+}
+
+//}
+
+/* IsConnected() //{ */
+
+bool CoroutineDrone::IsConnected() const {
+  return drone_ >= 0 && loop_.GetReactor().IsConnected(drone_);
+}
+
+//}
+
+/* GetLocationAsync() //{ */
+
+RequestAwaitable<Coordinates> CoroutineDrone::GetLocationAsync() {
+
+  Serializable::Drone::GetLocation::Request request{};
+
+  return RequestAwaitable<Coordinates>(loop_, drone_, request, [](std::span<const std::byte> payload, Coordinates& coordinates) {
+    Serializable::Drone::GetLocation::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    coordinates = Coordinates{response.x, response.y, response.z};
+    return true;
+  });
+}
+
+//}
+
+/* GetRotationAsync() //{ */
+
+RequestAwaitable<Rotation> CoroutineDrone::GetRotationAsync() {
+
+  Serializable::Drone::GetRotation::Request request{};
+
+  return RequestAwaitable<Rotation>(loop_, drone_, request, [](std::span<const std::byte> payload, Rotation& rotation) {
+    Serializable::Drone::GetRotation::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    rotation.pitch = response.pitch;
+    rotation.yaw   = response.yaw;
+    rotation.roll  = response.roll;
+    return true;
+  });
+}
+
+//}
+
+/* GetCrashStateAsync() //{ */
+
+RequestAwaitable<bool> CoroutineDrone::GetCrashStateAsync() {
+
+  Serializable::Drone::GetCrashState::Request request{};
+
+  return RequestAwaitable<bool>(loop_, drone_, request, [](std::span<const std::byte> payload, bool& crashed) {
+    Serializable::Drone::GetCrashState::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    crashed = response.crashed;
+    return true;
+  });
+}
+
+//}
+
+/* SetLocationAsync() //{ */
+
+RequestAwaitable<std::tuple<Coordinates, bool, Coordinates>> CoroutineDrone::SetLocationAsync(const Coordinates& coordinates, bool checkCollisions) {
+
+  Serializable::Drone::SetLocation::Request request{};
+
+  request.x               = coordinates.x;
+  request.y               = coordinates.y;
+  request.z               = coordinates.z;
+  request.checkCollisions = checkCollisions;
+
+  using Result = std::tuple<Coordinates, bool, Coordinates>;
+
+  return RequestAwaitable<Result>(loop_, drone_, request, [](std::span<const std::byte> payload, Result& result) {
+    Serializable::Drone::SetLocation::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    result = std::make_tuple(Coordinates{response.teleportedToX, response.teleportedToY, response.teleportedToZ}, response.isHit,
+                             Coordinates{response.impactPointX, response.impactPointY, response.impactPointZ});
+    return true;
+  });
+}
+
+//}
+
+/* SetRotationAsync() //{ */
+
+RequestAwaitable<std::tuple<Rotation, bool, Coordinates>> CoroutineDrone::SetRotationAsync(const Rotation& rotation) {
+
+  Serializable::Drone::SetRotation::Request request{};
+  request.pitch = rotation.pitch;
+  request.yaw   = rotation.yaw;
+  request.roll  = rotation.roll;
+
+  using Result = std::tuple<Rotation, bool, Coordinates>;
+
+  return RequestAwaitable<Result>(loop_, drone_, request, [](std::span<const std::byte> payload, Result& result) {
+    Serializable::Drone::SetRotation::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    Rotation rotatedTo{};
+    rotatedTo.pitch = response.rotatedToPitch;
+    rotatedTo.yaw   = response.rotatedToYaw;
+    rotatedTo.roll  = response.rotatedToRoll;
+
+    result = std::make_tuple(rotatedTo, response.isHit, Coordinates{response.impactPointX, response.impactPointY, response.impactPointZ});
+    return true;
+  });
+}
+
+//}
+
+/* GetRgbCameraDataAsync() //{ */
+
+RequestAwaitable<double> CoroutineDrone::GetRgbCameraDataAsync(std::vector<unsigned char>& image) {
+
+  Serializable::Drone::GetRgbCameraData::Request request{};
+
+  return RequestAwaitable<double>(loop_, drone_, request, [&image](std::span<const std::byte> payload, double& stamp) {
+    Serializable::Drone::GetRgbCameraData::Response response{};
+
+    // lend the caller's buffer to the response, the archive resizes it in place
+    response.image_.swap(image);
+    const auto success = Decode(payload, response);
+    image.swap(response.image_);
+
+    stamp = success ? response.stamp_ : 0.0;
+    return success;
+  });
+}
+
+//}
+
+/* GetStereoCameraDataAsync() //{ */
+
+RequestAwaitable<double> CoroutineDrone::GetStereoCameraDataAsync(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right) {
+
+  Serializable::Drone::GetStereoCameraData::Request request{};
+
+  return RequestAwaitable<double>(loop_, drone_, request, [&image_left, &image_right](std::span<const std::byte> payload, double& stamp) {
+    Serializable::Drone::GetStereoCameraData::Response response{};
+
+    response.image_left_.swap(image_left);
+    response.image_right_.swap(image_right);
+    const auto success = Decode(payload, response);
+    image_left.swap(response.image_left_);
+    image_right.swap(response.image_right_);
+
+    stamp = success ? response.stamp_ : 0.0;
+    return success;
+  });
+}
+
+//}
+
+/* GetRgbSegmentedAsync() //{ */
+
+RequestAwaitable<double> CoroutineDrone::GetRgbSegmentedAsync(std::vector<unsigned char>& image) {
+
+  Serializable::Drone::GetRgbSegCameraData::Request request{};
+
+  return RequestAwaitable<double>(loop_, drone_, request, [&image](std::span<const std::byte> payload, double& stamp) {
+    Serializable::Drone::GetRgbSegCameraData::Response response{};
+
+    response.image_.swap(image);
+    const auto success = Decode(payload, response);
+    image.swap(response.image_);
+
+    stamp = success ? response.stamp_ : 0.0;
+    return success;
+  });
+}
+
+//}
+
+/* GetRangefinderDataAsync() //{ */
+
+RequestAwaitable<double> CoroutineDrone::GetRangefinderDataAsync() {
+
+  Serializable::Drone::GetRangefinderData::Request request{};
+
+  return RequestAwaitable<double>(loop_, drone_, request, [](std::span<const std::byte> payload, double& range) {
+    Serializable::Drone::GetRangefinderData::Response response{};
+    if (!Decode(payload, response)) {
+      return false;
+    }
+
+    range = response.range;
+    return true;
+  });
+}
+
+//}
+
+/* GetLidarDataAsync() //{ */
+
+RequestAwaitable<void> CoroutineDrone::GetLidarDataAsync(LidarCloud& cloud) {
+
+  Serializable::Drone::GetLidarData::Request request{};
+
+  return RequestAwaitable<void>(loop_, drone_, request, [&cloud](std::span<const std::byte> payload, std::monostate&) {
+    Serializable::Drone::GetLidarData::CloudResponse response(cloud);
+    return Decode(payload, response);
+  });
+}
+
+//}
+
+/* GetLidarSegDataAsync() //{ */
+
+RequestAwaitable<void> CoroutineDrone::GetLidarSegDataAsync(LidarCloud& cloud) {
+
+  Serializable::Drone::GetLidarSegData::Request request{};
+
+  return RequestAwaitable<void>(loop_, drone_, request, [&cloud](std::span<const std::byte> payload, std::monostate&) {
+    Serializable::Drone::GetLidarSegData::CloudResponse response(cloud);
+    return Decode(payload, response);
+  });
+}
+
+//}
+
+/* GetLidarIntDataAsync() //{ */
+
+RequestAwaitable<void> CoroutineDrone::GetLidarIntDataAsync(LidarCloud& cloud) {
+
+  Serializable::Drone::GetLidarIntData::Request request{};
+
+  return RequestAwaitable<void>(loop_, drone_, request, [&cloud](std::span<const std::byte> payload, std::monostate&) {
+    Serializable::Drone::GetLidarIntData::CloudResponse response(cloud);
+    return Decode(payload, response);
+  });
+}
+
+//}
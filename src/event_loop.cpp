@@ -0,0 +1,339 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/event_loop.h>
+
+#include <algorithm>
+#include <iostream>
+
+using ueds_connector::AwaitResult;
+using ueds_connector::AwaitStatus;
+using ueds_connector::CancellationToken;
+using ueds_connector::EventLoop;
+using ueds_connector::SleepAwaitable;
+using ueds_connector::Task;
+using ueds_connector::detail::AwaitOperation;
+
+namespace
+{
+
+/* DetachedTask //{ */
+
+// owns a spawned task, the frame destroys itself when the task finishes
+struct DetachedTask
+{
+  struct promise_type
+  {
+    DetachedTask get_return_object() noexcept {
+      return DetachedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() const noexcept {
+      return {};
+    }
+
+    std::suspend_never final_suspend() const noexcept {
+      return {};
+    }
+
+    void return_void() const noexcept {
+    }
+
+    void unhandled_exception() const noexcept {
+      std::terminate();
+    }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+DetachedTask RunDetached(Task<void> task, size_t& active_tasks) {
+
+  try {
+    co_await task;
+  }
+  catch (const std::exception& exception) {
+    std::cerr << "EVENT-LOOP task failed: " << exception.what() << std::endl;
+  }
+  catch (...) {
+    std::cerr << "EVENT-LOOP task failed with an unknown exception" << std::endl;
+  }
+
+  active_tasks--;
+}
+
+//}
+
+}  // namespace
+
+/* CancellationToken::Create() //{ */
+
+CancellationToken CancellationToken::Create() {
+  CancellationToken token;
+  token.state_ = std::make_shared<State_>();
+  return token;
+}
+
+//}
+
+/* CancellationToken::Cancel() //{ */
+
+void CancellationToken::Cancel() {
+
+  if (!state_ || state_->cancelled) {
+    return;
+  }
+
+  state_->cancelled = true;
+
+  // the callbacks unregister themselves while resolving
+  auto callbacks = std::move(state_->callbacks);
+  state_->callbacks.clear();
+
+  for (auto& [registration, callback] : callbacks) {
+    callback();
+  }
+}
+
+//}
+
+/* CancellationToken::Register_() //{ */
+
+uint64_t CancellationToken::Register_(std::function<void()> callback) {
+
+  if (!state_) {
+    return 0;
+  }
+
+  const auto registration = state_->next_registration++;
+  state_->callbacks.emplace_back(registration, std::move(callback));
+
+  return registration;
+}
+
+//}
+
+/* CancellationToken::Unregister_() //{ */
+
+void CancellationToken::Unregister_(uint64_t registration) {
+
+  if (!state_) {
+    return;
+  }
+
+  auto& callbacks = state_->callbacks;
+  callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [registration](const auto& entry) { return entry.first == registration; }),
+                  callbacks.end());
+}
+
+//}
+
+/* AwaitOperation::Resolve() //{ */
+
+void AwaitOperation::Resolve(AwaitStatus result) {
+
+  if (status != AwaitStatus::PENDING) {
+    return;
+  }
+
+  status = result;
+
+  if (timer != 0) {
+    loop->CancelTimer_(timer);
+    timer = 0;
+  }
+
+  if (registration != 0) {
+    token.Unregister_(registration);
+    registration = 0;
+  }
+
+  // never resumed inline, the coroutine continues from the loop
+  if (handle) {
+    loop->Schedule_(std::exchange(handle, nullptr));
+  }
+}
+
+//}
+
+/* AwaitOperation::Suspend() //{ */
+
+void AwaitOperation::Suspend(std::coroutine_handle<> awaiting, std::chrono::milliseconds timeout, AwaitStatus timer_status) {
+
+  handle = awaiting;
+
+  if (timeout.count() > 0) {
+    timer = loop->AddTimer_(EventLoop::Clock::now() + timeout, [self = shared_from_this(), timer_status] {
+      self->timer = 0;
+      self->Resolve(timer_status);
+    });
+  }
+
+  if (token.CanBeCancelled()) {
+    registration = token.Register_([self = shared_from_this()] {
+      self->registration = 0;
+      self->Resolve(AwaitStatus::CANCELLED);
+    });
+  }
+}
+
+//}
+
+/* EventLoop::Spawn() //{ */
+
+void EventLoop::Spawn(Task<void> task) {
+  active_tasks_++;
+  Schedule_(RunDetached(std::move(task), active_tasks_).handle);
+}
+
+//}
+
+/* EventLoop::Run() //{ */
+
+void EventLoop::Run() {
+  while (RunOnce(-1)) {
+  }
+}
+
+//}
+
+/* EventLoop::RunOnce() //{ */
+
+bool EventLoop::RunOnce(int timeout_ms) {
+
+  FireTimers_();
+  ResumeReady_();
+
+  if (active_tasks_ == 0) {
+    return false;
+  }
+
+  // the reactor sends the requests queued by the resumed coroutines before waiting
+  reactor_.Poll(NextTimeout_(timeout_ms));
+
+  FireTimers_();
+  ResumeReady_();
+
+  return active_tasks_ > 0;
+}
+
+//}
+
+/* EventLoop::Schedule_() //{ */
+
+void EventLoop::Schedule_(std::coroutine_handle<> handle) {
+  ready_.push_back(handle);
+}
+
+//}
+
+/* EventLoop::AddTimer_() //{ */
+
+uint64_t EventLoop::AddTimer_(Clock::time_point deadline, std::function<void()> callback) {
+
+  const auto timer = next_timer_++;
+
+  timers_.emplace(std::make_pair(deadline, timer), std::move(callback));
+  timer_deadlines_.emplace(timer, deadline);
+
+  return timer;
+}
+
+//}
+
+/* EventLoop::CancelTimer_() //{ */
+
+void EventLoop::CancelTimer_(uint64_t timer) {
+
+  const auto it = timer_deadlines_.find(timer);
+  if (it == timer_deadlines_.end()) {
+    return;
+  }
+
+  timers_.erase(std::make_pair(it->second, timer));
+  timer_deadlines_.erase(it);
+}
+
+//}
+
+/* EventLoop::ResumeReady_() //{ */
+
+void EventLoop::ResumeReady_() {
+
+  while (!ready_.empty()) {
+    const auto handle = ready_.front();
+    ready_.pop_front();
+    handle.resume();
+  }
+}
+
+//}
+
+/* EventLoop::FireTimers_() //{ */
+
+void EventLoop::FireTimers_() {
+
+  const auto now = Clock::now();
+
+  while (!timers_.empty() && timers_.begin()->first.first <= now) {
+
+    auto callback = std::move(timers_.begin()->second);
+    timer_deadlines_.erase(timers_.begin()->first.second);
+    timers_.erase(timers_.begin());
+
+    callback();
+  }
+}
+
+//}
+
+/* EventLoop::NextTimeout_() //{ */
+
+int EventLoop::NextTimeout_(int timeout_ms) const {
+
+  if (!ready_.empty()) {
+    return 0;
+  }
+
+  if (timers_.empty()) {
+    return timeout_ms;
+  }
+
+  const auto until_timer = std::chrono::ceil<std::chrono::milliseconds>(timers_.begin()->first.first - Clock::now()).count();
+  const auto timer_ms    = static_cast<int>(std::max<int64_t>(until_timer, 0));
+
+  return timeout_ms < 0 ? timer_ms : std::min(timeout_ms, timer_ms);
+}
+
+//}
+
+/* SleepAwaitable //{ */
+
+SleepAwaitable::SleepAwaitable(EventLoop& loop, std::chrono::milliseconds delay, const CancellationToken& token)
+    : state_(std::make_shared<AwaitOperation>()), delay_(delay) {
+  state_->loop  = &loop;
+  state_->token = token;
+}
+
+bool SleepAwaitable::await_ready() const {
+  return delay_.count() <= 0 || state_->token.IsCancelled();
+}
+
+void SleepAwaitable::await_suspend(std::coroutine_handle<> awaiting) {
+  state_->Suspend(awaiting, delay_, AwaitStatus::OK);
+}
+
+AwaitResult<void> SleepAwaitable::await_resume() {
+
+  if (state_->status == AwaitStatus::PENDING) {
+    state_->Resolve(state_->token.IsCancelled() ? AwaitStatus::CANCELLED : AwaitStatus::OK);
+  }
+
+  return AwaitResult<void>{state_->status};
+}
+
+SleepAwaitable ueds_connector::Sleep(EventLoop& loop, std::chrono::milliseconds delay, const CancellationToken& token) {
+  return SleepAwaitable(loop, delay, token);
+}
+
+//}
@@ -0,0 +1,598 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/fleet_reactor.h>
+#include <flight_forge_connector/transport.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using ueds_connector::FleetReactor;
+using ueds_connector::FrameMode;
+
+namespace
+{
+
+// epoll user data of the wakeup eventfd, the drones use their id
+constexpr uint64_t WAKEUP_EVENT = std::numeric_limits<uint64_t>::max();
+
+// free space requested from the receive buffer for a single recv()
+constexpr size_t RECEIVE_CHUNK_SIZE = 65536;
+
+/* ConnectSocket() //{ */
+
+int ConnectSocket(const std::string& address, uint16_t port) {
+
+  if (ueds_connector::IsUnixSocketAddress(address)) {
+    return ueds_connector::ConnectUnixSocket(ueds_connector::UnixSocketPath(address, port));
+  }
+
+  addrinfo hints{};
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* result = nullptr;
+  if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+    return -1;
+  }
+
+  int fd = -1;
+
+  for (auto info = result; info != nullptr; info = info->ai_next) {
+
+    fd = ::socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+
+    if (::connect(fd, info->ai_addr, info->ai_addrlen) == 0) {
+      break;
+    }
+
+    ::close(fd);
+    fd = -1;
+  }
+
+  freeaddrinfo(result);
+
+  if (fd >= 0) {
+    // the requests are small and written back to back, do not wait for the acknowledgements
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+
+  return fd;
+}
+
+//}
+
+}  // namespace
+
+/* FleetReactor() //{ */
+
+FleetReactor::FleetReactor() {
+  epoll_fd_  = epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  epoll_event event{};
+  event.events   = EPOLLIN;
+  event.data.u64 = WAKEUP_EVENT;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event);
+}
+
+//}
+
+/* ~FleetReactor() //{ */
+
+FleetReactor::~FleetReactor() {
+
+  Stop();
+
+  std::vector<Pending_> failed;
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    for (auto& [id, connection] : drones_) {
+      CloseConnection_(*connection, failed);
+    }
+
+    drones_.clear();
+    dirty_.clear();
+  }
+
+  for (auto& pending : failed) {
+    pending.completion(false, {});
+  }
+
+  ::close(wakeup_fd_);
+  ::close(epoll_fd_);
+}
+
+//}
+
+/* AddDrone() //{ */
+
+int FleetReactor::AddDrone(const std::string& address, uint16_t port, FrameMode frame_mode) {
+
+  if (frame_mode == FrameMode::SENTINEL) {
+    std::cerr << "FLEET-REACTOR the sentinel framing is not supported" << std::endl;
+    return -1;
+  }
+
+  const int fd = ConnectSocket(address, port);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (!Handshake_(fd, frame_mode) || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+    ::close(fd);
+    return -1;
+  }
+
+  auto connection        = std::make_shared<Connection_>();
+  connection->fd         = fd;
+  connection->frame_mode = frame_mode;
+
+  std::scoped_lock lock(mutex_);
+
+  connection->id = next_id_++;
+
+  epoll_event event{};
+  event.events   = EPOLLIN;
+  event.data.u64 = static_cast<uint64_t>(connection->id);
+
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    ::close(fd);
+    return -1;
+  }
+
+  drones_.emplace(connection->id, connection);
+
+  return connection->id;
+}
+
+//}
+
+/* RemoveDrone() //{ */
+
+bool FleetReactor::RemoveDrone(int drone) {
+
+  std::vector<Pending_> failed;
+
+  {
+    std::scoped_lock lock(mutex_);
+
+    auto it = drones_.find(drone);
+    if (it == drones_.end()) {
+      return false;
+    }
+
+    CloseConnection_(*it->second, failed);
+    drones_.erase(it);
+  }
+
+  for (auto& pending : failed) {
+    pending.completion(false, {});
+  }
+
+  return true;
+}
+
+//}
+
+/* IsConnected() //{ */
+
+bool FleetReactor::IsConnected(int drone) const {
+
+  std::scoped_lock lock(mutex_);
+
+  const auto it = drones_.find(drone);
+  return it != drones_.end() && it->second->fd >= 0;
+}
+
+//}
+
+/* GetPendingCount() //{ */
+
+size_t FleetReactor::GetPendingCount(int drone) const {
+
+  std::scoped_lock lock(mutex_);
+
+  const auto it = drones_.find(drone);
+  return it != drones_.end() ? it->second->pending.size() : 0;
+}
+
+//}
+
+/* SetDisconnectCallback() //{ */
+
+void FleetReactor::SetDisconnectCallback(DisconnectCallback callback) {
+  std::scoped_lock lock(mutex_);
+  disconnect_callback_ = std::move(callback);
+}
+
+//}
+
+/* Poll() //{ */
+
+int FleetReactor::Poll(int timeout_ms) {
+
+  {
+    std::scoped_lock lock(mutex_);
+    polling_thread_ = std::this_thread::get_id();
+    FlushDirty_();
+  }
+
+  std::array<epoll_event, REACTOR_MAX_EVENTS> events;
+  const int                                   count = epoll_wait(epoll_fd_, events.data(), REACTOR_MAX_EVENTS, timeout_ms);
+
+  if (count < 0) {
+    return 0;
+  }
+
+  int                   completed = 0;
+  std::vector<Pending_> failed;
+  std::vector<int>      disconnected;
+
+  std::unique_lock lock(mutex_);
+
+  for (int i = 0; i < count; i++) {
+
+    const auto& event = events[i];
+
+    if (event.data.u64 == WAKEUP_EVENT) {
+      uint64_t value;
+      while (::read(wakeup_fd_, &value, sizeof(value)) > 0) {
+      }
+      continue;
+    }
+
+    const auto it = drones_.find(static_cast<int>(event.data.u64));
+    if (it == drones_.end() || it->second->fd < 0) {
+      continue;
+    }
+
+    // keeps the connection alive while its completions run unlocked
+    const auto connection = it->second;
+
+    if ((event.events & EPOLLOUT) && !WriteConnection_(*connection)) {
+      CloseConnection_(*connection, failed);
+    }
+
+    if (connection->fd >= 0 && (event.events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+      completed += ReadConnection_(connection, lock, failed);
+    }
+
+    if (connection->fd < 0 && drones_.count(connection->id) > 0) {
+      disconnected.push_back(connection->id);
+    }
+  }
+
+  FlushDirty_();
+
+  const auto disconnect_callback = disconnect_callback_;
+
+  lock.unlock();
+
+  for (auto& pending : failed) {
+    pending.completion(false, {});
+  }
+
+  if (disconnect_callback) {
+    for (const auto drone : disconnected) {
+      disconnect_callback(drone);
+    }
+  }
+
+  return completed;
+}
+
+//}
+
+/* Start() //{ */
+
+void FleetReactor::Start() {
+
+  if (running_.exchange(true)) {
+    return;
+  }
+
+  thread_ = std::thread([this] {
+    while (running_) {
+      Poll(-1);
+    }
+  });
+}
+
+//}
+
+/* Stop() //{ */
+
+void FleetReactor::Stop() {
+
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  Wakeup();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+//}
+
+/* Wakeup() //{ */
+
+void FleetReactor::Wakeup() {
+  const uint64_t value = 1;
+  [[maybe_unused]] const auto written = ::write(wakeup_fd_, &value, sizeof(value));
+}
+
+//}
+
+/* PrepareSend_() //{ */
+
+std::span<std::byte> FleetReactor::PrepareSend_(Connection_& connection, size_t min_size) {
+
+  auto& buffer = connection.send_buffer;
+
+  if (buffer.size() - connection.send_size < min_size && connection.send_offset > 0) {
+    std::memmove(buffer.data(), buffer.data() + connection.send_offset, connection.send_size - connection.send_offset);
+    connection.send_size -= connection.send_offset;
+    connection.send_offset = 0;
+  }
+
+  if (buffer.size() - connection.send_size < min_size) {
+    buffer.resize(std::max(buffer.size() * 2, connection.send_size + min_size));
+  }
+
+  return std::span<std::byte>(buffer).subspan(connection.send_size);
+}
+
+//}
+
+/* MarkDirty_() //{ */
+
+void FleetReactor::MarkDirty_(Connection_& connection) {
+
+  if (connection.dirty) {
+    return;
+  }
+
+  connection.dirty = true;
+  dirty_.push_back(drones_.at(connection.id));
+
+  // the polling thread flushes the queues at the end of Poll(), any other thread has to interrupt the wait
+  if (dirty_.size() == 1 && std::this_thread::get_id() != polling_thread_) {
+    Wakeup();
+  }
+}
+
+//}
+
+/* FlushDirty_() //{ */
+
+void FleetReactor::FlushDirty_() {
+
+  for (auto& connection : dirty_) {
+
+    connection->dirty = false;
+
+    if (connection->fd >= 0 && !WriteConnection_(*connection)) {
+      // the failure shows up as a hangup on the next epoll_wait()
+      ::shutdown(connection->fd, SHUT_RDWR);
+    }
+  }
+
+  dirty_.clear();
+}
+
+//}
+
+/* WriteConnection_() //{ */
+
+bool FleetReactor::WriteConnection_(Connection_& connection) {
+
+  while (connection.send_offset < connection.send_size) {
+
+    const auto sent = ::send(connection.fd, connection.send_buffer.data() + connection.send_offset, connection.send_size - connection.send_offset,
+                             MSG_NOSIGNAL);
+
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return false;
+    }
+
+    connection.send_offset += static_cast<size_t>(sent);
+  }
+
+  if (connection.send_offset == connection.send_size) {
+    connection.send_offset = 0;
+    connection.send_size   = 0;
+  }
+
+  // wait for EPOLLOUT only while the socket buffer is full
+  const bool arm = connection.send_size > 0;
+
+  if (arm != connection.write_armed) {
+
+    epoll_event event{};
+    event.events   = EPOLLIN | (arm ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.u64 = static_cast<uint64_t>(connection.id);
+
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.write_armed = arm;
+  }
+
+  return true;
+}
+
+//}
+
+/* ReadConnection_() //{ */
+
+int FleetReactor::ReadConnection_(const std::shared_ptr<Connection_>& connection, std::unique_lock<std::mutex>& lock, std::vector<Pending_>& failed) {
+
+  bool closed = false;
+
+  while (true) {
+
+    const auto writable = connection->receive_buffer.PrepareWrite(RECEIVE_CHUNK_SIZE);
+    const auto size     = ::recv(connection->fd, writable.data(), writable.size(), 0);
+
+    if (size > 0) {
+      connection->receive_buffer.Commit(static_cast<size_t>(size));
+      continue;
+    }
+
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+
+    closed = size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+    break;
+  }
+
+  const auto header_size = FrameHeaderSize(connection->frame_mode);
+  int        completed   = 0;
+
+  while (connection->receive_buffer.ReadableSize() >= header_size) {
+
+    const auto data         = connection->receive_buffer.Readable();
+    const auto payload_size = ReadFrameHeader(data.data());
+
+    if (payload_size == 0 || payload_size > MAX_FRAME_SIZE) {
+      std::cerr << "FLEET-REACTOR invalid frame size " << payload_size << ", disconnecting drone " << connection->id << std::endl;
+      closed = true;
+      break;
+    }
+
+    if (data.size() < header_size + payload_size) {
+      break;
+    }
+
+    auto pending = connection->pending.begin();
+
+    if (connection->frame_mode == FrameMode::SEQUENCED) {
+      const auto sequence = ReadFrameHeader(data.data() + FRAME_HEADER_SIZE);
+      pending = std::find_if(connection->pending.begin(), connection->pending.end(), [sequence](const Pending_& p) { return p.sequence == sequence; });
+    }
+
+    // a response nobody waits for (e.g. of a request failed by RemoveDrone()) is dropped
+    if (pending != connection->pending.end()) {
+
+      auto completion = std::move(pending->completion);
+      connection->pending.erase(pending);
+
+      lock.unlock();
+      completion(true, data.subspan(header_size, payload_size));
+      lock.lock();
+
+      completed++;
+    }
+
+    connection->receive_buffer.Consume(header_size + payload_size);
+  }
+
+  if (closed) {
+    CloseConnection_(*connection, failed);
+  }
+
+  return completed;
+}
+
+//}
+
+/* CloseConnection_() //{ */
+
+void FleetReactor::CloseConnection_(Connection_& connection, std::vector<Pending_>& failed) {
+
+  if (connection.fd < 0) {
+    return;
+  }
+
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+  ::close(connection.fd);
+  connection.fd = -1;
+
+  std::move(connection.pending.begin(), connection.pending.end(), std::back_inserter(failed));
+  connection.pending.clear();
+
+  connection.receive_buffer.Clear();
+  connection.send_offset = 0;
+  connection.send_size   = 0;
+}
+
+//}
+
+/* Handshake_() //{ */
+
+bool FleetReactor::Handshake_(int fd, FrameMode frame_mode) {
+
+  Serializable::Common::SetFrameMode::Request request{};
+  request.frame_mode = frame_mode;
+
+  // the handshake itself still uses the sentinel framing
+  std::array<std::byte, 16> request_data;
+  SpanOutputArchive         oa(request_data);
+  oa(request);
+
+  if (::send(fd, request_data.data(), oa.written(), MSG_NOSIGNAL) != static_cast<ssize_t>(oa.written())) {
+    return false;
+  }
+
+  std::array<std::byte, 64> response_data;
+  size_t                    size = 0;
+
+  while (size < END_OF_MESSAGE_LENGTH || response_data[size - 1] != std::byte{'$'} || response_data[size - 2] != std::byte{'$'} ||
+         response_data[size - 3] != std::byte{'$'}) {
+
+    pollfd descriptor{fd, POLLIN, 0};
+
+    if (size == response_data.size() || ::poll(&descriptor, 1, REACTOR_HANDSHAKE_TIMEOUT_MS) <= 0) {
+      return false;
+    }
+
+    const auto received = ::recv(fd, response_data.data() + size, response_data.size() - size, 0);
+    if (received <= 0) {
+      return false;
+    }
+
+    size += static_cast<size_t>(received);
+  }
+
+  Serializable::Common::SetFrameMode::Response response{};
+
+  try {
+    SpanInputArchive ia(std::span<const std::byte>(response_data.data(), size - END_OF_MESSAGE_LENGTH));
+    ia(response);
+  }
+  catch (cereal::Exception& exception) {
+    std::cerr << "FLEET-REACTOR handshake failed: " << exception.what() << std::endl;
+    return false;
+  }
+
+  return response.status;
+}
+
+//}
@@ -6,16 +6,149 @@
 #include <sstream>
 
 using kissnet::socket_status;
+using ueds_connector::BatchRequest;
 using ueds_connector::Coordinates;
+using ueds_connector::LidarCloud;
 using ueds_connector::LidarConfig;
 using ueds_connector::LidarData;
 using ueds_connector::LidarIntData;
 using ueds_connector::LidarSegData;
 using ueds_connector::RgbCameraConfig;
 using ueds_connector::Rotation;
+using ueds_connector::SensorStream;
+using ueds_connector::SharedFrameDescriptor;
+using ueds_connector::SharedFrameView;
 using ueds_connector::StereoCameraConfig;
+using ueds_connector::StreamFrame;
+using ueds_connector::StreamQueue;
 using ueds_connector::UedsConnector;
 
+namespace
+{
+
+/* CopySharedFrame() //{ */
+
+// fails if the producer rewrote the slot while it was being copied
+bool CopySharedFrame(const SharedFrameView& view, std::span<const unsigned char> part, std::vector<unsigned char>& image) {
+  image.assign(part.begin(), part.end());
+  return view.IsValid();
+}
+
+//}
+
+/* LoadSharedScan() //{ */
+
+template <typename TCloudResponse>
+bool LoadSharedScan(const SharedFrameView& view, LidarCloud& cloud) {
+  TCloudResponse::LoadBeams(cloud, std::as_bytes(view.GetData()));
+  cloud.start = view.GetStart();
+  return view.IsValid();
+}
+
+//}
+
+/* SensorMessageType() //{ */
+
+// the pushes of a stream are the responses to the data request of its sensor
+unsigned short SensorMessageType(SensorStream stream) {
+
+  namespace Drone = Serializable::Drone;
+
+  switch (stream) {
+    case SensorStream::LIDAR:
+      return Drone::MessageType::get_lidar_data;
+    case SensorStream::LIDAR_SEG:
+      return Drone::MessageType::get_lidar_seg;
+    case SensorStream::LIDAR_INT:
+      return Drone::MessageType::get_lidar_int;
+    case SensorStream::RANGEFINDER:
+      return Drone::MessageType::get_rangefinder_data;
+    case SensorStream::RGB_CAMERA:
+      return Drone::MessageType::get_rgb_camera_data;
+    case SensorStream::RGB_SEGMENTED:
+      return Drone::MessageType::get_rgb_seg_camera_data;
+    case SensorStream::STEREO_CAMERA:
+      return Drone::MessageType::get_stereo_camera_data;
+  }
+
+  return 0;
+}
+
+//}
+
+/* DecodeStreamFrame() //{ */
+
+bool DecodeStreamFrame(std::span<const std::byte> message, StreamFrame& frame) {
+
+  namespace Drone = Serializable::Drone;
+
+  try {
+    ueds_connector::SpanInputArchive ia(message);
+
+    switch (frame.stream) {
+
+      case SensorStream::LIDAR: {
+        Drone::GetLidarData::CloudResponse response(frame.cloud);
+        ia(response);
+        return response.status;
+      }
+
+      case SensorStream::LIDAR_SEG: {
+        Drone::GetLidarSegData::CloudResponse response(frame.cloud);
+        ia(response);
+        return response.status;
+      }
+
+      case SensorStream::LIDAR_INT: {
+        Drone::GetLidarIntData::CloudResponse response(frame.cloud);
+        ia(response);
+        return response.status;
+      }
+
+      case SensorStream::RANGEFINDER: {
+        Drone::GetRangefinderData::Response response{};
+        ia(response);
+        frame.range = response.range;
+        return response.status;
+      }
+
+      case SensorStream::RGB_CAMERA: {
+        Drone::GetRgbCameraData::Response response{};
+        ia(response);
+        frame.image = std::move(response.image_);
+        frame.stamp = response.stamp_;
+        return response.status;
+      }
+
+      case SensorStream::RGB_SEGMENTED: {
+        Drone::GetRgbSegCameraData::Response response{};
+        ia(response);
+        frame.image = std::move(response.image_);
+        frame.stamp = response.stamp_;
+        return response.status;
+      }
+
+      case SensorStream::STEREO_CAMERA: {
+        Drone::GetStereoCameraData::Response response{};
+        ia(response);
+        frame.image       = std::move(response.image_left_);
+        frame.image_right = std::move(response.image_right_);
+        frame.stamp       = response.stamp_;
+        return response.status;
+      }
+    }
+  }
+  catch (cereal::Exception& exception) {
+    std::cerr << "SENSOR-STREAM malformed push: " << exception.what() << std::endl;
+  }
+
+  return false;
+}
+
+//}
+
+}  // namespace
+
 /* getLocation() //{ */
 
 std::pair<bool, Coordinates> UedsConnector::GetLocation() {
@@ -91,15 +224,48 @@ std::tuple<bool, Coordinates, bool, Coordinates> UedsConnector::SetLocation(cons
 
 std::tuple<bool, std::vector<unsigned char>, double, uint32_t> UedsConnector::GetRgbCameraData() {
 
+  std::vector<unsigned char> image;
+  double                     stamp = 0.0;
+
+  const auto success = GetRgbCameraData(image, stamp);
+  const auto size    = static_cast<uint32_t>(image.size());
+
+  return std::make_tuple(success, std::move(image), stamp, size);
+}
+
+bool UedsConnector::GetRgbCameraData(std::vector<unsigned char>& image, double& stamp) {
+
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetRgbCameraFrame(view) && CopySharedFrame(view, view.GetData(), image);
+
+    if (!success) {
+      image.clear();
+    }
+
+    stamp = success ? view.GetStamp() : 0.0;
+    return success;
+  }
+
   Serializable::Drone::GetRgbCameraData::Request request{};
 
   Serializable::Drone::GetRgbCameraData::Response response{};
 
+  // lend the caller's buffer to the response, the archive resizes it in place
+  response.image_.swap(image);
+
   const auto status  = Request(request, response);
   const auto success = status && response.status;
 
-  return std::make_tuple(success, success ? response.image_ : std::vector<unsigned char>(), success ? response.stamp_ : 0.0,
-                         success ? response.image_.size() : 0);
+  image.swap(response.image_);
+
+  if (!success) {
+    image.clear();
+  }
+
+  stamp = success ? response.stamp_ : 0.0;
+
+  return success;
 }
 
 //}
@@ -108,15 +274,52 @@ std::tuple<bool, std::vector<unsigned char>, double, uint32_t> UedsConnector::Ge
 
 std::tuple<bool, std::vector<unsigned char>, std::vector<unsigned char>, double> UedsConnector::GetStereoCameraData() {
 
+  std::vector<unsigned char> image_left;
+  std::vector<unsigned char> image_right;
+  double                     stamp = 0.0;
+
+  const auto success = GetStereoCameraData(image_left, image_right, stamp);
+
+  return std::make_tuple(success, std::move(image_left), std::move(image_right), stamp);
+}
+
+bool UedsConnector::GetStereoCameraData(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right, double& stamp) {
+
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetStereoCameraFrame(view) && CopySharedFrame(view, view.GetFirst(), image_left) &&
+                         CopySharedFrame(view, view.GetSecond(), image_right);
+
+    if (!success) {
+      image_left.clear();
+      image_right.clear();
+    }
+
+    stamp = success ? view.GetStamp() : 0.0;
+    return success;
+  }
+
   Serializable::Drone::GetStereoCameraData::Request request{};
 
   Serializable::Drone::GetStereoCameraData::Response response{};
 
+  response.image_left_.swap(image_left);
+  response.image_right_.swap(image_right);
+
   const auto status  = Request(request, response);
   const auto success = status && response.status;
 
-  return std::make_tuple(success, success ? response.image_left_ : std::vector<unsigned char>(), success ? response.image_right_ : std::vector<unsigned char>(),
-                         success ? response.stamp_ : 0.0);
+  image_left.swap(response.image_left_);
+  image_right.swap(response.image_right_);
+
+  if (!success) {
+    image_left.clear();
+    image_right.clear();
+  }
+
+  stamp = success ? response.stamp_ : 0.0;
+
+  return success;
 }
 
 //}
@@ -125,14 +328,47 @@ std::tuple<bool, std::vector<unsigned char>, std::vector<unsigned char>, double>
 
 std::tuple<bool, std::vector<unsigned char>, double, uint32_t> UedsConnector::GetRgbSegmented() {
 
+  std::vector<unsigned char> image;
+  double                     stamp = 0.0;
+
+  const auto success = GetRgbSegmented(image, stamp);
+  const auto size    = static_cast<uint32_t>(image.size());
+
+  return std::make_tuple(success, std::move(image), stamp, size);
+}
+
+bool UedsConnector::GetRgbSegmented(std::vector<unsigned char>& image, double& stamp) {
+
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetRgbSegmentedFrame(view) && CopySharedFrame(view, view.GetData(), image);
+
+    if (!success) {
+      image.clear();
+    }
+
+    stamp = success ? view.GetStamp() : 0.0;
+    return success;
+  }
+
   Serializable::Drone::GetRgbSegCameraData::Request request{};
 
   Serializable::Drone::GetRgbSegCameraData::Response response{};
-  const auto                                         status  = Request(request, response);
-  const auto                                         success = status && response.status;
 
-  return std::make_tuple(success, success ? response.image_ : std::vector<unsigned char>(), success ? response.stamp_ : 0.0,
-                         success ? response.image_.size() : 0);
+  response.image_.swap(image);
+
+  const auto status  = Request(request, response);
+  const auto success = status && response.status;
+
+  image.swap(response.image_);
+
+  if (!success) {
+    image.clear();
+  }
+
+  stamp = success ? response.stamp_ : 0.0;
+
+  return success;
 }
 
 //}
@@ -263,37 +499,64 @@ std::tuple<bool> UedsConnector::SetLocationAndRotationAsync(const Coordinates& c
 
 std::tuple<bool, std::vector<LidarData>, Coordinates> UedsConnector::GetLidarData() {
 
-  /* std::cout << "GetLidarData()" << std::endl; */
-  Serializable::Drone::GetLidarData::Request request{};
+  LidarCloud             cloud;
+  std::vector<LidarData> lidarData;
 
-  Serializable::Drone::GetLidarData::Response response{};
-  const auto                                  status  = Request(request, response);
-  const auto                                  success = status && response.status;
-  std::vector<LidarData>                      lidarData;
-  Coordinates                                 start{};
+  const auto success = GetLidarData(cloud);
 
   if (success) {
 
-    const auto arrSize = response.lidarData.size();
-    lidarData.resize(arrSize);
+    lidarData.resize(cloud.size());
+
+    for (size_t i = 0; i < cloud.size(); i++) {
+      lidarData[i].distance   = cloud.distance[i];
+      lidarData[i].directionX = cloud.dir_x[i];
+      lidarData[i].directionY = cloud.dir_y[i];
+      lidarData[i].directionZ = cloud.dir_z[i];
+    }
+  }
+
+  return std::make_tuple(success, lidarData, success ? cloud.start : Coordinates{});
+}
+
+bool UedsConnector::GetLidarData(LidarCloud& cloud) {
+
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetLidarDataFrame(view) && LoadSharedScan<Serializable::Drone::GetLidarData::CloudResponse>(view, cloud);
 
-    for (size_t i = 0; i < arrSize; i++) {
-      lidarData[i]            = LidarData{};
-      lidarData[i].distance   = response.lidarData[i].distance;
-      lidarData[i].directionX = response.lidarData[i].directionX;
-      lidarData[i].directionY = response.lidarData[i].directionY;
-      lidarData[i].directionZ = response.lidarData[i].directionZ;
+    if (!success) {
+      cloud.clear();
     }
 
-    start.x = response.startX;
-    start.y = response.startY;
-    start.z = response.startZ;
+    return success;
   }
 
-  // std::cout << "Get lidar data drone controller: " << success << std::endl;
-  return std::make_tuple(success, lidarData, start);
+  if (lidar_quantization_) {
+    return GetLidarQuantized_(Serializable::Drone::MessageType::get_lidar_data, cloud, nullptr);
+  }
+
+  if (lidar_distance_only_) {
+    return GetLidarDistances_(Serializable::Drone::MessageType::get_lidar_data, cloud, nullptr);
+  }
+
+  Serializable::Drone::GetLidarData::Request request{};
+
+  Serializable::Drone::GetLidarData::CloudResponse response(cloud);
+  const auto                                       status  = Request(request, response);
+  const auto                                       success = status && response.status;
+
+  if (!success) {
+    cloud.clear();
+  }
+
+  return success;
 }
 
+//}
+
+/* getRangefinderData() //{ */
+
 std::tuple<bool, double> ueds_connector::UedsConnector::GetRangefinderData()
 {
   Serializable::Drone::GetRangefinderData::Request request{};
@@ -308,73 +571,123 @@ std::tuple<bool, double> ueds_connector::UedsConnector::GetRangefinderData()
 /* getLidarSegData() //{ */
 
 std::tuple<bool, std::vector<LidarSegData>, Coordinates> UedsConnector::GetLidarSegData() {
-  Serializable::Drone::GetLidarSegData::Request request{};
 
-  Serializable::Drone::GetLidarSegData::Response response{};
-  const auto                                     status  = Request(request, response);
-  const auto                                     success = status && response.status;
-  std::vector<LidarSegData>                      lidarSegData;
-  Coordinates                                    start{};
+  LidarCloud                cloud;
+  std::vector<LidarSegData> lidarSegData;
+
+  const auto success = GetLidarSegData(cloud);
 
   if (success) {
 
-    const auto arrSize = response.lidarSegData.size();
-    lidarSegData.resize(arrSize);
+    lidarSegData.resize(cloud.size());
+
+    for (size_t i = 0; i < cloud.size(); i++) {
+      lidarSegData[i].distance     = cloud.distance[i];
+      lidarSegData[i].directionX   = cloud.dir_x[i];
+      lidarSegData[i].directionY   = cloud.dir_y[i];
+      lidarSegData[i].directionZ   = cloud.dir_z[i];
+      lidarSegData[i].segmentation = cloud.label[i];
+    }
+  }
+
+  return std::make_tuple(success, lidarSegData, success ? cloud.start : Coordinates{});
+}
+
+bool UedsConnector::GetLidarSegData(LidarCloud& cloud) {
 
-    for (size_t i = 0; i < arrSize; i++) {
-      lidarSegData[i]              = LidarSegData{};
-      lidarSegData[i].distance     = response.lidarSegData[i].distance;
-      lidarSegData[i].directionX   = response.lidarSegData[i].directionX;
-      lidarSegData[i].directionY   = response.lidarSegData[i].directionY;
-      lidarSegData[i].directionZ   = response.lidarSegData[i].directionZ;
-      lidarSegData[i].segmentation = response.lidarSegData[i].segmentation;
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetLidarSegDataFrame(view) && LoadSharedScan<Serializable::Drone::GetLidarSegData::CloudResponse>(view, cloud);
+
+    if (!success) {
+      cloud.clear();
     }
 
-    start.x = response.startX;
-    start.y = response.startY;
-    start.z = response.startZ;
+    return success;
+  }
+
+  if (lidar_quantization_) {
+    return GetLidarQuantized_(Serializable::Drone::MessageType::get_lidar_seg, cloud, &cloud.label);
   }
 
-  // std::cout << "Get lidar data drone controller: " << success << std::endl;
-  return std::make_tuple(success, lidarSegData, start);
+  if (lidar_distance_only_) {
+    return GetLidarDistances_(Serializable::Drone::MessageType::get_lidar_seg, cloud, &cloud.label);
+  }
+
+  Serializable::Drone::GetLidarSegData::Request request{};
+
+  Serializable::Drone::GetLidarSegData::CloudResponse response(cloud);
+  const auto                                          status  = Request(request, response);
+  const auto                                          success = status && response.status;
+
+  if (!success) {
+    cloud.clear();
+  }
+
+  return success;
 }
+
 //}
 
 /* getLidarIntData() //{ */
 
 std::tuple<bool, std::vector<LidarIntData>, Coordinates> UedsConnector::GetLidarIntData() {
 
-  /* std::cout << "GetLidarIntData()" << std::endl; */
-
-  Serializable::Drone::GetLidarIntData::Request request{};
+  LidarCloud                cloud;
+  std::vector<LidarIntData> lidarIntData;
 
-  Serializable::Drone::GetLidarIntData::Response response{};
-  const auto                                     status  = Request(request, response);
-  const auto                                     success = status && response.status;
-  std::vector<LidarIntData>                      lidarIntData;
-  Coordinates                                    start{};
+  const auto success = GetLidarIntData(cloud);
 
   if (success) {
 
-    const auto arrSize = response.lidarIntData.size();
-    lidarIntData.resize(arrSize);
+    lidarIntData.resize(cloud.size());
 
-    for (size_t i = 0; i < arrSize; i++) {
-      lidarIntData[i]            = LidarIntData{};
-      lidarIntData[i].distance   = response.lidarIntData[i].distance;
-      lidarIntData[i].directionX = response.lidarIntData[i].directionX;
-      lidarIntData[i].directionY = response.lidarIntData[i].directionY;
-      lidarIntData[i].directionZ = response.lidarIntData[i].directionZ;
-      lidarIntData[i].intensity  = response.lidarIntData[i].intensity;
+    for (size_t i = 0; i < cloud.size(); i++) {
+      lidarIntData[i].distance   = cloud.distance[i];
+      lidarIntData[i].directionX = cloud.dir_x[i];
+      lidarIntData[i].directionY = cloud.dir_y[i];
+      lidarIntData[i].directionZ = cloud.dir_z[i];
+      lidarIntData[i].intensity  = cloud.intensity[i];
     }
+  }
 
-    start.x = response.startX;
-    start.y = response.startY;
-    start.z = response.startZ;
+  return std::make_tuple(success, lidarIntData, success ? cloud.start : Coordinates{});
+}
+
+bool UedsConnector::GetLidarIntData(LidarCloud& cloud) {
+
+  if (shared_frames_.IsOpen()) {
+    SharedFrameView view;
+    const auto      success = GetLidarIntDataFrame(view) && LoadSharedScan<Serializable::Drone::GetLidarIntData::CloudResponse>(view, cloud);
+
+    if (!success) {
+      cloud.clear();
+    }
+
+    return success;
   }
 
-  return std::make_tuple(success, lidarIntData, start);
+  if (lidar_quantization_) {
+    return GetLidarQuantized_(Serializable::Drone::MessageType::get_lidar_int, cloud, &cloud.intensity);
+  }
+
+  if (lidar_distance_only_) {
+    return GetLidarDistances_(Serializable::Drone::MessageType::get_lidar_int, cloud, &cloud.intensity);
+  }
+
+  Serializable::Drone::GetLidarIntData::Request request{};
+
+  Serializable::Drone::GetLidarIntData::CloudResponse response(cloud);
+  const auto                                          status  = Request(request, response);
+  const auto                                          success = status && response.status;
+
+  if (!success) {
+    cloud.clear();
+  }
+
+  return success;
 }
+
 //}
 
 /* getLidarConfig() //{ */
@@ -450,11 +763,176 @@ bool UedsConnector::SetLidarConfig(const LidarConfig& config) {
   const auto status  = Request(request, response);
   const auto success = status && response.status;
 
+  if (success) {
+    std::scoped_lock lock(settings_mutex_);
+    lidar_config_ = config;
+  }
+
+  // the beam pattern follows the config
+  if (success) {
+    std::scoped_lock lock(lidar_directions_mutex_);
+    lidar_directions_.Invalidate();
+  }
+
   return success;
 }
 
 //}
 
+/* EnableLidarDistanceOnly() //{ */
+
+bool UedsConnector::EnableLidarDistanceOnly(const std::pair<int, int>& api_version) {
+
+  lidar_distance_only_ = SupportsLidarDistances(api_version.first, api_version.second);
+
+  return lidar_distance_only_;
+}
+
+//}
+
+/* DisableLidarDistanceOnly() //{ */
+
+void UedsConnector::DisableLidarDistanceOnly() {
+  lidar_distance_only_ = false;
+}
+
+//}
+
+/* EnableLidarQuantization() //{ */
+
+bool UedsConnector::EnableLidarQuantization(const std::pair<int, int>& api_version, double resolution) {
+
+  lidar_quantization_resolution_ = resolution;
+  lidar_quantization_            = SupportsLidarQuantization(api_version.first, api_version.second);
+
+  return lidar_quantization_;
+}
+
+//}
+
+/* DisableLidarQuantization() //{ */
+
+void UedsConnector::DisableLidarQuantization() {
+  lidar_quantization_ = false;
+}
+
+//}
+
+/* GetLidarScan_() //{ */
+
+bool UedsConnector::GetLidarScan_(unsigned short source, LidarCloud& cloud) {
+
+  switch (source) {
+    case Serializable::Drone::MessageType::get_lidar_seg:
+      return GetLidarSegData(cloud);
+    case Serializable::Drone::MessageType::get_lidar_int:
+      return GetLidarIntData(cloud);
+    default:
+      return GetLidarData(cloud);
+  }
+}
+
+//}
+
+/* GetLidarDistances_() //{ */
+
+bool UedsConnector::GetLidarDistances_(unsigned short source, LidarCloud& cloud, std::vector<int>* extra) {
+
+  Serializable::Drone::GetLidarDistances::Request request{};
+  request.source = source;
+
+  Serializable::Drone::GetLidarDistances::CloudResponse response(cloud, extra);
+  const auto                                            status = Request(request, response);
+
+  if (!status) {
+    cloud.clear();
+    return false;
+  }
+
+  // a pattern without a fixed table, e.g. Livox, the full scan is requested now and from now on
+  if (!response.status) {
+    std::cerr << "LIDAR-DISTANCES refused by the server, requesting the full scans" << std::endl;
+    DisableLidarDistanceOnly();
+    return GetLidarScan_(source, cloud);
+  }
+
+  return ApplyLidarDirections_(response.table_id, cloud);
+}
+
+//}
+
+/* GetLidarQuantized_() //{ */
+
+bool UedsConnector::GetLidarQuantized_(unsigned short source, LidarCloud& cloud, std::vector<int>* extra) {
+
+  Serializable::Drone::GetLidarQuantized::Request request{};
+  request.source     = source;
+  request.resolution = lidar_quantization_resolution_;
+
+  Serializable::Drone::GetLidarQuantized::CloudResponse response(cloud, extra);
+  const auto                                            status = Request(request, response);
+
+  if (!status) {
+    cloud.clear();
+    return false;
+  }
+
+  // as the distance-only scans, the patterns without a fixed table are sent in full
+  if (!response.status) {
+    std::cerr << "LIDAR-QUANTIZED refused by the server, requesting the unquantized scans" << std::endl;
+    DisableLidarQuantization();
+    return GetLidarScan_(source, cloud);
+  }
+
+  return ApplyLidarDirections_(response.table_id, cloud);
+}
+
+//}
+
+/* ApplyLidarDirections_() //{ */
+
+bool UedsConnector::ApplyLidarDirections_(uint32_t table_id, LidarCloud& cloud) {
+
+  const auto beams = cloud.size();
+
+  {
+    std::scoped_lock lock(lidar_directions_mutex_);
+
+    if (lidar_directions_.Matches(table_id, beams)) {
+      lidar_directions_.Apply(cloud);
+      return true;
+    }
+  }
+
+  // first scan of the pattern, the table is fetched without the lock so a reset of the connection can drop the cache meanwhile
+  Serializable::Drone::GetLidarDirections::Request request{};
+
+  Serializable::Drone::GetLidarDirections::Response response{};
+  const auto                                        status = Request(request, response);
+
+  const auto success = status && response.status && response.table_id == table_id && response.directionX.size() == beams &&
+                       response.directionY.size() == beams && response.directionZ.size() == beams;
+
+  if (!success) {
+    cloud.clear();
+    return false;
+  }
+
+  std::scoped_lock lock(lidar_directions_mutex_);
+
+  lidar_directions_.id    = response.table_id;
+  lidar_directions_.valid = true;
+  lidar_directions_.dir_x = std::move(response.directionX);
+  lidar_directions_.dir_y = std::move(response.directionY);
+  lidar_directions_.dir_z = std::move(response.directionZ);
+
+  lidar_directions_.Apply(cloud);
+
+  return true;
+}
+
+//}
+
 /* getRgbCameraConfig() //{ */
 
 std::pair<bool, RgbCameraConfig> UedsConnector::GetRgbCameraConfig() {
@@ -562,6 +1040,11 @@ bool UedsConnector::SetRgbCameraConfig(const RgbCameraConfig& config) {
   const auto status  = Request(request, response);
   const auto success = status && response.status;
 
+  if (success) {
+    std::scoped_lock lock(settings_mutex_);
+    rgb_camera_config_ = config;
+  }
+
   return success;
 }
 
@@ -600,6 +1083,11 @@ bool UedsConnector::SetStereoCameraConfig(const StereoCameraConfig& config) {
   const auto status  = Request(request, response);
   const auto success = status && response.status;
 
+  if (success) {
+    std::scoped_lock lock(settings_mutex_);
+    stereo_camera_config_ = config;
+  }
+
   return success;
 }
 
@@ -631,7 +1119,486 @@ bool UedsConnector::SetMoveLineVisible(bool visible) {
   const auto                                        status  = Request(request, response);
   const auto                                        success = status && response.status;
 
+  if (success) {
+    std::scoped_lock lock(settings_mutex_);
+    move_line_visible_ = visible;
+  }
+
   return success;
 }
 
 //}
+
+/* executeBatch() //{ */
+
+bool UedsConnector::ExecuteBatch(BatchRequest& batch) {
+
+  if (batch.IsEmpty()) {
+    return true;
+  }
+
+  // the batch itself is the response, its entries are deserialized straight into the responses of the added requests
+  const auto status = Request(batch.GetRequest(), batch);
+
+  return status && batch.IsExecuted();
+}
+
+//}
+
+/* asynchronous variants //{ */
+
+std::future<std::pair<bool, Coordinates>> UedsConnector::GetLocationAsync() {
+  return RunAsync([this] { return GetLocation(); });
+}
+
+std::future<std::pair<bool, Rotation>> UedsConnector::GetRotationAsync() {
+  return RunAsync([this] { return GetRotation(); });
+}
+
+std::future<std::pair<bool, bool>> UedsConnector::GetCrashStateAsync() {
+  return RunAsync([this] { return GetCrashState(); });
+}
+
+std::future<std::tuple<bool, Coordinates, bool, Coordinates>> UedsConnector::SetLocationAsync(const Coordinates& coordinates, bool checkCollisions) {
+  return RunAsync([this, coordinates, checkCollisions] { return SetLocation(coordinates, checkCollisions); });
+}
+
+std::future<std::tuple<bool, Rotation, bool, Coordinates>> UedsConnector::SetRotationAsync(const Rotation& rotation) {
+  return RunAsync([this, rotation] { return SetRotation(rotation); });
+}
+
+std::future<std::tuple<bool, std::vector<unsigned char>, double, uint32_t>> UedsConnector::GetRgbCameraDataAsync() {
+  return RunAsync([this] { return GetRgbCameraData(); });
+}
+
+std::future<bool> UedsConnector::GetRgbCameraDataAsync(std::vector<unsigned char>& image, double& stamp) {
+  return RunAsync([this, &image, &stamp] { return GetRgbCameraData(image, stamp); });
+}
+
+std::future<bool> UedsConnector::GetStereoCameraDataAsync(std::vector<unsigned char>& image_left, std::vector<unsigned char>& image_right, double& stamp) {
+  return RunAsync([this, &image_left, &image_right, &stamp] { return GetStereoCameraData(image_left, image_right, stamp); });
+}
+
+std::future<bool> UedsConnector::GetRgbSegmentedAsync(std::vector<unsigned char>& image, double& stamp) {
+  return RunAsync([this, &image, &stamp] { return GetRgbSegmented(image, stamp); });
+}
+
+std::future<std::tuple<bool, double>> UedsConnector::GetRangefinderDataAsync() {
+  return RunAsync([this] { return GetRangefinderData(); });
+}
+
+std::future<bool> UedsConnector::GetLidarDataAsync(LidarCloud& cloud) {
+  return RunAsync([this, &cloud] { return GetLidarData(cloud); });
+}
+
+std::future<bool> UedsConnector::GetLidarSegDataAsync(LidarCloud& cloud) {
+  return RunAsync([this, &cloud] { return GetLidarSegData(cloud); });
+}
+
+std::future<bool> UedsConnector::GetLidarIntDataAsync(LidarCloud& cloud) {
+  return RunAsync([this, &cloud] { return GetLidarIntData(cloud); });
+}
+
+std::future<bool> UedsConnector::ExecuteBatchAsync(BatchRequest& batch) {
+  return RunAsync([this, &batch] { return ExecuteBatch(batch); });
+}
+
+//}
+
+/* shared frames //{ */
+
+/* EnableSharedFrames() //{ */
+
+bool UedsConnector::EnableSharedFrames(const std::pair<int, int>& api_version, uint32_t slot_count, uint32_t slot_size) {
+
+  if (shared_frames_.IsOpen()) {
+    return true;
+  }
+
+  if (!SupportsSharedFrames(api_version.first, api_version.second)) {
+    return false;
+  }
+
+  Serializable::Common::SetSharedFrames::Request request{};
+  request.enable     = true;
+  request.slot_count = slot_count;
+  request.slot_size  = slot_size;
+
+  Serializable::Common::SetSharedFrames::Response response{};
+  const auto                                      status = Request(request, response);
+
+  if (!status || !response.status) {
+    return false;
+  }
+
+  // a server on another host created the region in its own memory
+  if (!shared_frames_.Open(response.name)) {
+    std::cerr << "SHARED-FRAMES cannot map '" << response.name << "', keeping the socket transfer" << std::endl;
+    DisableSharedFrames();
+    return false;
+  }
+
+  std::scoped_lock lock(settings_mutex_);
+  shared_frames_settings_ = SharedFramesSettings_{api_version, slot_count, slot_size};
+
+  return true;
+}
+
+//}
+
+/* DisableSharedFrames() //{ */
+
+bool UedsConnector::DisableSharedFrames() {
+
+  shared_frames_.Close();
+
+  {
+    std::scoped_lock lock(settings_mutex_);
+    shared_frames_settings_.reset();
+  }
+
+  Serializable::Common::SetSharedFrames::Request request{};
+  request.enable     = false;
+  request.slot_count = 0;
+  request.slot_size  = 0;
+
+  Serializable::Common::SetSharedFrames::Response response{};
+  const auto                                      status = Request(request, response);
+
+  return status && response.status;
+}
+
+//}
+
+/* OnConnectionReset_() //{ */
+
+void UedsConnector::OnConnectionReset_() {
+
+  shared_frames_.Close();
+
+  // a restarted server may number its patterns from the start again
+  std::scoped_lock lock(lidar_directions_mutex_);
+  lidar_directions_.Invalidate();
+}
+
+//}
+
+/* OnReconnected_() //{ */
+
+bool UedsConnector::OnReconnected_() {
+
+  std::optional<LidarConfig>           lidar_config;
+  std::optional<RgbCameraConfig>       rgb_camera_config;
+  std::optional<StereoCameraConfig>    stereo_camera_config;
+  std::optional<bool>                  move_line_visible;
+  std::optional<SharedFramesSettings_> shared_frames_settings;
+
+  {
+    std::scoped_lock lock(settings_mutex_);
+    lidar_config           = lidar_config_;
+    rgb_camera_config      = rgb_camera_config_;
+    stereo_camera_config   = stereo_camera_config_;
+    move_line_visible      = move_line_visible_;
+    shared_frames_settings = shared_frames_settings_;
+  }
+
+  if (lidar_config && !SetLidarConfig(*lidar_config)) {
+    return false;
+  }
+
+  if (rgb_camera_config && !SetRgbCameraConfig(*rgb_camera_config)) {
+    return false;
+  }
+
+  if (stereo_camera_config && !SetStereoCameraConfig(*stereo_camera_config)) {
+    return false;
+  }
+
+  if (move_line_visible && !SetMoveLineVisible(*move_line_visible)) {
+    return false;
+  }
+
+  // the frames keep coming over the socket if the ring cannot be mapped anymore, the connection is usable either way
+  if (shared_frames_settings) {
+    EnableSharedFrames(shared_frames_settings->api_version, shared_frames_settings->slot_count, shared_frames_settings->slot_size);
+  }
+
+  std::vector<std::pair<SensorStream, double>> subscriptions;
+
+  {
+    std::scoped_lock lock(stream_mutex_);
+    for (const auto& [stream, subscription] : subscriptions_) {
+      subscriptions.emplace_back(stream, subscription.frequency);
+    }
+  }
+
+  for (const auto& [stream, frequency] : subscriptions) {
+    if (!RequestSubscription_(stream, frequency)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//}
+
+/* RequestSharedFrame_() //{ */
+
+template <typename TRequest>
+bool UedsConnector::RequestSharedFrame_(SharedFrameView& view) {
+
+  if (!shared_frames_.IsOpen()) {
+    return false;
+  }
+
+  TRequest request{};
+
+  Serializable::Common::FrameDescriptor::Response response{};
+  const auto                                      status = Request(request, response);
+
+  if (!status || !response.status) {
+    return false;
+  }
+
+  SharedFrameDescriptor descriptor;
+  descriptor.slot     = response.slot;
+  descriptor.sequence = response.sequence;
+  descriptor.size     = response.size;
+  descriptor.split    = response.split;
+  descriptor.stamp    = response.stamp_;
+  descriptor.start    = Coordinates(response.startX, response.startY, response.startZ);
+
+  return shared_frames_.View(descriptor, view);
+}
+
+//}
+
+bool UedsConnector::GetRgbCameraFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetRgbCameraData::Request>(view);
+}
+
+bool UedsConnector::GetStereoCameraFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetStereoCameraData::Request>(view);
+}
+
+bool UedsConnector::GetRgbSegmentedFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetRgbSegCameraData::Request>(view);
+}
+
+bool UedsConnector::GetLidarDataFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetLidarData::Request>(view);
+}
+
+bool UedsConnector::GetLidarSegDataFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetLidarSegData::Request>(view);
+}
+
+bool UedsConnector::GetLidarIntDataFrame(SharedFrameView& view) {
+  return RequestSharedFrame_<Serializable::Drone::GetLidarIntData::Request>(view);
+}
+
+//}
+
+/* subscriptions //{ */
+
+/* Subscribe() //{ */
+
+bool UedsConnector::Subscribe(SensorStream stream, std::function<void(const StreamFrame&)> callback, double frequency) {
+
+  Subscription_ subscription;
+  subscription.frequency = frequency;
+  subscription.callback  = std::move(callback);
+
+  return Subscribe_(stream, std::move(subscription));
+}
+
+bool UedsConnector::Subscribe(SensorStream stream, std::shared_ptr<StreamQueue> queue, double frequency) {
+
+  Subscription_ subscription;
+  subscription.frequency = frequency;
+  subscription.queue     = std::move(queue);
+
+  return Subscribe_(stream, std::move(subscription));
+}
+
+//}
+
+/* Unsubscribe() //{ */
+
+bool UedsConnector::Unsubscribe(SensorStream stream) {
+
+  {
+    std::scoped_lock lock(stream_mutex_);
+
+    if (subscriptions_.erase(stream) == 0) {
+      return false;
+    }
+  }
+
+  Serializable::Drone::Unsubscribe::Request request{};
+  request.sensor = SensorMessageType(stream);
+
+  // the pushes already on their way are dropped as nobody subscribes them anymore
+  Serializable::Drone::Unsubscribe::Response response{};
+  const auto                                 status = Request(request, response);
+
+  return status && response.status;
+}
+
+//}
+
+/* IsSubscribed() //{ */
+
+bool UedsConnector::IsSubscribed(SensorStream stream) const {
+  std::scoped_lock lock(stream_mutex_);
+  return subscriptions_.contains(stream);
+}
+
+//}
+
+/* Subscribe_() //{ */
+
+bool UedsConnector::Subscribe_(SensorStream stream, Subscription_ subscription) {
+
+  // the pushes cannot be told apart from the responses in the other framings
+  if (getFrameMode() != FrameMode::SEQUENCED || (!subscription.callback && !subscription.queue)) {
+    return false;
+  }
+
+  const auto frequency = subscription.frequency;
+
+  // registered first, the server may push right after its response
+  {
+    std::scoped_lock lock(stream_mutex_);
+    subscriptions_[stream] = std::move(subscription);
+  }
+
+  if (!RequestSubscription_(stream, frequency)) {
+    std::scoped_lock lock(stream_mutex_);
+    subscriptions_.erase(stream);
+    return false;
+  }
+
+  StartPushReceiver_();
+
+  return true;
+}
+
+//}
+
+/* RequestSubscription_() //{ */
+
+bool UedsConnector::RequestSubscription_(SensorStream stream, double frequency) {
+
+  Serializable::Drone::Subscribe::Request request{};
+  request.sensor    = SensorMessageType(stream);
+  request.frequency = frequency;
+
+  Serializable::Drone::Subscribe::Response response{};
+  const auto                               status = Request(request, response);
+
+  return status && response.status;
+}
+
+//}
+
+/* OnPushMessage_() //{ */
+
+void UedsConnector::OnPushMessage_(std::span<const std::byte> message) {
+
+  Serializable::Common::NetworkRequest header{};
+
+  try {
+    ueds_connector::SpanInputArchive ia(message);
+    ia(header);
+  }
+  catch (cereal::Exception&) {
+    return;
+  }
+
+  StreamFrame frame;
+  bool        subscribed = false;
+
+  {
+    std::scoped_lock lock(stream_mutex_);
+
+    for (const auto& [stream, subscription] : subscriptions_) {
+      if (SensorMessageType(stream) == header.type) {
+        frame.stream = stream;
+        subscribed   = true;
+        break;
+      }
+    }
+  }
+
+  // decoded right away, the message lives in the receive buffer only until the next read
+  if (!subscribed || !DecodeStreamFrame(message, frame)) {
+    return;
+  }
+
+  std::shared_ptr<StreamQueue> queue;
+
+  {
+    std::scoped_lock lock(stream_mutex_);
+
+    const auto subscription = subscriptions_.find(frame.stream);
+    if (subscription == subscriptions_.end()) {
+      return;
+    }
+
+    if (!subscription->second.queue) {
+
+      // drops the oldest frame of the stream like a StreamQueue, a callback slower than the sensor gets the most recent frames
+      const auto same_stream = [&frame](const StreamFrame& pending) { return pending.stream == frame.stream; };
+
+      if (std::count_if(pending_frames_.begin(), pending_frames_.end(), same_stream) >= STREAM_CALLBACK_PENDING_FRAMES) {
+        pending_frames_.erase(std::find_if(pending_frames_.begin(), pending_frames_.end(), same_stream));
+      }
+
+      pending_frames_.push_back(std::move(frame));
+      return;
+    }
+
+    queue = subscription->second.queue;
+  }
+
+  queue->Push(std::move(frame));
+}
+
+//}
+
+/* OnPushesReceived_() //{ */
+
+void UedsConnector::OnPushesReceived_() {
+
+  while (true) {
+
+    StreamFrame                             frame;
+    std::function<void(const StreamFrame&)> callback;
+
+    {
+      std::scoped_lock lock(stream_mutex_);
+
+      if (pending_frames_.empty()) {
+        return;
+      }
+
+      frame = std::move(pending_frames_.front());
+      pending_frames_.pop_front();
+
+      const auto subscription = subscriptions_.find(frame.stream);
+      if (subscription == subscriptions_.end() || !subscription->second.callback) {
+        continue;
+      }
+
+      callback = subscription->second.callback;
+    }
+
+    callback(frame);
+  }
+}
+
+//}
+
+//}
@@ -259,6 +259,36 @@ std::pair<bool, std::pair<int,int>> GameModeController::GetApiVersion() {
 
 //}
 
+/* negotiateFrameMode() //{ */
+
+bool GameModeController::NegotiateFrameMode(FrameMode frame_mode) {
+
+  const auto [success, api_version] = GetApiVersion();
+
+  if (!success) {
+    return false;
+  }
+
+  return NegotiateFrameMode(api_version, frame_mode);
+}
+
+//}
+
+/* negotiateCompression() //{ */
+
+bool GameModeController::NegotiateCompression(const CompressionOptions& options) {
+
+  const auto [success, api_version] = GetApiVersion();
+
+  if (!success) {
+    return false;
+  }
+
+  return NegotiateCompression(api_version, options);
+}
+
+//}
+
 /* getTime() //{ */
 
 std::pair<bool, double> GameModeController::GetTime() {
@@ -273,3 +303,27 @@ std::pair<bool, double> GameModeController::GetTime() {
 }
 
 //}
+
+/* asynchronous variants //{ */
+
+std::future<std::pair<bool, std::vector<int>>> GameModeController::GetDronesAsync() {
+  return RunAsync([this] { return GetDrones(); });
+}
+
+std::future<std::pair<bool, int>> GameModeController::SpawnDroneAsync() {
+  return RunAsync([this] { return SpawnDrone(); });
+}
+
+std::future<bool> GameModeController::RemoveDroneAsync(const int port) {
+  return RunAsync([this, port] { return RemoveDrone(port); });
+}
+
+std::future<std::pair<bool, float>> GameModeController::GetFpsAsync() {
+  return RunAsync([this] { return GetFps(); });
+}
+
+std::future<std::pair<bool, double>> GameModeController::GetTimeAsync() {
+  return RunAsync([this] { return GetTime(); });
+}
+
+//}
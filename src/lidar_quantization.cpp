@@ -0,0 +1,178 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/lidar_quantization.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+/* ReadUint16() //{ */
+
+inline uint16_t ReadUint16(const std::byte* source) {
+  return static_cast<uint16_t>(static_cast<uint16_t>(source[0]) | (static_cast<uint16_t>(source[1]) << 8));
+}
+
+//}
+
+/* Dequantize() //{ */
+
+void Dequantize(const std::byte* ranges, size_t size, double resolution, double* distance) {
+
+  size_t i = 0;
+
+#if defined(__AVX2__)
+
+  const __m256d scale = _mm256_set1_pd(resolution);
+
+  for (; i + 8 <= size; i += 8) {
+
+    const __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges + 2 * i)));
+
+    _mm256_storeu_pd(distance + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(wide)), scale));
+    _mm256_storeu_pd(distance + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(wide, 1)), scale));
+  }
+
+#elif defined(__SSE2__)
+
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128d scale = _mm_set1_pd(resolution);
+
+  for (; i + 8 <= size; i += 8) {
+
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges + 2 * i));
+    const __m128i low    = _mm_unpacklo_epi16(packed, zero);
+    const __m128i high   = _mm_unpackhi_epi16(packed, zero);
+
+    _mm_storeu_pd(distance + i, _mm_mul_pd(_mm_cvtepi32_pd(low), scale));
+    _mm_storeu_pd(distance + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(low, 8)), scale));
+    _mm_storeu_pd(distance + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(high), scale));
+    _mm_storeu_pd(distance + i + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(high, 8)), scale));
+  }
+
+#endif
+
+  // scalar fallback and the tail of the vectorized loops
+  for (; i < size; i++) {
+    distance[i] = static_cast<double>(ReadUint16(ranges + 2 * i)) * resolution;
+  }
+}
+
+//}
+
+/* Widen() //{ */
+
+template <size_t TValueSize>
+void Widen(const std::byte* values, size_t size, int* out) {
+
+  size_t i = 0;
+
+#if defined(__AVX2__)
+
+  for (; i + 8 <= size; i += 8) {
+
+    __m256i wide;
+
+    if constexpr (TValueSize == 1) {
+      wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i)));
+    } else {
+      wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + 2 * i)));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), wide);
+  }
+
+#elif defined(__SSE2__)
+
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 8 <= size; i += 8) {
+
+    __m128i packed;
+
+    if constexpr (TValueSize == 1) {
+      packed = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i)), zero);
+    } else {
+      packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + 2 * i));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(packed, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(packed, zero));
+  }
+
+#endif
+
+  for (; i < size; i++) {
+    if constexpr (TValueSize == 1) {
+      out[i] = static_cast<int>(values[i]);
+    } else {
+      out[i] = static_cast<int>(ReadUint16(values + 2 * i));
+    }
+  }
+}
+
+//}
+
+}  // namespace
+
+/* QuantizeRanges() //{ */
+
+void ueds_connector::QuantizeRanges(std::span<const double> distance, double resolution, std::span<uint16_t> ranges) {
+
+  const auto size = std::min(distance.size(), ranges.size());
+
+  for (size_t i = 0; i < size; i++) {
+    const double steps = distance[i] / resolution;
+
+    // a beam without a return (NaN or infinite) gets the largest range
+    if (std::isnan(steps)) {
+      ranges[i] = UINT16_MAX;
+      continue;
+    }
+
+    ranges[i] = static_cast<uint16_t>(std::clamp(std::nearbyint(steps), 0.0, static_cast<double>(UINT16_MAX)));
+  }
+}
+
+//}
+
+/* DequantizeRanges() //{ */
+
+void ueds_connector::DequantizeRanges(std::span<const std::byte> ranges, double resolution, std::span<double> distance) {
+  Dequantize(ranges.data(), std::min(ranges.size() / sizeof(uint16_t), distance.size()), resolution, distance.data());
+}
+
+//}
+
+/* WidenLidarValues() //{ */
+
+void ueds_connector::WidenLidarValues(std::span<const std::byte> values, size_t value_size, std::span<int> out) {
+
+  if (value_size == 1) {
+    Widen<1>(values.data(), std::min(values.size(), out.size()), out.data());
+  } else if (value_size == 2) {
+    Widen<2>(values.data(), std::min(values.size() / 2, out.size()), out.data());
+  }
+}
+
+//}
+
+/* LidarQuantizationBackend() //{ */
+
+const char* ueds_connector::LidarQuantizationBackend() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+//}
@@ -0,0 +1,262 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/lidar_transform.h>
+
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using ueds_connector::Coordinates;
+using ueds_connector::LidarCloud;
+using ueds_connector::LidarConfig;
+using ueds_connector::LidarTransform;
+using ueds_connector::Rotation;
+
+namespace
+{
+
+/* RotationMatrix() //{ */
+
+// Unreal FRotationMatrix, columns are the rotated X, Y and Z axes
+std::array<double, 9> RotationMatrix(const Rotation& rotation) {
+
+  constexpr double deg_to_rad = std::numbers::pi / 180.0;
+
+  const double sp = std::sin(rotation.pitch * deg_to_rad);
+  const double cp = std::cos(rotation.pitch * deg_to_rad);
+  const double sy = std::sin(rotation.yaw * deg_to_rad);
+  const double cy = std::cos(rotation.yaw * deg_to_rad);
+  const double sr = std::sin(rotation.roll * deg_to_rad);
+  const double cr = std::cos(rotation.roll * deg_to_rad);
+
+  // clang-format off
+  return {cp * cy, sr * sp * cy - cr * sy, -(cr * sp * cy + sr * sy),
+          cp * sy, sr * sp * sy + cr * cy, cy * sr - cr * sp * sy,
+          sp,      -sr * cp,               cr * cp};
+  // clang-format on
+}
+
+//}
+
+/* TransformCloud() //{ */
+
+template <typename T>
+size_t TransformCloud(const LidarCloud& cloud, const LidarTransform& transform, double max_range, std::vector<T>& xyz) {
+
+  const size_t size = cloud.size();
+  xyz.resize(3 * size);
+
+  const double* distance = cloud.distance.data();
+  const double* dir_x    = cloud.dir_x.data();
+  const double* dir_y    = cloud.dir_y.data();
+  const double* dir_z    = cloud.dir_z.data();
+  T*            out      = xyz.data();
+
+  const auto& r = transform.rotation;
+  const auto& t = transform.translation;
+
+  size_t i     = 0;
+  size_t valid = 0;
+
+#if defined(__AVX2__)
+
+#if defined(__FMA__)
+#define MUL_ADD(a, b, c) _mm256_fmadd_pd(a, b, c)
+#else
+#define MUL_ADD(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+#endif
+
+  const __m256d r00 = _mm256_set1_pd(r[0]), r01 = _mm256_set1_pd(r[1]), r02 = _mm256_set1_pd(r[2]);
+  const __m256d r10 = _mm256_set1_pd(r[3]), r11 = _mm256_set1_pd(r[4]), r12 = _mm256_set1_pd(r[5]);
+  const __m256d r20 = _mm256_set1_pd(r[6]), r21 = _mm256_set1_pd(r[7]), r22 = _mm256_set1_pd(r[8]);
+  const __m256d tx = _mm256_set1_pd(t.x), ty = _mm256_set1_pd(t.y), tz = _mm256_set1_pd(t.z);
+  const __m256d zero  = _mm256_setzero_pd();
+  const __m256d range = _mm256_set1_pd(max_range);
+  const __m256d nan   = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  alignas(32) double px[4], py[4], pz[4];
+
+  for (; i + 4 <= size; i += 4) {
+
+    const __m256d d  = _mm256_loadu_pd(distance + i);
+    const __m256d sx = _mm256_mul_pd(d, _mm256_loadu_pd(dir_x + i));
+    const __m256d sy = _mm256_mul_pd(d, _mm256_loadu_pd(dir_y + i));
+    const __m256d sz = _mm256_mul_pd(d, _mm256_loadu_pd(dir_z + i));
+
+    const __m256d valid_mask = _mm256_and_pd(_mm256_cmp_pd(d, zero, _CMP_GT_OQ), _mm256_cmp_pd(d, range, _CMP_LT_OQ));
+    valid += std::popcount(static_cast<unsigned>(_mm256_movemask_pd(valid_mask)));
+
+    _mm256_store_pd(px, _mm256_blendv_pd(nan, MUL_ADD(r00, sx, MUL_ADD(r01, sy, MUL_ADD(r02, sz, tx))), valid_mask));
+    _mm256_store_pd(py, _mm256_blendv_pd(nan, MUL_ADD(r10, sx, MUL_ADD(r11, sy, MUL_ADD(r12, sz, ty))), valid_mask));
+    _mm256_store_pd(pz, _mm256_blendv_pd(nan, MUL_ADD(r20, sx, MUL_ADD(r21, sy, MUL_ADD(r22, sz, tz))), valid_mask));
+
+    for (size_t k = 0; k < 4; k++) {
+      out[3 * (i + k)]     = static_cast<T>(px[k]);
+      out[3 * (i + k) + 1] = static_cast<T>(py[k]);
+      out[3 * (i + k) + 2] = static_cast<T>(pz[k]);
+    }
+  }
+
+#undef MUL_ADD
+
+#elif defined(__SSE2__)
+
+  const __m128d r00 = _mm_set1_pd(r[0]), r01 = _mm_set1_pd(r[1]), r02 = _mm_set1_pd(r[2]);
+  const __m128d r10 = _mm_set1_pd(r[3]), r11 = _mm_set1_pd(r[4]), r12 = _mm_set1_pd(r[5]);
+  const __m128d r20 = _mm_set1_pd(r[6]), r21 = _mm_set1_pd(r[7]), r22 = _mm_set1_pd(r[8]);
+  const __m128d tx = _mm_set1_pd(t.x), ty = _mm_set1_pd(t.y), tz = _mm_set1_pd(t.z);
+  const __m128d zero  = _mm_setzero_pd();
+  const __m128d range = _mm_set1_pd(max_range);
+  const __m128d nan   = _mm_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  alignas(16) double px[2], py[2], pz[2];
+
+  for (; i + 2 <= size; i += 2) {
+
+    const __m128d d  = _mm_loadu_pd(distance + i);
+    const __m128d sx = _mm_mul_pd(d, _mm_loadu_pd(dir_x + i));
+    const __m128d sy = _mm_mul_pd(d, _mm_loadu_pd(dir_y + i));
+    const __m128d sz = _mm_mul_pd(d, _mm_loadu_pd(dir_z + i));
+
+    const __m128d valid_mask = _mm_and_pd(_mm_cmpgt_pd(d, zero), _mm_cmplt_pd(d, range));
+    valid += std::popcount(static_cast<unsigned>(_mm_movemask_pd(valid_mask)));
+
+    const __m128d x = _mm_add_pd(_mm_add_pd(_mm_mul_pd(r00, sx), _mm_mul_pd(r01, sy)), _mm_add_pd(_mm_mul_pd(r02, sz), tx));
+    const __m128d y = _mm_add_pd(_mm_add_pd(_mm_mul_pd(r10, sx), _mm_mul_pd(r11, sy)), _mm_add_pd(_mm_mul_pd(r12, sz), ty));
+    const __m128d z = _mm_add_pd(_mm_add_pd(_mm_mul_pd(r20, sx), _mm_mul_pd(r21, sy)), _mm_add_pd(_mm_mul_pd(r22, sz), tz));
+
+    _mm_store_pd(px, _mm_or_pd(_mm_and_pd(valid_mask, x), _mm_andnot_pd(valid_mask, nan)));
+    _mm_store_pd(py, _mm_or_pd(_mm_and_pd(valid_mask, y), _mm_andnot_pd(valid_mask, nan)));
+    _mm_store_pd(pz, _mm_or_pd(_mm_and_pd(valid_mask, z), _mm_andnot_pd(valid_mask, nan)));
+
+    for (size_t k = 0; k < 2; k++) {
+      out[3 * (i + k)]     = static_cast<T>(px[k]);
+      out[3 * (i + k) + 1] = static_cast<T>(py[k]);
+      out[3 * (i + k) + 2] = static_cast<T>(pz[k]);
+    }
+  }
+
+#endif
+
+  // scalar fallback and the tail of the vectorized loops
+  for (; i < size; i++) {
+
+    const double d = distance[i];
+
+    if (!(d > 0.0 && d < max_range)) {
+      out[3 * i] = out[3 * i + 1] = out[3 * i + 2] = std::numeric_limits<T>::quiet_NaN();
+      continue;
+    }
+
+    const double sx = d * dir_x[i];
+    const double sy = d * dir_y[i];
+    const double sz = d * dir_z[i];
+
+    out[3 * i]     = static_cast<T>(r[0] * sx + r[1] * sy + r[2] * sz + t.x);
+    out[3 * i + 1] = static_cast<T>(r[3] * sx + r[4] * sy + r[5] * sz + t.y);
+    out[3 * i + 2] = static_cast<T>(r[6] * sx + r[7] * sy + r[8] * sz + t.z);
+    valid++;
+  }
+
+  return valid;
+}
+
+//}
+
+}  // namespace
+
+/* LidarTransform::Identity() //{ */
+
+LidarTransform LidarTransform::Identity() {
+  return LidarTransform{};
+}
+
+//}
+
+/* LidarTransform::FromPose() //{ */
+
+LidarTransform LidarTransform::FromPose(const Coordinates& translation, const Rotation& rotation) {
+
+  LidarTransform transform;
+  transform.rotation    = RotationMatrix(rotation);
+  transform.translation = translation;
+
+  return transform;
+}
+
+//}
+
+/* LidarTransform::SensorToBody() //{ */
+
+LidarTransform LidarTransform::SensorToBody(const LidarConfig& config) {
+  return FromPose(config.offset, config.orientation);
+}
+
+//}
+
+/* LidarTransform::SensorToWorld() //{ */
+
+LidarTransform LidarTransform::SensorToWorld(const Coordinates& start, const LidarConfig& config, const Rotation& drone_rotation) {
+
+  auto transform        = FromPose(Coordinates{0, 0, 0}, drone_rotation) * FromPose(Coordinates{0, 0, 0}, config.orientation);
+  transform.translation = start;
+
+  return transform;
+}
+
+//}
+
+/* LidarTransform::operator*() //{ */
+
+LidarTransform LidarTransform::operator*(const LidarTransform& other) const {
+
+  LidarTransform result;
+
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 3; col++) {
+      result.rotation[3 * row + col] =
+          rotation[3 * row] * other.rotation[col] + rotation[3 * row + 1] * other.rotation[3 + col] + rotation[3 * row + 2] * other.rotation[6 + col];
+    }
+  }
+
+  const auto& o      = other.translation;
+  result.translation = Coordinates{rotation[0] * o.x + rotation[1] * o.y + rotation[2] * o.z + translation.x,
+                                   rotation[3] * o.x + rotation[4] * o.y + rotation[5] * o.z + translation.y,
+                                   rotation[6] * o.x + rotation[7] * o.y + rotation[8] * o.z + translation.z};
+
+  return result;
+}
+
+//}
+
+/* LidarCloudToPoints() //{ */
+
+size_t ueds_connector::LidarCloudToPoints(const LidarCloud& cloud, const LidarTransform& transform, double max_range, std::vector<float>& xyz) {
+  return TransformCloud(cloud, transform, max_range, xyz);
+}
+
+size_t ueds_connector::LidarCloudToPoints(const LidarCloud& cloud, const LidarTransform& transform, double max_range, std::vector<double>& xyz) {
+  return TransformCloud(cloud, transform, max_range, xyz);
+}
+
+//}
+
+/* LidarSimdBackend() //{ */
+
+const char* ueds_connector::LidarSimdBackend() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+//}
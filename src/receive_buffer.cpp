@@ -0,0 +1,73 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/receive_buffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+using ueds_connector::ReceiveBuffer;
+
+/* PrepareWrite() //{ */
+
+std::span<std::byte> ReceiveBuffer::PrepareWrite(size_t min_size) {
+
+  if (storage_.size() - write_position_ >= min_size) {
+    return {storage_.data() + write_position_, storage_.size() - write_position_};
+  }
+
+  const auto readable = ReadableSize();
+
+  // move the unread data to the front before considering a reallocation
+  if (read_position_ > 0) {
+    if (readable > 0) {
+      std::memmove(storage_.data(), storage_.data() + read_position_, readable);
+    }
+    read_position_  = 0;
+    write_position_ = readable;
+  }
+
+  if (storage_.size() - write_position_ < min_size) {
+    std::vector<std::byte> grown(std::max(storage_.size() * 2, readable + min_size));
+    if (readable > 0) {
+      std::memcpy(grown.data(), storage_.data(), readable);
+    }
+    storage_.swap(grown);
+    allocation_count_++;
+  }
+
+  return {storage_.data() + write_position_, storage_.size() - write_position_};
+}
+
+//}
+
+/* Commit() //{ */
+
+void ReceiveBuffer::Commit(size_t size) {
+  write_position_ = std::min(write_position_ + size, storage_.size());
+}
+
+//}
+
+/* Consume() //{ */
+
+void ReceiveBuffer::Consume(size_t size) {
+
+  read_position_ = std::min(read_position_ + size, write_position_);
+
+  if (read_position_ == write_position_) {
+    read_position_  = 0;
+    write_position_ = 0;
+  }
+}
+
+//}
+
+/* Clear() //{ */
+
+void ReceiveBuffer::Clear() {
+  read_position_  = 0;
+  write_position_ = 0;
+}
+
+//}
@@ -0,0 +1,361 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/request_metrics.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <iostream>
+
+using ueds_connector::LatencyHistogram;
+using ueds_connector::MessageMetrics;
+using ueds_connector::RequestMetrics;
+using ueds_connector::RequestStage;
+
+namespace
+{
+
+constexpr size_t STAGE_COUNT = static_cast<size_t>(RequestStage::COUNT);
+
+/* BucketOf() //{ */
+
+inline size_t BucketOf(uint64_t nanoseconds) {
+  return std::min<size_t>(static_cast<size_t>(std::bit_width(nanoseconds)), METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+//}
+
+/* ToMicroseconds() //{ */
+
+inline double ToMicroseconds(std::chrono::nanoseconds duration) {
+  return static_cast<double>(duration.count()) / 1000.0;
+}
+
+//}
+
+}  // namespace
+
+/* RequestStageName() //{ */
+
+const char* ueds_connector::RequestStageName(RequestStage stage) {
+
+  switch (stage) {
+    case RequestStage::SERIALIZE:
+      return "serialize";
+    case RequestStage::SEND:
+      return "send";
+    case RequestStage::WAIT:
+      return "wait";
+    case RequestStage::RECEIVE:
+      return "receive";
+    case RequestStage::DESERIALIZE:
+      return "deserialize";
+    default:
+      return "unknown";
+  }
+}
+
+//}
+
+/* Percentile() //{ */
+
+std::chrono::nanoseconds LatencyHistogram::Percentile(double fraction) const {
+
+  if (count == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count) + 0.5));
+  uint64_t   seen = 0;
+
+  for (size_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+
+    if (seen >= rank) {
+      // the last bucket is open, its bound is the largest duration seen
+      const uint64_t bound = i + 1 < buckets.size() ? (uint64_t{1} << i) : max_ns;
+      return std::chrono::nanoseconds(std::min(bound, max_ns));
+    }
+  }
+
+  return std::chrono::nanoseconds(max_ns);
+}
+
+//}
+
+/* ~RequestMetrics() //{ */
+
+RequestMetrics::~RequestMetrics() {
+  StopDump();
+}
+
+//}
+
+/* SetEnabled() //{ */
+
+void RequestMetrics::SetEnabled(bool enabled) {
+
+  std::scoped_lock lock(slots_mutex_);
+
+  if (enabled && !slots_) {
+    slots_ = std::make_unique<Slot_[]>(METRICS_MAX_MESSAGE_TYPES);
+  }
+
+  // publishes the table to the requests checking the flag
+  enabled_.store(enabled, std::memory_order_release);
+}
+
+//}
+
+/* FindSlot_() //{ */
+
+RequestMetrics::Slot_* RequestMetrics::FindSlot_(unsigned short type) {
+
+  const uint32_t key   = static_cast<uint32_t>(type) + 1;
+  const size_t   start = type % METRICS_MAX_MESSAGE_TYPES;
+
+  // open addressing, a slot once claimed keeps its type, so the probe stops at the first free one
+  for (size_t i = 0; i < METRICS_MAX_MESSAGE_TYPES; i++) {
+
+    auto&    slot     = slots_[(start + i) % METRICS_MAX_MESSAGE_TYPES];
+    uint32_t expected = slot.key.load(std::memory_order_acquire);
+
+    if (expected == key) {
+      return &slot;
+    }
+
+    if (expected == 0 && (slot.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel) || expected == key)) {
+      return &slot;
+    }
+  }
+
+  return nullptr;
+}
+
+//}
+
+/* RecordStage() //{ */
+
+void RequestMetrics::RecordStage(unsigned short type, RequestStage stage, std::chrono::nanoseconds duration) {
+
+  if (!IsEnabled()) {
+    return;
+  }
+
+  auto* slot = FindSlot_(type);
+  if (slot == nullptr) {
+    return;
+  }
+
+  const auto nanoseconds = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+  auto&      histogram   = slot->stages[static_cast<size_t>(stage)];
+
+  histogram.buckets[BucketOf(nanoseconds)].Add(1);
+  histogram.count.Add(1);
+  histogram.total_ns.Add(nanoseconds);
+
+  uint64_t max = histogram.max_ns.load(std::memory_order_relaxed);
+  while (nanoseconds > max && !histogram.max_ns.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+//}
+
+/* RecordRequest() //{ */
+
+void RequestMetrics::RecordRequest(unsigned short type, uint64_t bytes) {
+
+  if (auto* slot = IsEnabled() ? FindSlot_(type) : nullptr) {
+    slot->requests.Add(1);
+    slot->request_bytes.Add(bytes);
+  }
+}
+
+//}
+
+/* RecordResponse() //{ */
+
+void RequestMetrics::RecordResponse(unsigned short type, uint64_t bytes) {
+
+  if (auto* slot = IsEnabled() ? FindSlot_(type) : nullptr) {
+    slot->responses.Add(1);
+    slot->response_bytes.Add(bytes);
+  }
+}
+
+//}
+
+/* RecordFailure() //{ */
+
+void RequestMetrics::RecordFailure(unsigned short type, bool timeout) {
+
+  if (auto* slot = IsEnabled() ? FindSlot_(type) : nullptr) {
+    (timeout ? slot->timeouts : slot->errors).Add(1);
+  }
+}
+
+//}
+
+/* Snapshot() //{ */
+
+std::vector<MessageMetrics> RequestMetrics::Snapshot() const {
+
+  std::vector<MessageMetrics> snapshot;
+
+  std::scoped_lock lock(slots_mutex_);
+
+  if (!slots_) {
+    return snapshot;
+  }
+
+  for (size_t i = 0; i < METRICS_MAX_MESSAGE_TYPES; i++) {
+
+    const auto& slot = slots_[i];
+    const auto  key  = slot.key.load(std::memory_order_acquire);
+
+    if (key == 0) {
+      continue;
+    }
+
+    MessageMetrics metrics;
+    metrics.type           = static_cast<unsigned short>(key - 1);
+    metrics.requests       = slot.requests.Load();
+    metrics.request_bytes  = slot.request_bytes.Load();
+    metrics.responses      = slot.responses.Load();
+    metrics.response_bytes = slot.response_bytes.Load();
+    metrics.errors         = slot.errors.Load();
+    metrics.timeouts       = slot.timeouts.Load();
+
+    for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+
+      const auto& source      = slot.stages[stage];
+      auto&       destination = metrics.stages[stage];
+
+      for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++) {
+        destination.buckets[bucket] = source.buckets[bucket].Load();
+      }
+
+      destination.count    = source.count.Load();
+      destination.total_ns = source.total_ns.Load();
+      destination.max_ns   = source.max_ns.load(std::memory_order_relaxed);
+    }
+
+    snapshot.push_back(metrics);
+  }
+
+  std::sort(snapshot.begin(), snapshot.end(), [](const MessageMetrics& a, const MessageMetrics& b) { return a.type < b.type; });
+
+  return snapshot;
+}
+
+//}
+
+/* Reset() //{ */
+
+void RequestMetrics::Reset() {
+
+  std::scoped_lock lock(slots_mutex_);
+
+  if (!slots_) {
+    return;
+  }
+
+  // the slots keep their types, the lock-free probing relies on it
+  for (size_t i = 0; i < METRICS_MAX_MESSAGE_TYPES; i++) {
+
+    auto& slot = slots_[i];
+
+    for (auto* counter : {&slot.requests, &slot.request_bytes, &slot.responses, &slot.response_bytes, &slot.errors, &slot.timeouts}) {
+      counter->value.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& histogram : slot.stages) {
+      for (auto& bucket : histogram.buckets) {
+        bucket.value.store(0, std::memory_order_relaxed);
+      }
+      histogram.count.value.store(0, std::memory_order_relaxed);
+      histogram.total_ns.value.store(0, std::memory_order_relaxed);
+      histogram.max_ns.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+//}
+
+/* StartDump() //{ */
+
+void RequestMetrics::StartDump(std::chrono::milliseconds interval, std::function<void(const std::vector<MessageMetrics>&)> sink) {
+
+  StopDump();
+
+  if (!sink) {
+    sink = [](const std::vector<MessageMetrics>& metrics) { PrintMetrics(std::cerr, metrics); };
+  }
+
+  {
+    std::scoped_lock lock(dump_mutex_);
+    dumping_ = true;
+  }
+
+  dump_thread_ = std::thread([this, interval, sink = std::move(sink)] {
+    std::unique_lock lock(dump_mutex_);
+
+    while (!dump_condition_.wait_for(lock, interval, [this] { return !dumping_; })) {
+      lock.unlock();
+      sink(Snapshot());
+      lock.lock();
+    }
+  });
+}
+
+//}
+
+/* StopDump() //{ */
+
+void RequestMetrics::StopDump() {
+
+  {
+    std::scoped_lock lock(dump_mutex_);
+    dumping_ = false;
+  }
+
+  dump_condition_.notify_all();
+
+  if (dump_thread_.joinable()) {
+    dump_thread_.join();
+  }
+}
+
+//}
+
+/* PrintMetrics() //{ */
+
+void ueds_connector::PrintMetrics(std::ostream& out, const std::vector<MessageMetrics>& metrics) {
+
+  for (const auto& message : metrics) {
+
+    out << "METRICS type " << message.type << ": " << message.requests << " requests (" << message.request_bytes << " B), " << message.responses
+        << " responses (" << message.response_bytes << " B), " << message.errors << " errors, " << message.timeouts << " timeouts";
+
+    char line[128];
+
+    for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+
+      const auto& histogram = message.stages[stage];
+
+      if (histogram.count == 0) {
+        continue;
+      }
+
+      std::snprintf(line, sizeof(line), ", %s p50 %.1f p99 %.1f max %.1f us", RequestStageName(static_cast<RequestStage>(stage)),
+                    ToMicroseconds(histogram.Percentile(0.5)), ToMicroseconds(histogram.Percentile(0.99)),
+                    ToMicroseconds(std::chrono::nanoseconds(histogram.max_ns)));
+      out << line;
+    }
+
+    out << std::endl;
+  }
+}
+
+//}
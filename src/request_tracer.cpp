@@ -0,0 +1,290 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/request_tracer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+using ueds_connector::RequestStatus;
+using ueds_connector::RequestTracer;
+using ueds_connector::TraceKind;
+
+namespace
+{
+
+std::atomic<uint64_t> next_tracer_id{1};
+
+// the buffer of the thread for the tracer it used last, a thread switching between tracers takes the slow path on every switch
+struct ThreadBufferCache
+{
+  uint64_t tracer_id = 0;
+  void*    buffer    = nullptr;
+};
+
+thread_local ThreadBufferCache thread_buffer_cache;
+
+/* PackEvent() //{ */
+
+inline uint64_t PackEvent(char phase, TraceKind kind, uint16_t port, unsigned short type, RequestStatus status) {
+  return static_cast<uint64_t>(type) | (static_cast<uint64_t>(port) << 16) | (static_cast<uint64_t>(kind) << 32) |
+         (static_cast<uint64_t>(static_cast<uint8_t>(phase)) << 40) | (static_cast<uint64_t>(status) << 48);
+}
+
+//}
+
+/* TraceKindName() //{ */
+
+const char* TraceKindName(TraceKind kind) {
+
+  switch (kind) {
+    case TraceKind::REQUEST:
+      return "request";
+    case TraceKind::SUBMIT:
+      return "submit";
+    case TraceKind::COLLECT:
+      return "collect";
+    default:
+      return "unknown";
+  }
+}
+
+//}
+
+/* WriteJsonString() //{ */
+
+void WriteJsonString(std::ostream& out, const std::string& text) {
+
+  out << '"';
+
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+      out << escaped;
+    } else {
+      out << c;
+    }
+  }
+
+  out << '"';
+}
+
+//}
+
+}  // namespace
+
+/* RequestTracer() //{ */
+
+RequestTracer::RequestTracer(size_t thread_buffer_events)
+    : id_(next_tracer_id.fetch_add(1, std::memory_order_relaxed)), thread_buffer_events_(std::max<size_t>(thread_buffer_events, 2)) {
+}
+
+RequestTracer::~RequestTracer() = default;
+
+//}
+
+/* RegisterConnection() //{ */
+
+void RequestTracer::RegisterConnection(uint16_t port, const std::string& label) {
+  std::scoped_lock lock(buffers_mutex_);
+  connections_[port] = label;
+}
+
+//}
+
+/* getThreadBuffer_() //{ */
+
+RequestTracer::ThreadBuffer_* RequestTracer::GetThreadBuffer_() {
+
+  auto& cache = thread_buffer_cache;
+
+  if (cache.tracer_id == id_) {
+    return static_cast<ThreadBuffer_*>(cache.buffer);
+  }
+
+  std::scoped_lock lock(buffers_mutex_);
+
+  auto& buffer = thread_buffers_[std::this_thread::get_id()];
+
+  if (buffer == nullptr) {
+    buffers_.push_back(std::make_unique<ThreadBuffer_>(thread_buffer_events_, static_cast<uint32_t>(buffers_.size() + 1)));
+    buffer = buffers_.back().get();
+  }
+
+  cache.tracer_id = id_;
+  cache.buffer    = buffer;
+
+  return buffer;
+}
+
+//}
+
+/* Begin() //{ */
+
+void RequestTracer::Begin(TraceKind kind, uint16_t port, unsigned short type, uint32_t sequence) {
+  if (IsEnabled()) {
+    Record_('B', kind, port, type, RequestStatus::OK, sequence);
+  }
+}
+
+//}
+
+/* End() //{ */
+
+void RequestTracer::End(TraceKind kind, uint16_t port, unsigned short type, RequestStatus status, uint32_t sequence) {
+  // also when disabled meanwhile, the span would stay open otherwise
+  Record_('E', kind, port, type, status, sequence);
+}
+
+//}
+
+/* record_() //{ */
+
+void RequestTracer::Record_(char phase, TraceKind kind, uint16_t port, unsigned short type, RequestStatus status, uint32_t sequence) {
+
+  auto* buffer = GetThreadBuffer_();
+
+  // the only writer of the buffer, the readers check the head to skip the event while it is written
+  const auto index     = buffer->head.load(std::memory_order_relaxed);
+  auto&      event     = buffer->events[index % buffer->capacity];
+  const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+
+  event.timestamp.store(static_cast<uint64_t>(timestamp), std::memory_order_relaxed);
+  event.data.store(PackEvent(phase, kind, port, type, status), std::memory_order_relaxed);
+  event.sequence.store(sequence, std::memory_order_relaxed);
+
+  buffer->head.store(index + 1, std::memory_order_release);
+}
+
+//}
+
+/* WriteChromeTrace() //{ */
+
+void RequestTracer::WriteChromeTrace(std::ostream& out) const {
+
+  std::scoped_lock lock(buffers_mutex_);
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  bool          first = true;
+  std::set<int> ports;
+  const auto    separator = [&out, &first] {
+    out << (first ? "\n" : ",\n");
+    first = false;
+  };
+
+  for (const auto& buffer : buffers_) {
+
+    const auto head = buffer->head.load(std::memory_order_acquire);
+    const auto from = std::max(buffer->start.load(std::memory_order_relaxed), head > buffer->capacity ? head - buffer->capacity : 0);
+
+    struct Copy
+    {
+      uint64_t timestamp;
+      uint64_t data;
+      uint32_t sequence;
+    };
+
+    std::vector<Copy> events;
+    events.reserve(head - from);
+
+    for (auto i = from; i < head; i++) {
+      const auto& event = buffer->events[i % buffer->capacity];
+      events.push_back({event.timestamp.load(std::memory_order_relaxed), event.data.load(std::memory_order_relaxed),
+                        event.sequence.load(std::memory_order_relaxed)});
+    }
+
+    // the writer may have overwritten the oldest ones during the copy, including the slot of the event it writes now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto written     = buffer->head.load(std::memory_order_relaxed);
+    const auto overwritten = written >= buffer->capacity ? written - buffer->capacity + 1 : 0;
+    const auto skipped     = static_cast<size_t>(std::min<uint64_t>(overwritten > from ? overwritten - from : 0, events.size()));
+
+    // an end whose begin was overwritten would close a slice of another request
+    std::map<uint16_t, int> depth;
+
+    for (size_t i = skipped; i < events.size(); i++) {
+
+      const auto& event  = events[i];
+      const auto  type   = static_cast<unsigned short>(event.data & 0xffff);
+      const auto  port   = static_cast<uint16_t>((event.data >> 16) & 0xffff);
+      const auto  kind   = static_cast<TraceKind>((event.data >> 32) & 0xff);
+      const auto  phase  = static_cast<char>((event.data >> 40) & 0xff);
+      const auto  status = static_cast<RequestStatus>((event.data >> 48) & 0xff);
+
+      if (phase == 'E' && depth[port]-- <= 0) {
+        depth[port] = 0;
+        continue;
+      }
+
+      if (phase == 'B') {
+        depth[port]++;
+      }
+
+      ports.insert(port);
+      separator();
+
+      char line[256];
+      std::snprintf(line, sizeof(line), R"({"name":"%s %u","cat":"%s","ph":"%c","ts":%.3f,"pid":%u,"tid":%u,"args":{)", TraceKindName(kind),
+                    static_cast<unsigned>(type), TraceKindName(kind), phase, static_cast<double>(event.timestamp) / 1000.0,
+                    static_cast<unsigned>(port), buffer->tid);
+      out << line;
+
+      if (phase == 'B') {
+        out << "\"type\":" << type;
+      } else {
+        out << "\"status\":\"" << RequestStatusName(status) << "\"";
+      }
+
+      if (event.sequence != 0) {
+        out << ",\"sequence\":" << event.sequence;
+      }
+
+      out << "}}";
+    }
+  }
+
+  for (const auto port : ports) {
+
+    const auto connection = connections_.find(static_cast<uint16_t>(port));
+
+    separator();
+    out << R"({"name":"process_name","ph":"M","pid":)" << port << R"(,"args":{"name":)";
+    WriteJsonString(out, connection != connections_.end() ? connection->second : "port " + std::to_string(port));
+    out << "}}";
+  }
+
+  out << "\n]}" << std::endl;
+}
+
+bool RequestTracer::WriteChromeTrace(const std::string& path) const {
+
+  std::ofstream file(path);
+
+  if (!file) {
+    return false;
+  }
+
+  WriteChromeTrace(file);
+  return static_cast<bool>(file);
+}
+
+//}
+
+/* Clear() //{ */
+
+void RequestTracer::Clear() {
+
+  std::scoped_lock lock(buffers_mutex_);
+
+  for (const auto& buffer : buffers_) {
+    buffer->start.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+//}
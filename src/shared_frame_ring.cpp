@@ -0,0 +1,283 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/shared_frame_ring.h>
+
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using ueds_connector::SharedFrameRing;
+
+namespace
+{
+
+constexpr uint32_t RING_MAGIC   = 0x46465246;  // "FRFF"
+constexpr uint32_t RING_VERSION = 1;
+// the header and every slot start on their own cache line
+constexpr size_t RING_ALIGNMENT = 64;
+
+struct alignas(RING_ALIGNMENT) RingHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t slot_size;
+};
+
+struct alignas(RING_ALIGNMENT) SlotHeader
+{
+  std::atomic<uint64_t> sequence;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the slot sequence is shared between processes");
+
+size_t Align(size_t size) {
+  return (size + RING_ALIGNMENT - 1) / RING_ALIGNMENT * RING_ALIGNMENT;
+}
+
+size_t RingSize(uint32_t slot_count, uint32_t slot_size) {
+  return sizeof(RingHeader) + slot_count * (sizeof(SlotHeader) + static_cast<size_t>(slot_size));
+}
+
+}  // namespace
+
+/* ~SharedFrameRing() //{ */
+
+SharedFrameRing::~SharedFrameRing() {
+  Close();
+}
+
+//}
+
+/* IsValidName() //{ */
+
+bool SharedFrameRing::IsValidName(const std::string& name) {
+  return name.size() > 1 && name.size() < 255 && name.front() == '/' && name.find('/', 1) == std::string::npos;
+}
+
+//}
+
+/* Create() //{ */
+
+bool SharedFrameRing::Create(const std::string& name, uint32_t slot_count, uint32_t slot_size) {
+
+  Close();
+
+#ifdef _WIN32
+  return false;
+#else
+
+  slot_size = static_cast<uint32_t>(Align(slot_size));
+
+  if (!IsValidName(name) || slot_count == 0 || slot_size == 0) {
+    return false;
+  }
+
+  // a region left over by a crashed producer of the same name is replaced
+  shm_unlink(name.c_str());
+
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return false;
+  }
+
+  const auto size = RingSize(slot_count, slot_size);
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0 || !Map_(fd, size, true)) {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  ::close(fd);
+
+  // a fresh region is zero filled, all slots start at the even sequence 0
+  new (base_) RingHeader{RING_MAGIC, RING_VERSION, slot_count, slot_size};
+
+  name_       = name;
+  owner_      = true;
+  slot_count_ = slot_count;
+  slot_size_  = slot_size;
+  next_slot_  = 0;
+
+  for (uint32_t i = 0; i < slot_count_; i++) {
+    new (base_ + sizeof(RingHeader) + i * sizeof(SlotHeader)) SlotHeader{0};
+  }
+
+  return true;
+#endif
+}
+
+//}
+
+/* Open() //{ */
+
+bool SharedFrameRing::Open(const std::string& name) {
+
+  Close();
+
+#ifdef _WIN32
+  return false;
+#else
+
+  if (!IsValidName(name)) {
+    return false;
+  }
+
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat status
+  {
+  };
+
+  const auto mapped = fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(RingHeader) &&
+                      Map_(fd, static_cast<size_t>(status.st_size), false);
+  ::close(fd);
+
+  if (!mapped) {
+    return false;
+  }
+
+  RingHeader header{};
+  std::memcpy(&header, base_, sizeof(header));
+
+  // the slots have to lie within the mapping, the producer of another version may lay them out differently
+  if (header.magic != RING_MAGIC || header.version != RING_VERSION || header.slot_count == 0 || header.slot_size % RING_ALIGNMENT != 0 ||
+      RingSize(header.slot_count, header.slot_size) > mapped_) {
+    Close();
+    return false;
+  }
+
+  name_       = name;
+  owner_      = false;
+  slot_count_ = header.slot_count;
+  slot_size_  = header.slot_size;
+
+  return true;
+#endif
+}
+
+//}
+
+/* Close() //{ */
+
+void SharedFrameRing::Close() {
+
+#ifndef _WIN32
+  if (base_ != nullptr) {
+    munmap(base_, mapped_);
+  }
+
+  if (owner_) {
+    shm_unlink(name_.c_str());
+  }
+#endif
+
+  base_       = nullptr;
+  mapped_     = 0;
+  owner_      = false;
+  slot_count_ = 0;
+  slot_size_  = 0;
+  name_.clear();
+}
+
+//}
+
+/* BeginWrite() //{ */
+
+std::span<unsigned char> SharedFrameRing::BeginWrite(uint32_t size, uint32_t& slot) {
+
+  if (!owner_ || base_ == nullptr || size > slot_size_) {
+    return {};
+  }
+
+  slot       = next_slot_;
+  next_slot_ = (next_slot_ + 1) % slot_count_;
+
+  // odd while the slot is being rewritten, the fence keeps the data stores behind it
+  auto* sequence = SlotSequence_(slot);
+  sequence->store(sequence->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  return {SlotData_(slot), size};
+}
+
+//}
+
+/* CommitWrite() //{ */
+
+uint64_t SharedFrameRing::CommitWrite(uint32_t slot) {
+
+  auto*      sequence  = SlotSequence_(slot);
+  const auto published = sequence->load(std::memory_order_relaxed) + 1;
+
+  sequence->store(published, std::memory_order_release);
+
+  return published;
+}
+
+//}
+
+/* View() //{ */
+
+bool SharedFrameRing::View(const SharedFrameDescriptor& descriptor, SharedFrameView& view) const {
+
+  if (base_ == nullptr || descriptor.slot >= slot_count_ || descriptor.size > slot_size_ || descriptor.split > descriptor.size) {
+    return false;
+  }
+
+  view.data_          = SlotData_(descriptor.slot);
+  view.slot_sequence_ = SlotSequence_(descriptor.slot);
+  view.descriptor_    = descriptor;
+
+  return view.IsValid();
+}
+
+//}
+
+/* SlotSequence_() //{ */
+
+std::atomic<uint64_t>* SharedFrameRing::SlotSequence_(uint32_t slot) const {
+  return &reinterpret_cast<SlotHeader*>(base_ + sizeof(RingHeader))[slot].sequence;
+}
+
+//}
+
+/* SlotData_() //{ */
+
+unsigned char* SharedFrameRing::SlotData_(uint32_t slot) const {
+  return base_ + sizeof(RingHeader) + slot_count_ * sizeof(SlotHeader) + static_cast<size_t>(slot) * slot_size_;
+}
+
+//}
+
+/* Map_() //{ */
+
+bool SharedFrameRing::Map_([[maybe_unused]] int fd, [[maybe_unused]] size_t size, [[maybe_unused]] bool writable) {
+
+#ifdef _WIN32
+  return false;
+#else
+  void* address = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    return false;
+  }
+
+  base_   = static_cast<unsigned char*>(address);
+  mapped_ = size;
+
+  return true;
+#endif
+}
+
+//}
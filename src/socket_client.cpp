@@ -3,10 +3,14 @@
 
 #include <flight_forge_connector/socket_client.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 using kissnet::socket_status;
+using ueds_connector::CaptureDirection;
+using ueds_connector::RequestStatus;
 using ueds_connector::SocketClient;
 
 SocketClient::SocketClient() = default;
@@ -23,73 +27,108 @@ SocketClient::SocketClient(const std::string& address, uint16_t port) {
 /* ~SocketClient() //{ */
 
 SocketClient::~SocketClient() {
-  ClearInQueue_();
+  StopBackgroundWork_();
   Disconnect();
 }
 
 //}
 
-/* IsSocketValid_() //{ */
+/* stopBackgroundWork_() //{ */
 
-bool SocketClient::IsSocketValid_() const {
-  return socket_ != nullptr && socket_->is_valid();
-}
+void SocketClient::StopBackgroundWork_() {
 
-//}
+  {
+    std::scoped_lock lock(push_receiver_mutex_);
+    push_receiving_ = false;
+  }
 
-/* IsReadyToSend_() //{ */
+  push_receiver_condition_.notify_all();
 
-bool SocketClient::IsReadyToSend_() const {
-  return InQueueEmpty_();
+  if (push_receiver_.joinable()) {
+    // a push callback destroying its own client cannot join the receiver
+    if (push_receiver_.get_id() == std::this_thread::get_id()) {
+      push_receiver_.detach();
+    } else {
+      push_receiver_.join();
+    }
+  }
+
+  {
+    std::scoped_lock lock(reconnect_mutex_);
+    connection_state_callback_ = nullptr;
+  }
+
+  CancelReconnect_();
+
+  // the queued asynchronous requests still use the socket
+  async_worker_.Stop();
 }
 
 //}
 
-/* PushToInQueue_() //{ */
+/* IsSocketValid_() //{ */
 
-void SocketClient::PushToInQueue_(std::unique_ptr<std::vector<std::byte>> item) {
-  in_queue_.emplace(std::move(item));
+bool SocketClient::IsSocketValid_() const {
+  return socket_ != nullptr && socket_->is_valid();
 }
 
 //}
 
-/* PopFromInQueue_() //{ */
+/* IsReadyToSend_() //{ */
 
-std::unique_ptr<std::vector<std::byte>> SocketClient::PopFromInQueue_() {
+bool SocketClient::IsReadyToSend_() const {
 
-  if (!InQueueEmpty_()) {
-    auto item = std::move(in_queue_.front());
-    in_queue_.pop();
-    return item;
+  // responses are matched by id, the next request does not have to wait for the previous response
+  if (frame_mode_ == FrameMode::SEQUENCED) {
+    return in_flight_.size() < MAX_IN_FLIGHT_REQUESTS;
   }
 
-  return nullptr;
+  return receive_buffer_.Empty();
 }
 
 //}
 
-/*  ClearInQueue_() //{ */
+/* connect() //{ */
 
-void SocketClient::ClearInQueue_() {
+socket_status::values SocketClient::Connect() {
 
-  while (!in_queue_.empty()) {
-    in_queue_.pop();
-  }
-}
+  CancelReconnect_();
 
-//}
+  std::scoped_lock lock(request_mutex_);
+
+  // a connection made by hand is a new session, its framing is negotiated again
+  negotiated_frame_mode_ = FrameMode::SENTINEL;
 
-/* InQueueEmpty_() //{ */
+  const auto status = Connect_();
+  SetConnectionState_(status == socket_status::valid ? ConnectionState::CONNECTED : ConnectionState::DISCONNECTED);
 
-bool SocketClient::InQueueEmpty_() const {
-  return in_queue_.empty();
+  return status;
 }
 
-//}
+socket_status::values SocketClient::Connect_() {
 
-/* connect() //{ */
+  // a fresh connection always starts in the legacy framing, uncompressed
+  frame_mode_      = FrameMode::SENTINEL;
+  compression_     = CompressionOptions{};
+  connection_lost_ = false;
+  receive_buffer_.Clear();
+  ResetSequencing_();
+  OnConnectionReset_();
 
-socket_status::values SocketClient::Connect() {
+  std::unique_lock socket_lock(socket_mutex_);
+
+  // same-host simulator, the connected unix socket is handed to kissnet which only uses it through send/recv/select
+  if (IsUnixSocketAddress(address_)) {
+
+    const int fd = ConnectUnixSocket(UnixSocketPath(address_, port_));
+    if (fd < 0) {
+      socket_.reset();
+      return socket_status::errored;
+    }
+
+    socket_ = std::make_unique<kissnet::tcp_socket>(static_cast<SOCKET>(fd), kissnet::endpoint(LOCALHOST, port_));
+    return socket_status::valid;
+  }
 
   socket_ = std::make_unique<kissnet::tcp_socket>(kissnet::endpoint(address_ + ":" + std::to_string(port_)));
 
@@ -117,11 +156,31 @@ bool SocketClient::ConnectSimple() {
 
 bool SocketClient::Disconnect() {
 
+  CancelReconnect_();
+
+  std::scoped_lock lock(request_mutex_);
+
+  const auto was_connected = Disconnect_();
+  SetConnectionState_(ConnectionState::DISCONNECTED);
+
+  return was_connected;
+}
+
+bool SocketClient::Disconnect_() {
+
+  connection_lost_ = false;
+
   if (IsSocketValid_()) {
 
-    socket_->close();
+    {
+      std::unique_lock socket_lock(socket_mutex_);
+      socket_->close();
+      socket_.reset(nullptr);
+    }
 
-    socket_.reset(nullptr);
+    receive_buffer_.Clear();
+    ResetSequencing_();
+    OnConnectionReset_();
 
     return true;
   }
@@ -131,12 +190,219 @@ bool SocketClient::Disconnect() {
 
 //}
 
+/* reconnect() //{ */
+
+bool SocketClient::Reconnect() {
+  // supersedes a reconnect running in the background
+  return Reconnect_(CancelReconnect_());
+}
+
+bool SocketClient::Reconnect_(uint64_t generation) {
+
+  SetConnectionState_(ConnectionState::RECONNECTING);
+
+  const auto policy = reconnect_policy_;
+  auto       delay  = policy.initial_delay;
+
+  for (int attempt = 1;; attempt++) {
+
+    {
+      std::scoped_lock lock(request_mutex_);
+
+      // checked under the request lock, Disconnect() takes it after changing the generation
+      {
+        std::scoped_lock reconnect_lock(reconnect_mutex_);
+        if (generation != reconnect_generation_) {
+          return false;
+        }
+      }
+
+      if (Connect_() == socket_status::valid && RestoreSession_()) {
+        SetConnectionState_(ConnectionState::CONNECTED);
+        return true;
+      }
+
+      Disconnect_();
+    }
+
+    if (policy.max_attempts > 0 && attempt >= policy.max_attempts) {
+      std::cerr << "SOCKET-CLIENT reconnect to " << address_ << ":" << port_ << " failed " << attempt << " times, giving up" << std::endl;
+      SetConnectionState_(ConnectionState::DEAD);
+      return false;
+    }
+
+    std::unique_lock lock(reconnect_mutex_);
+
+    // the random part of the delay spreads the clients which lost the connection at the same moment
+    const auto jitter = std::clamp(policy.jitter, 0.0, 1.0);
+    const auto factor = 1.0 - jitter * std::uniform_real_distribution<double>(0.0, 1.0)(reconnect_random_);
+    const auto wait   = std::chrono::duration_cast<std::chrono::milliseconds>(delay * factor);
+
+    if (reconnect_condition_.wait_for(lock, wait, [&] { return generation != reconnect_generation_; })) {
+      return false;
+    }
+
+    delay = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(delay * policy.multiplier), policy.max_delay);
+  }
+}
+
+//}
+
+/* reconnectAll() //{ */
+
+size_t SocketClient::ReconnectAll(const std::vector<SocketClient*>& clients) {
+
+  std::vector<std::future<bool>> results;
+  results.reserve(clients.size());
+
+  // not on the I/O threads, which may be running the automatic reconnects, Reconnect() cancels them instead of queueing behind them
+  for (auto* client : clients) {
+    results.push_back(std::async(std::launch::async, [client] { return client->Reconnect(); }));
+  }
+
+  size_t connected = 0;
+
+  for (auto& result : results) {
+    connected += result.get() ? 1 : 0;
+  }
+
+  return connected;
+}
+
+//}
+
+/* restoreSession_() //{ */
+
+bool SocketClient::RestoreSession_() {
+
+  if (negotiated_frame_mode_ != FrameMode::SENTINEL && !NegotiateFrameMode(negotiated_api_version_, negotiated_frame_mode_)) {
+    return false;
+  }
+
+  if (negotiated_compression_.enabled && !NegotiateCompression(negotiated_api_version_, negotiated_compression_)) {
+    return false;
+  }
+
+  return OnReconnected_();
+}
+
+//}
+
+/* cancelReconnect_() //{ */
+
+uint64_t SocketClient::CancelReconnect_() {
+
+  uint64_t generation = 0;
+
+  {
+    std::scoped_lock lock(reconnect_mutex_);
+    generation = ++reconnect_generation_;
+  }
+
+  reconnect_condition_.notify_all();
+
+  return generation;
+}
+
+//}
+
+/* onConnectionLost_() //{ */
+
+void SocketClient::OnConnectionLost_() {
+
+  connection_lost_ = false;
+
+  // a failure while reconnecting is handled by the reconnect itself
+  if (connection_state_ != ConnectionState::CONNECTED) {
+    return;
+  }
+
+  Disconnect_();
+
+  if (!reconnect_policy_.automatic) {
+    SetConnectionState_(ConnectionState::DISCONNECTED);
+    return;
+  }
+
+  std::cerr << "SOCKET-CLIENT connection to " << address_ << ":" << port_ << " lost, reconnecting" << std::endl;
+
+  SetConnectionState_(ConnectionState::RECONNECTING);
+
+  uint64_t generation = 0;
+
+  {
+    std::scoped_lock lock(reconnect_mutex_);
+    generation = reconnect_generation_;
+  }
+
+  // the request which found the connection lost returns right away, the I/O thread waits for the server
+  async_worker_.Post([this, generation] { Reconnect_(generation); });
+}
+
+//}
+
+/* setConnectionState_() //{ */
+
+void SocketClient::SetConnectionState_(ConnectionState state) {
+
+  if (connection_state_.exchange(state) == state) {
+    return;
+  }
+
+  std::function<void(ConnectionState)> callback;
+
+  {
+    std::scoped_lock lock(reconnect_mutex_);
+    callback = connection_state_callback_;
+  }
+
+  if (callback) {
+    callback(state);
+  }
+}
+
+//}
+
 /* sendMessage() //{ */
 
-std::tuple<uint32_t, socket_status> SocketClient::SendMessage_(const std::byte* buffer, uint32_t size) const {
+std::tuple<uint32_t, socket_status> SocketClient::SendMessage_(const std::byte* buffer, uint32_t size, unsigned short type) {
 
   if (IsSocketValid_() && IsReadyToSend_()) {
+
+    const auto header_size = FrameHeaderSize_();
+
+    // the frame is sent compressed only if it gets smaller, the header keeps the sequence id
+    if (compression_.enabled && header_size > 0 && size - header_size >= compression_.threshold) {
+
+      compress_buffer_.resize(std::max(compress_buffer_.size(), static_cast<size_t>(size)));
+
+      const auto compressed_size = CompressPayload(std::span<const std::byte>(buffer + header_size, size - header_size),
+                                                   std::span<std::byte>(compress_buffer_).subspan(header_size), compression_.acceleration);
+
+      if (compressed_size > 0) {
+        std::memcpy(compress_buffer_.data(), buffer, header_size);
+        WriteFrameHeader(compress_buffer_.data(), static_cast<uint32_t>(compressed_size) | FRAME_COMPRESSED_FLAG);
+        buffer = compress_buffer_.data();
+        size   = static_cast<uint32_t>(header_size + compressed_size);
+      }
+    }
+
     const auto [res_size, res_status] = socket_->send(buffer, size);
+
+    if (res_status != socket_status::valid) {
+      connection_lost_ = true;
+    }
+
+    // the frame was serialized with next_sequence_, it now waits for its response
+    if (frame_mode_ == FrameMode::SEQUENCED && res_status == socket_status::valid && res_size > 0) {
+      last_sequence_ = next_sequence_;
+      in_flight_.push_back({last_sequence_, type});
+
+      if (++next_sequence_ == 0) {
+        next_sequence_ = 1;
+      }
+    }
+
     return std::make_tuple(res_size, res_status);
   }
 
@@ -145,26 +411,64 @@ std::tuple<uint32_t, socket_status> SocketClient::SendMessage_(const std::byte*
 
 //}
 
+/* sendSerialized_() //{ */
+
+std::tuple<uint32_t, socket_status> SocketClient::SendSerialized_(unsigned short type, Clock::time_point serialize_start, const std::byte* buffer,
+                                                                  uint32_t size) {
+
+  const auto measured            = metrics_.IsEnabled();
+  const auto send_start          = measured ? Clock::now() : Clock::time_point{};
+  const auto [sent_size, status] = SendMessage_(buffer, size, type);
+
+  if (recorder_ && status == socket_status::valid && sent_size > 0) {
+    const auto header_size = FrameHeaderSize_();
+    recorder_->Append(port_, CaptureDirection::REQUEST, frame_mode_ == FrameMode::SEQUENCED ? last_sequence_ : 0, sent_size,
+                      std::span<const std::byte>(buffer + header_size, size - header_size));
+  }
+
+  if (!measured) {
+    return std::make_tuple(sent_size, status);
+  }
+
+  // the metrics were enabled during the serialization
+  if (serialize_start != Clock::time_point{}) {
+    metrics_.RecordStage(type, RequestStage::SERIALIZE, send_start - serialize_start);
+  }
+
+  if (status == socket_status::valid && sent_size > 0) {
+    metrics_.RecordStage(type, RequestStage::SEND, Clock::now() - send_start);
+    metrics_.RecordRequest(type, sent_size);
+  }
+
+  return std::make_tuple(sent_size, status);
+}
+
+//}
+
 /* receiveMessage() //{ */
 
 std::tuple<uint32_t, socket_status> SocketClient::ReceiveMessage() {
+  return ReceiveMessage_(DefaultDeadline_());
+}
+
+std::tuple<uint32_t, socket_status> SocketClient::ReceiveMessage_(Deadline deadline) {
 
   if (IsSocketValid_()) {
 
-    auto select_status = socket_->select(kissnet::fds_read, 1000);
+    const auto wait_status = WaitReadable_(deadline);
 
-    if (select_status.get_value() == socket_status::timed_out) {
-      return std::make_tuple(0, select_status);
+    if (wait_status != RequestStatus::OK) {
+      return std::make_tuple(0, wait_status == RequestStatus::TIMEOUT ? socket_status::timed_out : socket_status::errored);
     }
 
-    auto buffer               = std::make_unique<kissnet::buffer<BUFFER_SIZE>>();
-    const auto [size, status] = socket_->recv(*buffer);
-
-    // TODO any faster solution?
-    auto cropped_buffer = std::make_unique<std::vector<std::byte>>(buffer->data(), buffer->data() + size);
+    // recv() writes straight into the reused receive buffer
+    const auto writable       = receive_buffer_.PrepareWrite(std::max<size_t>(BUFFER_SIZE, socket_->bytes_available()));
+    const auto [size, status] = socket_->recv(writable.data(), writable.size(), false);
 
     if (status == socket_status::valid) {
-      PushToInQueue_(std::move(cropped_buffer));
+      receive_buffer_.Commit(size);
+    } else if (status != socket_status::non_blocking_would_have_blocked) {
+      connection_lost_ = true;
     }
 
     return std::make_tuple(size, status);
@@ -175,32 +479,449 @@ std::tuple<uint32_t, socket_status> SocketClient::ReceiveMessage() {
 
 //}
 
+/* waitReadable_() //{ */
+
+RequestStatus SocketClient::WaitReadable_(Deadline deadline) {
+
+  while (true) {
+
+    int64_t wait_ms = RECEIVE_POLL_INTERVAL_MS;
+    bool    expired = false;
+
+    if (deadline != NO_DEADLINE) {
+      const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+
+      // past the deadline the data already received is still taken, select() just does not wait
+      expired = remaining <= 0;
+      wait_ms = std::clamp<int64_t>(remaining, 0, wait_ms);
+    }
+
+    const auto select_status = socket_->select(kissnet::fds_read, wait_ms);
+
+    if (select_status.get_value() == socket_status::valid) {
+
+      if (awaiting_first_byte_) {
+        first_byte_time_     = Clock::now();
+        awaiting_first_byte_ = false;
+      }
+
+      return RequestStatus::OK;
+    }
+
+    if (select_status.get_value() != socket_status::timed_out) {
+      connection_lost_ = true;
+      return RequestStatus::RECEIVE_FAILED;
+    }
+
+    if (expired) {
+      return RequestStatus::TIMEOUT;
+    }
+  }
+}
+
+//}
+
 /* getMessage() //{ */
 
-bool SocketClient::GetMessage(std::string& message) {
+RequestStatus SocketClient::GetMessage(std::span<const std::byte>& message, Deadline deadline) {
+
+  if (frame_mode_ == FrameMode::LENGTH_PREFIXED || frame_mode_ == FrameMode::SEQUENCED) {
+    return GetFramedMessage_(message, deadline);
+  }
+
+  return GetSentinelMessage_(message, deadline);
+}
+
+//}
+
+/* receiveResponse_() //{ */
+
+RequestStatus SocketClient::ReceiveResponse_(unsigned short type, uint32_t sequence, std::span<const std::byte>& message, Deadline deadline) {
+
+  const auto measured = metrics_.IsEnabled();
+  const auto start    = measured ? Clock::now() : Clock::time_point{};
+
+  // the wait stays zero if the response is already buffered
+  first_byte_time_     = start;
+  awaiting_first_byte_ = measured;
+
+  const auto status = sequence != 0 ? GetSequencedMessage_(sequence, message, deadline) : GetMessage(message, deadline);
+
+  awaiting_first_byte_ = false;
+
+  if (recorder_ && status == RequestStatus::OK) {
+    // the sentinel framing leaves its terminator in the message
+    const auto terminator = frame_mode_ == FrameMode::SENTINEL ? std::min<size_t>(END_OF_MESSAGE_LENGTH, message.size()) : 0;
+    recorder_->Append(port_, CaptureDirection::RESPONSE, sequence, static_cast<uint32_t>(received_frame_size_),
+                      message.first(message.size() - terminator));
+  }
+
+  if (measured && status == RequestStatus::OK) {
+    metrics_.RecordStage(type, RequestStage::WAIT, first_byte_time_ - start);
+    metrics_.RecordStage(type, RequestStage::RECEIVE, Clock::now() - first_byte_time_);
+    metrics_.RecordResponse(type, received_frame_size_);
+  }
+
+  return status;
+}
+
+//}
+
+/* inFlightType_() //{ */
+
+unsigned short SocketClient::InFlightType_(uint32_t sequence) const {
+
+  const auto in_flight =
+      std::find_if(in_flight_.begin(), in_flight_.end(), [sequence](const InFlightRequest& request) { return request.sequence == sequence; });
+
+  return in_flight != in_flight_.end() ? in_flight->type : METRICS_UNKNOWN_TYPE;
+}
+
+//}
+
+/* releaseMessage_() //{ */
+
+void SocketClient::ReleaseMessage_() {
+
+  // the message was handed out from a parked copy, its slot can be reused
+  if (released_parked_ != nullptr) {
+    released_parked_->sequence = 0;
+    released_parked_           = nullptr;
+    return;
+  }
+
+  receive_buffer_.Consume(message_size_);
+  message_size_ = 0;
+}
+
+//}
+
+/* getSentinelMessage_() //{ */
+
+RequestStatus SocketClient::GetSentinelMessage_(std::span<const std::byte>& message, Deadline deadline) {
 
   while (true) {
 
-    const auto [receive_size, receive_status] = ReceiveMessage();
+    const auto [receive_size, receive_status] = ReceiveMessage_(deadline);
+
+    // the part received so far stays buffered, the rest of the late response completes it
+    if (receive_status == socket_status::timed_out) {
+      return RequestStatus::TIMEOUT;
+    }
 
     if (!receive_size || receive_status == 0) {
-      ClearInQueue_();
-      return false;
+      receive_buffer_.Clear();
+      return RequestStatus::RECEIVE_FAILED;
     }
 
-    const auto  data_pointer = PopFromInQueue_();
-    const auto  chunk        = reinterpret_cast<const char*>(data_pointer->data());
-    std::string chunk_str(chunk, receive_size);
-    message += chunk_str;
+    const auto data = receive_buffer_.Readable();
+    const auto size = data.size();
 
-    if (socket_->bytes_available() == 0 && message[message.size() - 1] == END_OF_MESSAGE && message[message.size() - 2] == END_OF_MESSAGE && message[message.size() - 3] == END_OF_MESSAGE) {
-      // std::cout << "received: "<< message[message.size()-1] << std::endl;
+    if (socket_->bytes_available() == 0 && size >= END_OF_MESSAGE_LENGTH && data[size - 1] == std::byte{END_OF_MESSAGE} &&
+        data[size - 2] == std::byte{END_OF_MESSAGE} && data[size - 3] == std::byte{END_OF_MESSAGE}) {
+      message              = data;
+      message_size_        = size;
+      received_frame_size_ = size;
       break;
     }
   }
 
-  ClearInQueue_();
-  return !message.empty();
+  return message.empty() ? RequestStatus::RECEIVE_FAILED : RequestStatus::OK;
+}
+
+//}
+
+/* getFramedMessage_() //{ */
+
+RequestStatus SocketClient::GetFramedMessage_(std::span<const std::byte>& message, Deadline deadline) {
+
+  const auto header_size = FrameHeaderSize_();
+
+  if (!IsSocketValid_()) {
+    receive_buffer_.Clear();
+    return RequestStatus::RECEIVE_FAILED;
+  }
+
+  // after a timeout the partial frame stays buffered, the frame boundaries are kept for the next read
+  auto status = FillReceiveBuffer_(header_size, deadline);
+  if (status != RequestStatus::OK) {
+    return status;
+  }
+
+  const auto header       = receive_buffer_.Readable().data();
+  const auto frame_size   = ReadFrameHeader(header);
+  const auto compressed   = (frame_size & FRAME_COMPRESSED_FLAG) != 0;
+  const auto payload_size = frame_size & ~FRAME_COMPRESSED_FLAG;
+  if (payload_size == 0 || payload_size > MAX_FRAME_SIZE) {
+    std::cerr << "SOCKET-CLIENT invalid frame size " << payload_size << ", disconnecting" << std::endl;
+    Disconnect_();
+    connection_lost_ = true;
+    return RequestStatus::RECEIVE_FAILED;
+  }
+
+  received_sequence_ = frame_mode_ == FrameMode::SEQUENCED ? ReadFrameHeader(header + FRAME_HEADER_SIZE) : 0;
+
+  status = FillReceiveBuffer_(header_size + payload_size, deadline);
+  if (status != RequestStatus::OK) {
+    return status;
+  }
+
+  message              = receive_buffer_.Readable().subspan(header_size, payload_size);
+  message_size_        = header_size + payload_size;
+  received_frame_size_ = message_size_;
+
+  if (compressed) {
+
+    // decompressed into the reused buffer and deserialized from there, the frame itself is released right away
+    const auto original_size = CompressedPayloadSize(message);
+
+    if (original_size > 0 && original_size <= MAX_FRAME_SIZE) {
+      decompress_buffer_.resize(std::max(decompress_buffer_.size(), static_cast<size_t>(original_size)));
+    }
+
+    const auto decompressed = std::span<std::byte>(decompress_buffer_).first(std::min<size_t>(original_size, decompress_buffer_.size()));
+
+    if (original_size == 0 || decompressed.size() != original_size ||
+        !Lz4Decompress(message.subspan(COMPRESSED_PAYLOAD_HEADER_SIZE), decompressed)) {
+      std::cerr << "SOCKET-CLIENT invalid compressed frame of " << payload_size << " bytes, disconnecting" << std::endl;
+      Disconnect_();
+      connection_lost_ = true;
+      return RequestStatus::RECEIVE_FAILED;
+    }
+
+    receive_buffer_.Consume(message_size_);
+    message_size_ = 0;
+    message       = decompressed;
+  }
+
+  return RequestStatus::OK;
+}
+
+//}
+
+/* getSequencedMessage_() //{ */
+
+RequestStatus SocketClient::GetSequencedMessage_(uint32_t sequence, std::span<const std::byte>& message, Deadline deadline) {
+
+  const auto in_flight =
+      std::find_if(in_flight_.begin(), in_flight_.end(), [sequence](const InFlightRequest& request) { return request.sequence == sequence; });
+
+  if (sequence == 0 || in_flight == in_flight_.end()) {
+    return RequestStatus::RECEIVE_FAILED;
+  }
+
+  // also on a timeout, the late response then belongs to nobody and is dropped
+  in_flight_.erase(in_flight);
+
+  // the response may have arrived while waiting for an earlier one
+  for (auto& parked : parked_) {
+    if (parked.sequence == sequence) {
+      message              = parked.payload;
+      released_parked_     = &parked;
+      received_frame_size_ = parked.payload.size() + FrameHeaderSize_();
+      return RequestStatus::OK;
+    }
+  }
+
+  while (true) {
+
+    const auto status = GetFramedMessage_(message, deadline);
+    if (status != RequestStatus::OK) {
+      return status;
+    }
+
+    if (received_sequence_ == sequence) {
+      return RequestStatus::OK;
+    }
+
+    RouteFrame_(message);
+    ReleaseMessage_();
+  }
+}
+
+//}
+
+/* routeFrame_() //{ */
+
+void SocketClient::RouteFrame_(std::span<const std::byte> message) {
+
+  if (received_sequence_ == 0) {
+    if (recorder_) {
+      recorder_->Append(port_, CaptureDirection::PUSH, 0, static_cast<uint32_t>(received_frame_size_), message);
+    }
+    OnPushMessage_(message);
+    return;
+  }
+
+  // a response of another in-flight request, keep a copy until it is collected, frames nobody waits for are dropped
+  const auto owner = std::find_if(in_flight_.begin(), in_flight_.end(),
+                                  [this](const InFlightRequest& request) { return request.sequence == received_sequence_; });
+
+  if (owner == in_flight_.end()) {
+    return;
+  }
+
+  auto slot = std::find_if(parked_.begin(), parked_.end(), [](const ParkedResponse& parked) { return parked.sequence == 0; });
+
+  if (slot == parked_.end()) {
+    parked_.emplace_back();
+    slot = parked_.end() - 1;
+  }
+
+  slot->sequence = received_sequence_;
+  slot->payload.assign(message.begin(), message.end());
+}
+
+//}
+
+/* drainStaleResponses_() //{ */
+
+RequestStatus SocketClient::DrainStaleResponses_(Deadline deadline) {
+
+  // without sequence ids the responses are told apart only by their order, the late ones come first
+  while (stale_responses_ > 0) {
+
+    std::span<const std::byte> message;
+    const auto                 status = GetMessage(message, deadline);
+
+    if (status != RequestStatus::OK) {
+      return status;
+    }
+
+    ReleaseMessage_();
+    stale_responses_--;
+  }
+
+  return RequestStatus::OK;
+}
+
+//}
+
+/* resetSequencing_() //{ */
+
+void SocketClient::ResetSequencing_() {
+
+  in_flight_.clear();
+  last_sequence_     = 0;
+  received_sequence_ = 0;
+  released_parked_   = nullptr;
+  stale_responses_   = 0;
+
+  for (auto& parked : parked_) {
+    parked.sequence = 0;
+  }
+}
+
+//}
+
+/* fillReceiveBuffer_() //{ */
+
+RequestStatus SocketClient::FillReceiveBuffer_(size_t size, Deadline deadline) {
+
+  while (receive_buffer_.ReadableSize() < size) {
+
+    const auto wait_status = WaitReadable_(deadline);
+
+    if (wait_status == RequestStatus::RECEIVE_FAILED) {
+      receive_buffer_.Clear();
+    }
+
+    if (wait_status != RequestStatus::OK) {
+      return wait_status;
+    }
+
+    const auto writable             = receive_buffer_.PrepareWrite(size - receive_buffer_.ReadableSize());
+    const auto [chunk_size, status] = socket_->recv(writable.data(), writable.size(), false);
+
+    if (status == socket_status::non_blocking_would_have_blocked) {
+      continue;
+    }
+
+    if (status != socket_status::valid) {
+      receive_buffer_.Clear();
+      connection_lost_ = true;
+      return RequestStatus::RECEIVE_FAILED;
+    }
+
+    receive_buffer_.Commit(chunk_size);
+  }
+
+  return RequestStatus::OK;
+}
+
+//}
+
+/* startPushReceiver_() //{ */
+
+void SocketClient::StartPushReceiver_() {
+
+  std::scoped_lock lock(push_receiver_mutex_);
+
+  if (push_receiver_.joinable()) {
+    return;
+  }
+
+  push_receiving_ = true;
+  push_receiver_  = std::thread(&SocketClient::RunPushReceiver_, this);
+}
+
+//}
+
+/* runPushReceiver_() //{ */
+
+void SocketClient::RunPushReceiver_() {
+
+  while (push_receiving_) {
+
+    bool receiving = false;
+
+    {
+      std::scoped_lock lock(request_mutex_);
+      receiving = frame_mode_ == FrameMode::SEQUENCED && IsSocketValid_();
+    }
+
+    bool readable = false;
+
+    if (receiving) {
+      std::shared_lock lock(socket_mutex_);
+      readable = socket_ != nullptr && socket_->select(kissnet::fds_read, PUSH_POLL_INTERVAL_MS).get_value() != socket_status::timed_out;
+    } else {
+      std::unique_lock lock(push_receiver_mutex_);
+      push_receiver_condition_.wait_for(lock, std::chrono::milliseconds(PUSH_POLL_INTERVAL_MS), [this] { return !push_receiving_; });
+    }
+
+    // a request waiting for its response holds the lock, the data is then usually consumed by it
+    if (readable) {
+      std::scoped_lock lock(request_mutex_);
+
+      if (frame_mode_ == FrameMode::SEQUENCED && IsSocketValid_()) {
+        DrainPushes_();
+      }
+
+      if (connection_lost_) {
+        OnConnectionLost_();
+      }
+    }
+
+    OnPushesReceived_();
+  }
+}
+
+//}
+
+/* drainPushes_() //{ */
+
+void SocketClient::DrainPushes_() {
+
+  // only the frames which already arrived, a partial one stays buffered
+  const auto deadline = Clock::now();
+
+  std::span<const std::byte> message;
+
+  while (GetFramedMessage_(message, deadline) == RequestStatus::OK) {
+    RouteFrame_(message);
+    ReleaseMessage_();
+  }
 }
 
 //}
@@ -218,3 +939,95 @@ bool SocketClient::Ping() {
 }
 
 //}
+
+/* setTracer() //{ */
+
+void SocketClient::SetTracer(std::shared_ptr<RequestTracer> tracer) {
+
+  std::scoped_lock lock(request_mutex_);
+
+  if (tracer) {
+    tracer->RegisterConnection(port_, TraceLabel_() + " " + std::to_string(port_));
+  }
+
+  tracer_ = std::move(tracer);
+}
+
+//}
+
+/* setRecorder() //{ */
+
+void SocketClient::SetRecorder(std::shared_ptr<CaptureRecorder> recorder) {
+  std::scoped_lock lock(request_mutex_);
+  recorder_ = std::move(recorder);
+}
+
+//}
+
+/* negotiateFrameMode() //{ */
+
+bool SocketClient::NegotiateFrameMode(const std::pair<int, int>& api_version, FrameMode frame_mode) {
+
+  // the requests of the other threads must not be framed in the old mode after the switch
+  std::scoped_lock lock(request_mutex_);
+
+  if (frame_mode_ == frame_mode) {
+    return true;
+  }
+
+  if (frame_mode == FrameMode::SENTINEL || !SupportsFrameMode(api_version.first, api_version.second, frame_mode)) {
+    return false;
+  }
+
+  Serializable::Common::SetFrameMode::Request request{};
+  request.frame_mode = frame_mode;
+
+  // the reply still arrives in the current framing, both sides switch right after it
+  Serializable::Common::SetFrameMode::Response response{};
+  const auto                                   status = Request(request, response);
+
+  if (status && response.status) {
+    frame_mode_             = frame_mode;
+    negotiated_frame_mode_  = frame_mode;
+    negotiated_api_version_ = api_version;
+  }
+
+  return frame_mode_ == frame_mode;
+}
+
+//}
+
+/* negotiateCompression() //{ */
+
+bool SocketClient::NegotiateCompression(const std::pair<int, int>& api_version, const CompressionOptions& options) {
+
+  std::scoped_lock lock(request_mutex_);
+
+  if (!options.enabled && !compression_.enabled) {
+    return true;
+  }
+
+  if (frame_mode_ == FrameMode::SENTINEL || !SupportsCompression(api_version.first, api_version.second)) {
+    return false;
+  }
+
+  Serializable::Common::SetCompression::Request request{};
+  request.enable       = options.enabled;
+  request.threshold    = options.threshold;
+  request.acceleration = options.acceleration;
+
+  Serializable::Common::SetCompression::Response response{};
+  const auto                                     status = Request(request, response);
+
+  if (!status || !response.status) {
+    return false;
+  }
+
+  compression_            = options.enabled ? options : CompressionOptions{};
+  negotiated_compression_ = compression_;
+  negotiated_api_version_ = api_version;
+
+  return true;
+}
+
+//}
@@ -0,0 +1,69 @@
+// Copyright [2022] <Jakub Jirkal>
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <flight_forge_connector/transport.h>
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/* IsUnixSocketAddress() //{ */
+
+bool ueds_connector::IsUnixSocketAddress(const std::string& address) {
+  return address.rfind(UNIX_SOCKET_SCHEME, 0) == 0;
+}
+
+//}
+
+/* UnixSocketPath() //{ */
+
+std::string ueds_connector::UnixSocketPath(const std::string& address, uint16_t port) {
+
+  auto path = IsUnixSocketAddress(address) ? address.substr(std::strlen(UNIX_SOCKET_SCHEME)) : address;
+
+  const auto placeholder = path.find(UNIX_SOCKET_PORT_PLACEHOLDER);
+  if (placeholder != std::string::npos) {
+    path.replace(placeholder, std::strlen(UNIX_SOCKET_PORT_PLACEHOLDER), std::to_string(port));
+  }
+
+  return path;
+}
+
+//}
+
+/* ConnectUnixSocket() //{ */
+
+int ueds_connector::ConnectUnixSocket(const std::string& path) {
+
+#ifdef _WIN32
+  return -1;
+#else
+
+  sockaddr_un socket_address{};
+  socket_address.sun_family = AF_UNIX;
+
+  if (path.empty() || path.size() >= sizeof(socket_address.sun_path)) {
+    return -1;
+  }
+
+  std::memcpy(socket_address.sun_path, path.c_str(), path.size() + 1);
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+
+  return fd;
+#endif
+}
+
+//}